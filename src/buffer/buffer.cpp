@@ -1,25 +1,86 @@
 #include "buffer/buffer.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+
+#include "file/crc32c.h"
+
 namespace simpledb {
-void Buffer::SetModified(int txn_id, int lsn) noexcept {
-  txn_id_ = txn_id;
+std::atomic<int64_t> Buffer::checksum_failures_{0};
+std::atomic<bool> Buffer::checksums_enabled_{true};
+
+void Buffer::SetModified(int txn_id, Lsn lsn) {
+  if (std::find(modifying_txns_.begin(), modifying_txns_.end(), txn_id) ==
+      modifying_txns_.end()) {
+    modifying_txns_.push_back(txn_id);
+  }
   if (lsn >= 0) {
+    if (recovery_lsn_ == INVALID_LSN) {
+      recovery_lsn_ = lsn;
+    }
     lsn_ = lsn;
+    SetPageLsn(lsn);
   }
 }
 
+Lsn Buffer::PageLsn() const noexcept { return block_page_.GetLong(0); }
+
+void Buffer::SetPageLsn(Lsn lsn) noexcept { block_page_.SetLong(0, lsn); }
+
 void Buffer::AssignToBlock(const BlockId& block) {
   Flush();
   block_opt_ = block;
-  file_manager_.Read(block_opt_.value(), contents_);
+  file_manager_.Read(block_opt_.value(), block_page_);
   pin_count_ = 0;
+  if (checksums_enabled_ && !VerifyChecksum()) {
+    block_opt_.reset();
+    checksum_failures_++;
+    throw std::runtime_error("Checksum mismatch in " + block.ToString());
+  }
 }
 
 void Buffer::Flush() {
-  if (txn_id_ >= 0) {
-    log_manager_.Flush(lsn_);
-    file_manager_.Write(block_opt_.value(), contents_);
-    txn_id_ = -1;
+  std::shared_lock latch{latch_};
+  if (!modifying_txns_.empty()) {
+    WriteBack();
+  }
+}
+
+void Buffer::Flush(int txn_id) {
+  std::shared_lock latch{latch_};
+  if (std::find(modifying_txns_.begin(), modifying_txns_.end(), txn_id) !=
+      modifying_txns_.end()) {
+    WriteBack();
+  }
+}
+
+void Buffer::WriteBack() {
+  log_manager_.Flush(lsn_);
+  if (checksums_enabled_) {
+    block_page_.SetInt(CHECKSUM_OFFSET, static_cast<int>(Checksum()));
+  }
+  file_manager_.Write(block_opt_.value(), block_page_);
+  modifying_txns_.clear();
+  recovery_lsn_ = INVALID_LSN;
+}
+
+uint32_t Buffer::Checksum() const noexcept {
+  auto bytes = block_page_.Contents();
+  uint32_t crc = Crc32c(bytes.first(CHECKSUM_OFFSET));
+  return Crc32c(bytes.subspan(HEADER_SIZE), crc);
+}
+
+bool Buffer::VerifyChecksum() const noexcept {
+  auto stored = static_cast<uint32_t>(block_page_.GetInt(CHECKSUM_OFFSET));
+  if (stored == Checksum()) {
+    return true;
   }
+  // Only a block that no buffer has written can lack a checksum
+  auto bytes = block_page_.Contents();
+  return stored == 0 && std::all_of(bytes.begin(), bytes.end(),
+                                    [](char c) { return c == 0; });
 }
 }  // namespace simpledb
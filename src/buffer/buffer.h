@@ -1,6 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <optional>
+#include <shared_mutex>
+#include <string_view>
+#include <vector>
 
 #include "file/block_id.h"
 #include "file/file_manager.h"
@@ -11,8 +16,23 @@ namespace simpledb {
 /**
  * An individual buffer. A data buffer wraps a page and stores information about
  * its status, such as the associated disk block, the number of times the buffer
- * has been pinned, whether its contents have modified, and if so, the id and
- * lsn of the modifying transaction.
+ * has been pinned, whether its contents have modified, and if so, the ids of
+ * the modifying transactions and the lsn of the last modification.
+ *
+ * Every data block starts with a header that holds the page LSN, the LSN of
+ * the last logged update applied to the block. Recovery compares it with the
+ * LSNs of log records to skip updates that already reached the disk. Clients
+ * only see the bytes after the header through `Contents()`. The header also
+ * holds a CRC32C checksum of the rest of the block, written when the buffer is
+ * flushed and verified when a block is read, so that torn or corrupt blocks
+ * are detected before they are used.
+ *
+ * Each buffer has a latch that protects the page while it is read or changed.
+ * Locks keep transactions from seeing each other's uncommitted changes; the
+ * latch, held only for the duration of a single access, keeps a page from
+ * being flushed while it is half written. Writers hold it exclusively and
+ * readers and `Flush` hold it shared. A thread must not wait for the buffer
+ * manager while it holds a latch, since the buffer manager flushes buffers.
  */
 class Buffer {
  public:
@@ -24,15 +44,29 @@ class Buffer {
   Buffer(FileManager& file_manager, LogManager& log_manager)
       : file_manager_(file_manager),
         log_manager_(log_manager),
-        contents_(file_manager.BlockSize()) {}
+        block_page_(file_manager.BlockSize()),
+        contents_(block_page_.Contents().data() + HEADER_SIZE,
+                  file_manager.BlockSize() - HEADER_SIZE) {}
 
   /**
    * @brief Retrieve the in-memory page version of the disk block that this
-   * buffer holds
+   * buffer holds, excluding the block header
    * @return a reference to the page
    */
   Page& Contents() noexcept { return contents_; }
 
+  /**
+   * @brief Return the latch that protects the contents of the page
+   * @return a reference to the latch
+   */
+  std::shared_mutex& Latch() noexcept { return latch_; }
+
+  /**
+   * @brief Return the LSN of the last logged update applied to the page
+   * @return the page LSN
+   */
+  Lsn PageLsn() const noexcept;
+
   /**
    * @brief Return a `BlockId` object that represents a reference to the disk
    * block allocated to the buffer
@@ -42,12 +76,27 @@ class Buffer {
   std::optional<BlockId> Block() const noexcept { return block_opt_; }
 
   /**
-   * @brief Set the transaction id and the log sequence number to indicate
-   * that the page that this buffer holds has been modified
+   * @brief Return whether the buffer is assigned to the specified block,
+   * without copying its `BlockId`
+   * @param filename name of the file holding the block
+   * @param block_num block number within the file
+   * @return true if the buffer holds that block; otherwise, false
+   */
+  bool HoldsBlock(std::string_view filename, int block_num) const noexcept {
+    return block_opt_.has_value() &&
+           block_opt_->BlockNumber() == block_num &&
+           block_opt_->Filename() == filename;
+  }
+
+  /**
+   * @brief Add the transaction to the modifying transactions of the page and
+   * set the log sequence number, to indicate that the page that this buffer
+   * holds has been modified. A non-negative LSN also becomes the page LSN.
+   * The caller holds the latch exclusively.
    * @param txn_id transaction id
    * @param lsn log sequence number
    */
-  void SetModified(int txn_id, int lsn) noexcept;
+  void SetModified(int txn_id, Lsn lsn);
 
   /**
    * @brief Return whether the buffer is currently pinned
@@ -56,15 +105,21 @@ class Buffer {
   bool IsPinned() const noexcept { return pin_count_ > 0; }
 
   /**
-   * @brief Get the id of the transaction that modifies this page
-   * @return transaction id
+   * @brief Return the recovery LSN of the page, the LSN of the first logged
+   * update since the page was last written to disk. Redo never needs to look
+   * at log records older than it for this page.
+   * @return the recovery LSN, or `INVALID_LSN` if the page has no logged
+   * update that is not yet on disk. It may be read without the latch.
    */
-  int ModifyingTxn() const noexcept { return txn_id_; }
+  Lsn RecoveryLsn() const noexcept { return recovery_lsn_; }
 
   /**
    * @brief Read the contents of the specified block into the contents of the
    * buffer. If the buffer was dirty, then its previous contents are first
-   * written to disk.
+   * written to disk. A block whose checksum does not match its contents is
+   * counted as a checksum failure and rejected with an exception, leaving the
+   * buffer unassigned. Blocks that were never written by a buffer, such as
+   * freshly appended ones, are all zeros and have no checksum.
    * @param block a reference to some disk block
    */
   void AssignToBlock(const BlockId& block);
@@ -74,6 +129,14 @@ class Buffer {
    */
   void Flush();
 
+  /**
+   * @brief Write the buffer to its disk block if the specified transaction
+   * has modified it since it was last written, even if other transactions
+   * modified it too
+   * @param txn_id id of the modifying transaction
+   */
+  void Flush(int txn_id);
+
   /**
    * @brief Pin a page, indicating that it should not be used for other disk
    * blocks
@@ -86,13 +149,70 @@ class Buffer {
    */
   void Unpin() noexcept { pin_count_--; }
 
+  /**
+   * @brief Return the number of blocks read from disk whose checksum did not
+   * match their contents
+   * @return the number of checksum failures
+   */
+  static int64_t ChecksumFailures() noexcept { return checksum_failures_; }
+
+  /**
+   * @brief Choose whether buffers checksum the blocks they write and verify
+   * the blocks they read. Turning checksums off is meant for measuring their
+   * cost: blocks written without a checksum fail verification once checksums
+   * are turned back on.
+   * @param enabled true to write and verify checksums, false to skip both
+   */
+  static void SetChecksums(bool enabled) noexcept {
+    checksums_enabled_ = enabled;
+  }
+
+  // Number of bytes at the start of each data block reserved for the header:
+  // the page LSN followed by the checksum
+  static constexpr int HEADER_SIZE = sizeof(Lsn) + sizeof(uint32_t);
+
  private:
+  /**
+   * @brief Record the LSN of the last logged update applied to the page
+   * @param lsn the page LSN
+   */
+  void SetPageLsn(Lsn lsn) noexcept;
+
+  /**
+   * @brief Write the dirty buffer to its disk block. The caller holds the
+   * latch.
+   */
+  void WriteBack();
+
+  /**
+   * @brief Compute the checksum of the block, skipping the checksum field
+   * @return the checksum of the block
+   */
+  uint32_t Checksum() const noexcept;
+
+  /**
+   * @brief Return whether the block read into the buffer is intact
+   * @return true if its checksum matches, or if it was never written by a
+   * buffer
+   */
+  bool VerifyChecksum() const noexcept;
+
+  static constexpr int CHECKSUM_OFFSET = sizeof(Lsn);
+  static std::atomic<int64_t> checksum_failures_;
+  static std::atomic<bool> checksums_enabled_;
+
   FileManager& file_manager_;
   LogManager& log_manager_;
-  Page contents_;
+  Page block_page_;  // the whole disk block, including the header
+  Page contents_;    // a view of the block after the header
   std::optional<BlockId> block_opt_;
   int pin_count_{};
-  int txn_id_{-1};
-  int lsn_{-1};
+  // The transactions that modified the page since it was last written,
+  // rarely more than a few. The page is dirty if there is any.
+  std::vector<int> modifying_txns_;
+  Lsn lsn_{INVALID_LSN};
+  // Atomic, since the dirty page table reads it without the latch
+  std::atomic<Lsn> recovery_lsn_{INVALID_LSN};
+  std::shared_mutex latch_;
 };
 }  // namespace simpledb
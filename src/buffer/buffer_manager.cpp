@@ -1,7 +1,12 @@
 #include "buffer/buffer_manager.h"
 
+#include <exception>
+#include <functional>
 #include <mutex>  // NOLINT(build/c++11)
 #include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include "file/block_id.h"
 #include "file/file_manager.h"
@@ -11,7 +16,6 @@ namespace simpledb {
 BufferManager::BufferManager(FileManager& file_manager, LogManager& log_manager,
                              int num_buffs)
     : num_available_(num_buffs) {
-  buffer_pool_.reserve(num_buffs);
   for (int i = 0; i < num_buffs; i++) {
     buffer_pool_.emplace_back(file_manager, log_manager);
   }
@@ -25,10 +29,29 @@ int BufferManager::Available() const {
 void BufferManager::FlushAll(int txn_id) {
   std::scoped_lock lock{mutex_};
   for (auto& buffer : buffer_pool_) {
-    if (buffer.ModifyingTxn() == txn_id) {
-      buffer.Flush();
+    buffer.Flush(txn_id);
+  }
+}
+
+void BufferManager::FlushAll() {
+  std::scoped_lock lock{mutex_};
+  for (auto& buffer : buffer_pool_) {
+    buffer.Flush();
+  }
+}
+
+std::vector<std::pair<BlockId, Lsn>> BufferManager::DirtyPageTable() const {
+  std::scoped_lock lock{mutex_};
+  std::vector<std::pair<BlockId, Lsn>> dirty_pages;
+  for (const auto& buffer : buffer_pool_) {
+    // Writers set the recovery LSN under the buffer's latch, not the mutex
+    Lsn recovery_lsn = buffer.RecoveryLsn();
+    if (recovery_lsn != INVALID_LSN) {
+      dirty_pages.emplace_back(buffer.Block().value(), recovery_lsn);
     }
   }
+
+  return dirty_pages;
 }
 
 void BufferManager::Unpin(Buffer* buffer) {
@@ -40,14 +63,50 @@ void BufferManager::Unpin(Buffer* buffer) {
   }
 }
 
-Buffer* BufferManager::Pin(const BlockId& block) {
+void BufferManager::SetPageRecovery(
+    std::function<void(Buffer&)> page_recovery) {
+  std::scoped_lock lock{mutex_};
+  page_recovery_ = std::move(page_recovery);
+}
+
+Buffer* BufferManager::Pin(std::string_view filename, int block_num) {
   std::unique_lock lock{mutex_};
   auto timestamp = system_clock::now();
-  auto buffer = TryToPin(block);
+  bool assigned = false;
+  auto buffer = TryToPin(filename, block_num, assigned);
 
   while (buffer == nullptr && !WaitingTooLong(timestamp)) {
     cv_.wait_for(lock, MAX_TIME);
-    buffer = TryToPin(block);
+    buffer = TryToPin(filename, block_num, assigned);
+  }
+  if (buffer == nullptr) {
+    return nullptr;
+  }
+
+  if (assigned && page_recovery_) {
+    // Recovery may read the log, so it runs without blocking other pins
+    auto page_recovery = page_recovery_;
+    recovering_.insert(buffer);
+    lock.unlock();
+    std::exception_ptr error;
+    try {
+      std::scoped_lock latch{buffer->Latch()};
+      page_recovery(*buffer);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    lock.lock();
+    recovering_.erase(buffer);
+    cv_.notify_all();
+    if (error) {
+      buffer->Unpin();
+      if (!buffer->IsPinned()) {
+        num_available_++;
+      }
+      std::rethrow_exception(error);
+    }
+  } else {
+    cv_.wait(lock, [this, buffer] { return !recovering_.contains(buffer); });
   }
 
   return buffer;
@@ -59,14 +118,16 @@ bool BufferManager::WaitingTooLong(
          MAX_TIME;
 }
 
-Buffer* BufferManager::TryToPin(const BlockId& block) {
-  auto buffer = FindExistingBuffer(block);
+Buffer* BufferManager::TryToPin(std::string_view filename, int block_num,
+                                bool& assigned) {
+  auto buffer = FindExistingBuffer(filename, block_num);
   if (buffer == nullptr) {
     buffer = ChooseUnpinnedBuffer();
     if (buffer == nullptr) {
       return nullptr;
     }
-    buffer->AssignToBlock(block);
+    buffer->AssignToBlock(BlockId{filename, block_num});
+    assigned = true;
   }
 
   if (!buffer->IsPinned()) {
@@ -77,10 +138,10 @@ Buffer* BufferManager::TryToPin(const BlockId& block) {
   return buffer;
 }
 
-Buffer* BufferManager::FindExistingBuffer(const BlockId& block) noexcept {
+Buffer* BufferManager::FindExistingBuffer(std::string_view filename,
+                                          int block_num) noexcept {
   for (auto& buffer : buffer_pool_) {
-    std::optional<BlockId> block_opt = buffer.Block();
-    if (block_opt.has_value() && block_opt.value() == block) {
+    if (buffer.HoldsBlock(filename, block_num)) {
       return &buffer;
     }
   }
@@ -2,7 +2,12 @@
 
 #include <chrono>              // NOLINT(build/c++11)
 #include <condition_variable>  // NOLINT(build/c++11)
+#include <deque>
+#include <functional>
 #include <mutex>               // NOLINT(build/c++11)
+#include <string_view>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "buffer/buffer.h"
@@ -33,11 +38,24 @@ class BufferManager {
   int Available() const;
 
   /**
-   * @brief Flush the dirty buffers modified by the specified transaction
+   * @brief Flush the dirty buffers modified by the specified transaction,
+   * including those that other transactions modified after it
    * @param txn_id id of the modifying transaction
    */
   void FlushAll(int txn_id);
 
+  /**
+   * @brief Flush every dirty buffer, regardless of the modifying transaction
+   */
+  void FlushAll();
+
+  /**
+   * @brief Return the dirty page table: every buffered block with a logged
+   * update that has not reached the disk, along with its recovery LSN
+   * @return the blocks and their recovery LSNs
+   */
+  std::vector<std::pair<BlockId, Lsn>> DirtyPageTable() const;
+
   /**
    * @brief Unpin the specified data buffer. If its pin count goes to zero, then
    * notify any waiting threads.
@@ -45,6 +63,17 @@ class BufferManager {
    */
   void Unpin(Buffer* buffer);
 
+  /**
+   * @brief Install a function that recovers a block when it is read from disk
+   * into a buffer, before the buffer is handed out. Restart recovery uses it
+   * to redo pages on demand. The function runs without the buffer manager
+   * locked, holding the buffer's latch exclusively, so it must not pin or
+   * unpin buffers; other threads that pin the block meanwhile wait until it
+   * returns. If it throws, the pin fails with its exception.
+   * @param page_recovery the function, or an empty function to remove it
+   */
+  void SetPageRecovery(std::function<void(Buffer&)> page_recovery);
+
   /**
    * @brief Pin a buffer to the specfied block, potentially waiting until a
    * buffer becomes available. If no buffer becomes available within a fixed
@@ -53,7 +82,18 @@ class BufferManager {
    * @param block a reference to a disk block
    * @return the buffer pinned to that block
    */
-  Buffer* Pin(const BlockId& block);
+  Buffer* Pin(const BlockId& block) {
+    return Pin(block.Filename(), block.BlockNumber());
+  }
+
+  /**
+   * @brief Pin a buffer to the specified block, like `Pin(const BlockId&)`,
+   * without building a `BlockId` unless the block has to be read from disk
+   * @param filename name of the file holding the block
+   * @param block_num block number within the file
+   * @return the buffer pinned to that block
+   */
+  Buffer* Pin(std::string_view filename, int block_num);
 
  private:
   /**
@@ -70,17 +110,22 @@ class BufferManager {
    * buffer assigned to that block then that buffer is used; otherwise, an
    * unpinned buffer from the pool is chosen. Return a null pointer if there are
    * no available buffers.
-   * @param block a reference to a disk block
+   * @param filename name of the file holding the block
+   * @param block_num block number within the file
+   * @param assigned set to whether the block was read into the buffer
    * @return the pinned buffer
    */
-  Buffer* TryToPin(const BlockId& block);
+  Buffer* TryToPin(std::string_view filename, int block_num,
+                   bool& assigned);
 
   /**
    * @brief Find a buffer that is already assigned to the specifed block
-   * @param block a reference to the block that some buffer may be pinned to it
+   * @param filename name of the file holding the block
+   * @param block_num block number within the file
    * @return the pinned buffer
    */
-  Buffer* FindExistingBuffer(const BlockId& block) noexcept;
+  Buffer* FindExistingBuffer(std::string_view filename,
+                             int block_num) noexcept;
 
   /**
    * @brief Find an unpinned (available) buffer to allocate for some disk block
@@ -88,10 +133,14 @@ class BufferManager {
    */
   Buffer* ChooseUnpinnedBuffer() noexcept;
 
-  std::vector<Buffer> buffer_pool_;
+  // A deque, since buffers hold a latch and cannot be moved
+  std::deque<Buffer> buffer_pool_;
   int num_available_{};
   static constexpr milliseconds MAX_TIME = 10000ms;
   mutable std::mutex mutex_;
   std::condition_variable cv_;
+  std::function<void(Buffer&)> page_recovery_;
+  // Buffers whose blocks are being recovered by `page_recovery_`
+  std::unordered_set<const Buffer*> recovering_;
 };
 }  // namespace simpledb
@@ -0,0 +1,144 @@
+#include "file/crc32c.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <span>  // NOLINT(build/include_order)
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace simpledb {
+namespace {
+// The CRC32C polynomial in reversed bit order
+constexpr uint32_t POLYNOMIAL = 0x82f63b78;
+
+using Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+/**
+ * @brief Build the lookup tables of the slicing-by-8 algorithm. Table 0 is the
+ * classic byte-at-a-time table; table k advances a byte through k more zero
+ * bytes.
+ * @return the lookup tables
+ */
+constexpr Tables MakeTables() noexcept {
+  Tables tables{};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ ((crc & 1) != 0 ? POLYNOMIAL : 0);
+    }
+    tables[0][i] = crc;
+  }
+  for (uint32_t i = 0; i < 256; i++) {
+    for (size_t k = 1; k < tables.size(); k++) {
+      uint32_t prev = tables[k - 1][i];
+      tables[k][i] = (prev >> 8) ^ tables[0][prev & 0xff];
+    }
+  }
+  return tables;
+}
+
+constexpr Tables TABLES = MakeTables();
+
+/**
+ * @brief Compute the checksum with table lookups
+ * @param bytes the bytes to checksum
+ * @param crc the inverted checksum of the preceding bytes
+ * @return the inverted checksum including the bytes
+ */
+uint32_t Crc32cSoftware(std::span<const char> bytes, uint32_t crc) noexcept {
+  auto data = reinterpret_cast<const unsigned char*>(bytes.data());
+  size_t size = bytes.size();
+  while (size >= 8) {
+    uint32_t low;
+    uint32_t high;
+    std::memcpy(&low, data, sizeof(low));
+    std::memcpy(&high, data + 4, sizeof(high));
+    low ^= crc;
+    crc = TABLES[7][low & 0xff] ^ TABLES[6][(low >> 8) & 0xff] ^
+          TABLES[5][(low >> 16) & 0xff] ^ TABLES[4][low >> 24] ^
+          TABLES[3][high & 0xff] ^ TABLES[2][(high >> 8) & 0xff] ^
+          TABLES[1][(high >> 16) & 0xff] ^ TABLES[0][high >> 24];
+    data += 8;
+    size -= 8;
+  }
+  while (size-- > 0) {
+    crc = (crc >> 8) ^ TABLES[0][(crc ^ *data++) & 0xff];
+  }
+  return crc;
+}
+
+#if defined(__x86_64__)
+/**
+ * @brief Compute the checksum with the SSE4.2 crc32 instruction
+ * @param bytes the bytes to checksum
+ * @param crc the inverted checksum of the preceding bytes
+ * @return the inverted checksum including the bytes
+ */
+__attribute__((target("sse4.2"))) uint32_t Crc32cHardware(
+    std::span<const char> bytes, uint32_t crc) noexcept {
+  const char* data = bytes.data();
+  size_t size = bytes.size();
+  uint64_t crc64 = crc;
+  while (size >= 8) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+    data += 8;
+    size -= 8;
+  }
+  crc = static_cast<uint32_t>(crc64);
+  while (size-- > 0) {
+    crc = _mm_crc32_u8(crc, static_cast<unsigned char>(*data++));
+  }
+  return crc;
+}
+
+const bool HAS_HARDWARE_CRC = [] {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.2") != 0;
+}();
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+/**
+ * @brief Compute the checksum with the AArch64 crc32c instructions
+ * @param bytes the bytes to checksum
+ * @param crc the inverted checksum of the preceding bytes
+ * @return the inverted checksum including the bytes
+ */
+uint32_t Crc32cHardware(std::span<const char> bytes, uint32_t crc) noexcept {
+  const char* data = bytes.data();
+  size_t size = bytes.size();
+  while (size >= 8) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    crc = __crc32cd(crc, word);
+    data += 8;
+    size -= 8;
+  }
+  while (size-- > 0) {
+    crc = __crc32cb(crc, static_cast<uint8_t>(*data++));
+  }
+  return crc;
+}
+
+const bool HAS_HARDWARE_CRC = true;
+#else
+uint32_t Crc32cHardware(std::span<const char> bytes, uint32_t crc) noexcept {
+  return Crc32cSoftware(bytes, crc);
+}
+
+const bool HAS_HARDWARE_CRC = false;
+#endif
+}  // namespace
+
+uint32_t Crc32c(std::span<const char> bytes, uint32_t crc) noexcept {
+  crc = ~crc;
+  crc = HAS_HARDWARE_CRC ? Crc32cHardware(bytes, crc)
+                         : Crc32cSoftware(bytes, crc);
+  return ~crc;
+}
+}  // namespace simpledb
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <span>  // NOLINT(build/include_order)
+
+namespace simpledb {
+/**
+ * @brief Compute the CRC32C (Castagnoli) checksum of a sequence of bytes. On
+ * CPUs with a CRC32C instruction (SSE4.2 on x86-64, the CRC extension on
+ * AArch64), the bytes are consumed 8 at a time by that instruction; otherwise
+ * a slicing-by-8 table lookup is used. The checksum of a sequence split in
+ * two parts can be computed by passing the checksum of the first part as
+ * `crc` when checksumming the second.
+ * @param bytes the bytes to checksum
+ * @param crc the checksum of the preceding bytes, or 0 to start a new one
+ * @return the checksum of the bytes
+ */
+uint32_t Crc32c(std::span<const char> bytes, uint32_t crc = 0) noexcept;
+}  // namespace simpledb
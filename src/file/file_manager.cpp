@@ -1,5 +1,7 @@
 #include "file/file_manager.h"
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <utility>
@@ -25,21 +27,26 @@ FileManager::FileManager(const fs::path& db_directory_path, int block_size)
 }
 
 void FileManager::Read(const BlockId& block, const Page& page) {
+  Read(block, page.Contents());
+}
+
+void FileManager::Read(const BlockId& block, std::span<char> bytes) {
   std::scoped_lock lock{mutex_};
   std::fstream& file = GetFile(block.Filename());
-  file.seekg(block.BlockNumber() * block_size_, std::ios_base::beg);
-  auto page_view = page.Contents();
-  // Read data from file into the page
-  file.read(page_view.data(), page_view.size());
-  // When reading an empty file, end of file condition occurs
+  file.seekg(static_cast<std::streamoff>(block.BlockNumber()) * block_size_,
+             std::ios_base::beg);
+  // Read data from file into the buffer
+  file.read(bytes.data(), bytes.size());
+  // When reading past the end of the file, end of file condition occurs
   if (file.fail()) {
     if (file.rdstate() == (std::ios_base::failbit | std::ios_base::eofbit)) {
       // Must clear all error flags since (failbit | eofbit) is set when reading
-      // from an empty file
+      // past the end of the file
+      size_t bytes_read = file.gcount();
       file.clear();
-      // Initialize the page with zero to indicate that it is read from an
-      // empty file
-      std::memset(page_view.data(), '\0', page_view.size());
+      // Initialize the rest of the buffer with zero to indicate that it is
+      // read from an empty part of the file
+      std::memset(bytes.data() + bytes_read, '\0', bytes.size() - bytes_read);
     } else {
       throw std::runtime_error("Got error while reading file");
     }
@@ -64,7 +71,7 @@ void FileManager::Write(const BlockId& block, const Page& page) {
 
 BlockId FileManager::Append(std::string_view filename) {
   std::scoped_lock lock{mutex_};
-  int new_block_num = Length(filename);
+  int new_block_num = LengthNoLock(filename);
   BlockId block{filename, new_block_num};
   std::fstream& file = GetFile(block.Filename());
   file.seekp(block.BlockNumber() * block_size_, std::ios_base::beg);
@@ -83,6 +90,35 @@ BlockId FileManager::Append(std::string_view filename) {
 }
 
 int FileManager::Length(std::string_view filename) {
+  std::scoped_lock lock{mutex_};
+  return LengthNoLock(filename);
+}
+
+void FileManager::Remove(std::string_view filename) {
+  std::scoped_lock lock{mutex_};
+  auto entry = open_files_.find(filename);
+  if (entry != open_files_.end()) {
+    open_files_.erase(entry);
+  }
+  fs::remove(db_directory_path_ / filename);
+}
+
+std::vector<std::string> FileManager::FilesWithPrefix(std::string_view prefix) {
+  std::scoped_lock lock{mutex_};
+  std::vector<std::string> filenames;
+  for (const auto& directory_entry :
+       fs::directory_iterator{db_directory_path_}) {
+    auto filename = directory_entry.path().filename().string();
+    if (filename.starts_with(prefix)) {
+      filenames.push_back(std::move(filename));
+    }
+  }
+  std::sort(filenames.begin(), filenames.end());
+
+  return filenames;
+}
+
+int FileManager::LengthNoLock(std::string_view filename) {
   GetFile(filename);
   fs::path filepath{db_directory_path_ / filename};
 
@@ -3,7 +3,10 @@
 #include <filesystem>
 #include <fstream>
 #include <mutex>  // NOLINT(build/c++11)
+#include <span>   // NOLINT(build/include_order)
+#include <string>
 #include <string_view>
+#include <vector>
 
 #include "file/block_id.h"
 #include "file/page.h"
@@ -33,6 +36,15 @@ class FileManager {
    */
   void Read(const BlockId& block, const Page& page);
 
+  /**
+   * @brief Read consecutive blocks, starting at the specified block, into a
+   * byte buffer whose size is a multiple of the block size. Blocks past the end
+   * of the file are read as zeros.
+   * @param block the first block to read from
+   * @param bytes the buffer to read to
+   */
+  void Read(const BlockId& block, std::span<char> bytes);
+
   /**
    * @brief Write the contents of a page to the specified block
    * @param block the block to write to
@@ -54,6 +66,19 @@ class FileManager {
    */
   int Length(std::string_view filename);
 
+  /**
+   * @brief Close and delete the specified file
+   * @param filename the file to delete
+   */
+  void Remove(std::string_view filename);
+
+  /**
+   * @brief Get the names of the database files that begin with a prefix
+   * @param prefix the prefix to match
+   * @return the matching filenames, in lexicographic order
+   */
+  std::vector<std::string> FilesWithPrefix(std::string_view prefix);
+
   /**
    * @brief Check whether this FileManager object holds a newly created database
    * @return true or false
@@ -74,6 +99,13 @@ class FileManager {
    */
   std::fstream& GetFile(std::string_view filename);
 
+  /**
+   * @brief Get the number of blocks of a file. The caller must hold `mutex_`.
+   * @param filename the filename to get its number of blocks
+   * @return the number of blocks in the file
+   */
+  int LengthNoLock(std::string_view filename);
+
   fs::path db_directory_path_;
   int block_size_{};
   bool is_new_{};
@@ -20,6 +20,17 @@ void Page::SetInt(int offset, int num) noexcept {
   std::memcpy(&byte_buffer_[offset], &num, sizeof(int));
 }
 
+int64_t Page::GetLong(int offset) const noexcept {
+  int64_t num;
+  std::memcpy(&num, &byte_buffer_[offset], sizeof(int64_t));
+
+  return num;
+}
+
+void Page::SetLong(int offset, int64_t num) noexcept {
+  std::memcpy(&byte_buffer_[offset], &num, sizeof(int64_t));
+}
+
 std::span<char> Page::GetBytes(int offset) const noexcept {
   // TODO(DANG): reference to the underlying bytes (span)
   // or allocate a new chunk of bytes (unique_ptr)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <span>  // NOLINT(build/include_order)
 #include <string_view>
 
@@ -47,6 +48,20 @@ class Page {
    */
   void SetInt(int offset, int num) noexcept;
 
+  /**
+   * @brief Get a 64-bit integer from the page at the specified offset
+   * @param offset the offset to retrieve value from
+   * @return the 64-bit integer at the specified offset
+   */
+  int64_t GetLong(int offset) const noexcept;
+
+  /**
+   * @brief Save a 64-bit integer in the page at the specified offset
+   * @param offset the offset to save value at
+   * @param num the 64-bit integer to save
+   */
+  void SetLong(int offset, int64_t num) noexcept;
+
   /**
    * @brief Get a blob (a chunk of bytes) from the page at the specified offset
    * @param offset the offset to retrieve the blob from
@@ -14,6 +14,7 @@ void BTreePage::Close() {
     txn_.Unpin(current_block_.value());
   }
   current_block_.reset();
+  page_ = PageHandle{};
 }
 
 BlockId BTreePage::Split(int split_pos, int flag) {
@@ -33,8 +34,11 @@ BlockId BTreePage::AppendNew(int flag) {
 }
 
 void BTreePage::Format(const BlockId& block, int flag) {
-  txn_.SetInt(block, 0, flag, false);
-  txn_.SetInt(block, sizeof(int), 0, false);  // #records = 0
+  // The header is logged, because a new block reads as zeros after a crash
+  // and recovery may redo later updates onto it. Default records are zeros
+  // already, so they need no log records.
+  txn_.SetInt(block, 0, flag, true);
+  txn_.SetInt(block, sizeof(int), 0, true);  // #records = 0
   auto record_size = layout_.SlotSize();
   for (int pos = 2 * sizeof(int); pos + record_size <= txn_.BlockSize();
        pos += record_size) {
@@ -78,12 +82,14 @@ void BTreePage::Delete(int slot) {
 // Private methods
 int BTreePage::GetInt(int slot, std::string_view field_name) {
   auto pos = FieldPosition(slot, field_name);
-  return txn_.GetInt(current_block_.value(), pos);
+  LockForRead();
+  return txn_.GetInt(page_, pos);
 }
 
 std::string_view BTreePage::GetString(int slot, std::string_view field_name) {
   auto pos = FieldPosition(slot, field_name);
-  return txn_.GetString(current_block_.value(), pos);
+  LockForRead();
+  return txn_.GetString(page_, pos);
 }
 
 Constant BTreePage::GetVal(int slot, std::string_view field_name) {
@@ -97,13 +103,15 @@ Constant BTreePage::GetVal(int slot, std::string_view field_name) {
 
 void BTreePage::SetInt(int slot, std::string_view field_name, int val) {
   auto pos = FieldPosition(slot, field_name);
-  txn_.SetInt(current_block_.value(), pos, val, true);
+  LockForWrite();
+  txn_.SetInt(page_, pos, val, true);
 }
 
 void BTreePage::SetString(int slot, std::string_view field_name,
                           std::string_view val) {
   auto pos = FieldPosition(slot, field_name);
-  txn_.SetString(current_block_.value(), pos, val, true);
+  LockForWrite();
+  txn_.SetString(page_, pos, val, true);
 }
 
 void BTreePage::SetVal(int slot, std::string_view field_name,
@@ -129,6 +137,22 @@ void BTreePage::CopyRecord(int from, int to) {
   }
 }
 
+void BTreePage::LockForRead() {
+  // Locks are held until the transaction ends, so the block is locked once
+  if (!read_locked_) {
+    txn_.SharedLockBlock(current_block_.value());
+    read_locked_ = true;
+  }
+}
+
+void BTreePage::LockForWrite() {
+  if (!write_locked_) {
+    txn_.ExclusiveLockBlock(current_block_.value());
+    read_locked_ = true;
+    write_locked_ = true;
+  }
+}
+
 void BTreePage::TransferRecords(int slot, BTreePage& dest) {
   int dest_slot = 0;
   while (slot < GetNumRecords()) {
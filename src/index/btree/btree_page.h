@@ -20,6 +20,7 @@ class BTreePage {
   BTreePage(Transaction& txn, const BlockId& current_block, Layout& layout)
       : txn_(txn), current_block_(current_block), layout_(layout) {
     txn_.Pin(current_block_.value());
+    page_ = txn_.GetHandle(current_block_.value());
   }
 
   /**
@@ -64,13 +65,19 @@ class BTreePage {
    * @brief Return the value of the page's flag field
    * @return the value of the page's flag field
    */
-  int GetFlag() { return txn_.GetInt(current_block_.value(), 0); }
+  int GetFlag() {
+    LockForRead();
+    return txn_.GetInt(page_, 0);
+  }
 
   /**
    * @brief Set the page's flag field to the specified value
    * @param val the new value of the page flag
    */
-  void SetFlag(int val) { txn_.SetInt(current_block_.value(), 0, val, true); }
+  void SetFlag(int val) {
+    LockForWrite();
+    txn_.SetInt(page_, 0, val, true);
+  }
 
   /**
    * @brief Append a new block to the end of the specified B-tree file, having
@@ -140,7 +147,8 @@ class BTreePage {
    * @return the number of index records in this page
    */
   int GetNumRecords() {
-    return txn_.GetInt(current_block_.value(), sizeof(int));
+    LockForRead();
+    return txn_.GetInt(page_, sizeof(int));
   }
 
  private:
@@ -203,9 +211,22 @@ class BTreePage {
    * @param num_records the number of records
    */
   void SetNumRecords(int num_records) {
-    txn_.SetInt(current_block_.value(), sizeof(int), num_records, true);
+    LockForWrite();
+    txn_.SetInt(page_, sizeof(int), num_records, true);
   }
 
+  /**
+   * @brief Lock the block with a SharedLock before reading it, unless the
+   * page has locked it already
+   */
+  void LockForRead();
+
+  /**
+   * @brief Lock the block with an ExclusiveLock before changing it, unless
+   * the page has locked it already
+   */
+  void LockForWrite();
+
   /**
    * @brief Create an empty slot at the specified position to insert a new
    * record into the page
@@ -252,5 +273,8 @@ class BTreePage {
   Transaction& txn_;
   std::optional<BlockId> current_block_;
   Layout& layout_;
+  PageHandle page_;
+  bool read_locked_{};
+  bool write_locked_{};
 };
 }  // namespace simpledb
@@ -14,25 +14,23 @@ int IndexUpdatePlanner::ExecuteInsert(const InsertData& data,
   std::unique_ptr<Plan> plan =
       std::make_unique<TablePlan>(txn, table_name, metadata_manager_);
 
-  // first, insert the record
+  // first, insert the record with all its fields
   auto scan = plan->Open();
   auto update_scan = dynamic_cast<UpdateScan*>(scan.get());
   if (update_scan == nullptr) {
     throw std::bad_cast{};
   }
-  update_scan->Insert();
-  auto rid = update_scan->GetRID();
-
-  // then modify each field, inserting an index record if appropriate
-  auto indexes = metadata_manager_.GetIndexInfo(table_name, txn);
   const auto& fields = data.Fields();
   const auto& values = data.Values();
   assert(fields.size() == values.size());
+  update_scan->InsertRow(fields, values);
+  auto rid = update_scan->GetRID();
+
+  // then insert an index record for each indexed field
+  auto indexes = metadata_manager_.GetIndexInfo(table_name, txn);
   for (size_t i = 0; i < fields.size(); i++) {
     const auto& field_name = fields[i];
     const auto& value = values[i];
-    update_scan->SetVal(field_name, value);
-
     if (indexes.contains(field_name)) {
       auto index_info = indexes.at(field_name);
       auto index = index_info.Open();
@@ -105,7 +103,7 @@ int IndexUpdatePlanner::ExecuteModify(const ModifyData& data,
     // first, update the record
     auto new_val = data.NewValue().Evaluate(*update_scan);
     auto old_val = update_scan->GetVal(field_name);
-    update_scan->SetVal(data.TargetField(), new_val);
+    update_scan->UpdateRow({data.TargetField()}, {new_val});
 
     // then update the appropriate index, if it exists
     if (index != nullptr) {
@@ -1,26 +1,63 @@
 #include "log/log_iterator.h"
 
+#include "log/log_manager.h"
+
 namespace simpledb {
-LogIterator::LogIterator(FileManager& file_manager, const BlockId& block)
+LogIterator::LogIterator(FileManager& file_manager,
+                         const LogManager& log_manager, int64_t block_num,
+                         int64_t first_block_num)
     : file_manager_(file_manager),
-      block_(block),
-      page_(file_manager_.BlockSize()) {
-  MoveToBlock(block_);
+      first_block_num_(first_block_num),
+      read_ahead_(file_manager, log_manager, first_block_num, block_num) {
+  MoveToBlock(block_num);
 }
 
-std::span<char> LogIterator::Next() noexcept {
-  if (current_pos_ == file_manager_.BlockSize()) {
-    block_ = BlockId{block_.Filename(), block_.BlockNumber() - 1};
-    MoveToBlock(block_);
+std::span<char> LogIterator::Next() {
+  // skip over empty blocks left behind by a log rollover
+  while (current_pos_ <= static_cast<int>(sizeof(int))) {
+    MoveToBlock(block_num_ - 1);
   }
-  auto log_record = page_.GetBytes(current_pos_);
-  // a blob contains: the number of bytes and the bytes themselves
-  current_pos_ += sizeof(int) + log_record.size();
+  // a record is framed by its size on both sides, so the trailing size tells
+  // where the record starts
+  auto page = read_ahead_.Fetch(block_num_, false);
+  int record_size = page.GetInt(current_pos_ - sizeof(int));
+  current_pos_ -= record_size + LogManager::FrameSize();
+  return page.GetBytes(current_pos_);
+}
+
+void LogIterator::MoveToBlock(int64_t block_num) {
+  block_num_ = block_num;
+  current_pos_ = read_ahead_.Fetch(block_num_, false).GetInt(0);
+}
+
+ForwardLogIterator::ForwardLogIterator(FileManager& file_manager,
+                                       const LogManager& log_manager,
+                                       Lsn start_lsn, Lsn last_lsn)
+    : file_manager_(file_manager),
+      block_num_(start_lsn / file_manager.BlockSize()),
+      last_lsn_(last_lsn),
+      read_ahead_(file_manager, log_manager, block_num_,
+                  last_lsn / file_manager.BlockSize()),
+      current_pos_(start_lsn % file_manager.BlockSize()) {
+  boundary_ = read_ahead_.Fetch(block_num_, true).GetInt(0);
+}
+
+std::span<char> ForwardLogIterator::Next() {
+  // Skip lazily, so that the bytes returned by the previous call stay valid
+  // until this call
+  SkipExhaustedBlocks();
+  auto page = read_ahead_.Fetch(block_num_, true);
+  auto log_record = page.GetBytes(current_pos_);
+  current_lsn_ = block_num_ * file_manager_.BlockSize() + current_pos_;
+  current_pos_ += log_record.size() + LogManager::FrameSize();
   return log_record;
 }
 
-void LogIterator::MoveToBlock(const BlockId& block) {
-  file_manager_.Read(block, page_);
-  current_pos_ = page_.GetInt(0);
+void ForwardLogIterator::SkipExhaustedBlocks() {
+  while (current_pos_ >= boundary_) {
+    block_num_++;
+    boundary_ = read_ahead_.Fetch(block_num_, true).GetInt(0);
+    current_pos_ = sizeof(int);
+  }
 }
 }  // namespace simpledb
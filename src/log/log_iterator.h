@@ -1,54 +1,129 @@
 #pragma once
 
+#include <cstdint>
 #include <span>
 
-#include "file/block_id.h"
 #include "file/file_manager.h"
-#include "file/page.h"
+#include "log/log_read_ahead.h"
+#include "utils/data_type.h"
 
 namespace simpledb {
+class LogManager;
+
 /**
- * A class that provides the ability to move through the records of the log file
- * in reverse order (from most recent to least recent log records).
+ * A class that provides the ability to move through the records of the log in
+ * reverse order (from most recent to least recent log records). Log blocks are
+ * read ahead several at a time.
  */
 class LogIterator {
  public:
   /**
-   * @brief Create an iterator for the records in the log file, positioned after
-   * the last log record
+   * @brief Create an iterator for the records in the log, positioned after the
+   * last log record of the specified block
    * @param file_manager file manager of the database engine
-   * @param block the disk block that this iterator traverses on
+   * @param log_manager the log manager that maps log blocks to segment files
+   * @param block_num the position in the log stream of the block to start from
+   * @param first_block_num the position of the oldest block still in the log
    */
-  LogIterator(FileManager& file_manager, const BlockId& block);
+  LogIterator(FileManager& file_manager, const LogManager& log_manager,
+              int64_t block_num, int64_t first_block_num);
 
   /**
    * @brief Determine if the current log record is the earliest record in the
-   * log file
+   * log
    * @return true if there is an earlier record; otherwise, false
    */
   bool HasNext() const noexcept {
-    return current_pos_ < file_manager_.BlockSize() || block_.BlockNumber() > 0;
+    return current_pos_ > static_cast<int>(sizeof(int)) ||
+           block_num_ > first_block_num_;
   }
 
   /**
    * @brief Move to the next log record in the block. If there are no more log
    * records in the block, then move to the previous block and return the log
    * record from there.
-   * @return the next earliest log record
+   * @return the next earliest log record. The bytes stay valid until the
+   * iterator leaves its current read-ahead window.
+   */
+  std::span<char> Next();
+
+  /**
+   * @brief Return the LSN of the log record most recently returned by `Next()`
+   * @return the LSN of the current log record
+   */
+  Lsn CurrentLsn() const noexcept {
+    return block_num_ * file_manager_.BlockSize() + current_pos_;
+  }
+
+ private:
+  /**
+   * @brief Move to the specified log block and position it after the last
+   * record in that block (i.e., the most recent one)
+   * @param block_num the position of the block in the log stream
+   */
+  void MoveToBlock(int64_t block_num);
+
+  FileManager& file_manager_;
+  int64_t block_num_{};
+  int64_t first_block_num_{};
+  LogReadAhead read_ahead_;
+  int current_pos_{};
+};
+
+/**
+ * A class that moves through the records of the log in the order they were
+ * written, as needed by a redo pass or by log shipping. Log blocks are read
+ * ahead several at a time. The iterator sees the log as it was when the
+ * iterator was created.
+ */
+class ForwardLogIterator {
+ public:
+  /**
+   * @brief Create an iterator positioned at the specified log record
+   * @param file_manager file manager of the database engine
+   * @param log_manager the log manager that maps log blocks to segment files
+   * @param start_lsn the LSN of the first record to return
+   * @param last_lsn the LSN of the last record in the log
+   */
+  ForwardLogIterator(FileManager& file_manager, const LogManager& log_manager,
+                     Lsn start_lsn, Lsn last_lsn);
+
+  /**
+   * @brief Determine if there is a later record in the log. Since LSNs are
+   * byte offsets, there is one exactly when the iterator's position does not
+   * lie past the last record.
+   * @return true if there is a later record; otherwise, false
+   */
+  bool HasNext() const noexcept {
+    return block_num_ * file_manager_.BlockSize() + current_pos_ <= last_lsn_;
+  }
+
+  /**
+   * @brief Move to the next log record in the log
+   * @return the next later log record. The bytes stay valid until the iterator
+   * leaves its current read-ahead window.
+   */
+  std::span<char> Next();
+
+  /**
+   * @brief Return the LSN of the log record most recently returned by `Next()`
+   * @return the LSN of the current log record
    */
-  std::span<char> Next() noexcept;
+  Lsn CurrentLsn() const noexcept { return current_lsn_; }
 
  private:
   /**
-   * @brief Move to the specified log block and position it at the first record
-   * in that block (i.e., the most recent one)
-   * @param block the block to move to
+   * @brief Move past the end of exhausted blocks to the next block that still
+   * has records, if there is one
    */
-  void MoveToBlock(const BlockId& block);
+  void SkipExhaustedBlocks();
 
   FileManager& file_manager_;
-  BlockId block_;
-  Page page_;
+  int64_t block_num_{};
+  Lsn last_lsn_{};
+  LogReadAhead read_ahead_;
   int current_pos_{};
+  int boundary_{};
+  Lsn current_lsn_{INVALID_LSN};
 };
 }  // namespace simpledb
@@ -1,67 +1,369 @@
 #include "log/log_manager.h"
 
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
 #include "file/block_id.h"
 #include "file/file_manager.h"
 #include "log/log_iterator.h"
 
 namespace simpledb {
-LogManager::LogManager(FileManager& file_manager, std::string_view log_file)
+LogManager::LogManager(FileManager& file_manager, std::string_view log_file,
+                       int segment_blocks)
     : file_manager_(file_manager),
       log_file_(log_file),
+      segment_blocks_(segment_blocks),
       log_page_(file_manager_.BlockSize()) {
-  int log_size = file_manager_.Length(log_file_);
-  if (log_size == 0) {
-    current_block_ = AppendNewBlock();
+  auto segment_files = file_manager_.FilesWithPrefix(log_file_ + ".");
+  if (segment_files.empty()) {
+    std::scoped_lock lock{segment_mutex_};
+    PrepareSegment(0);
+    log_page_.SetInt(0, sizeof(int));
+    file_manager_.Write(LogBlock(0), log_page_);
   } else {
-    current_block_ = BlockId{log_file_, log_size - 1};
-    file_manager_.Read(current_block_, log_page_);
+    OpenLog(segment_files);
   }
+
+  requested_segment_ = current_block_num_ / segment_blocks_ + 1;
+  segment_allocator_ = std::thread{&LogManager::RunSegmentAllocator, this};
+  flusher_ = std::thread{&LogManager::RunFlusher, this};
 }
 
-void LogManager::Flush(int lsn) {
+LogManager::~LogManager() {
+  {
+    std::scoped_lock lock{mutex_};
+    stop_flusher_ = true;
+  }
+  flusher_cv_.notify_one();
+  flusher_.join();
+  {
+    std::scoped_lock lock{segment_mutex_};
+    stop_allocator_ = true;
+  }
+  segment_cv_.notify_one();
+  segment_allocator_.join();
+}
+
+void LogManager::Flush(Lsn lsn) {
+  std::scoped_lock lock{mutex_};
   if (lsn > last_saved_lsn_) {
     Flush();
   }
 }
 
+void LogManager::FlushLater(Lsn lsn) {
+  {
+    std::scoped_lock lock{mutex_};
+    if (lsn <= last_saved_lsn_ || lsn <= flush_later_lsn_) {
+      return;
+    }
+    // The deadline is set by the oldest record still waiting
+    if (flush_later_lsn_ <= last_saved_lsn_) {
+      flush_deadline_ = std::chrono::steady_clock::now() + flush_interval_;
+    }
+    flush_later_lsn_ = lsn;
+  }
+  flusher_cv_.notify_one();
+}
+
+void LogManager::SetFlushInterval(std::chrono::milliseconds interval) {
+  {
+    std::scoped_lock lock{mutex_};
+    flush_interval_ = interval;
+  }
+  flusher_cv_.notify_one();
+}
+
+void LogManager::SetCheckpointInterval(int64_t interval) {
+  std::scoped_lock lock{mutex_};
+  checkpoint_interval_ = interval;
+}
+
+bool LogManager::ClaimCheckpoint() {
+  std::scoped_lock lock{mutex_};
+  if (checkpoint_claimed_ || checkpoints_suspended_ ||
+      latest_lsn_ - checkpoint_lsn_ < checkpoint_interval_) {
+    return false;
+  }
+  checkpoint_claimed_ = true;
+  return true;
+}
+
+void LogManager::ReleaseCheckpoint() {
+  std::scoped_lock lock{mutex_};
+  checkpoint_claimed_ = false;
+}
+
+void LogManager::SuspendCheckpoints(bool suspended) {
+  std::scoped_lock lock{mutex_};
+  checkpoints_suspended_ = suspended;
+}
+
+void LogManager::CheckpointWritten(Lsn lsn) {
+  std::scoped_lock lock{mutex_};
+  checkpoint_lsn_ = std::max(checkpoint_lsn_, lsn);
+}
+
+Lsn LogManager::DurableLsn() {
+  std::scoped_lock lock{mutex_};
+  return last_saved_lsn_;
+}
+
 LogIterator LogManager::Iterator() {
+  std::scoped_lock lock{mutex_};
+  Flush();
+
+  return LogIterator{file_manager_, *this, current_block_num_,
+                     first_segment_ * segment_blocks_};
+}
+
+ForwardLogIterator LogManager::ForwardIterator(Lsn start_lsn) {
+  std::scoped_lock lock{mutex_};
   Flush();
 
-  return LogIterator{file_manager_, current_block_};
+  Lsn first_lsn = first_segment_ * segment_blocks_ * file_manager_.BlockSize() +
+                  static_cast<Lsn>(sizeof(int));
+  return ForwardLogIterator{file_manager_, *this,
+                            std::max(start_lsn, first_lsn), latest_lsn_};
 }
 
-int LogManager::Append(std::span<char> log_record) {
+Lsn LogManager::Append(std::span<char> log_record) {
   std::scoped_lock lock{mutex_};
   int boundary = log_page_.GetInt(0);
   int record_size = log_record.size();
-  int len_size = sizeof(int);
-  int bytes_needed = record_size + len_size;
+  int bytes_needed = record_size + FrameSize();
+
+  if (record_size > MaxRecordSize()) {
+    throw std::runtime_error("Log record is larger than a log block");
+  }
 
   // the log record doesn't fit
-  if (boundary - bytes_needed < len_size) {
+  if (boundary + bytes_needed > file_manager_.BlockSize()) {
     Flush();
-    current_block_ = AppendNewBlock();
+    AppendNewBlock();
     boundary = log_page_.GetInt(0);
   }
 
-  int record_pos = boundary - bytes_needed;
+  int record_pos = boundary;
   log_page_.SetBytes(record_pos, log_record);
-  log_page_.SetInt(0, record_pos);  // the new boundary
-  latest_lsn_++;
+  log_page_.SetInt(record_pos + sizeof(int) + record_size, record_size);
+  log_page_.SetInt(0, record_pos + bytes_needed);  // the new boundary
+  latest_lsn_ = current_block_num_ * file_manager_.BlockSize() + record_pos;
 
   return latest_lsn_;
 }
 
-BlockId LogManager::AppendNewBlock() {
-  auto block = file_manager_.Append(log_file_);
-  log_page_.SetInt(0, file_manager_.BlockSize());
-  file_manager_.Write(block, log_page_);
+std::vector<char> LogManager::ReadAt(Lsn lsn) {
+  std::vector<char> buffer;
+  auto bytes = ReadAt(lsn, buffer);
+
+  return std::vector<char>(bytes.begin(), bytes.end());
+}
+
+std::span<const char> LogManager::ReadAt(Lsn lsn,
+                                         std::vector<char>& buffer) {
+  int block_size = file_manager_.BlockSize();
+  int64_t block_num = lsn / block_size;
+  int record_pos = lsn % block_size;
+  buffer.resize(block_size);
+  Page page{buffer.data(), buffer.size()};
+
+  // Reading a segment that has just been deleted would create it anew
+  std::shared_lock truncate_lock{truncate_mutex_};
+  std::unique_lock lock{mutex_};
+  if (lsn < 0 || lsn > latest_lsn_) {
+    throw std::runtime_error("ReadAt: LSN is out of the log's range");
+  }
+  if (block_num < first_segment_ * segment_blocks_) {
+    throw std::runtime_error("ReadAt: LSN has been truncated from the log");
+  }
+  if (block_num == current_block_num_) {
+    page.SetBytes(record_pos, log_page_.GetBytes(record_pos));
+    return page.GetBytes(record_pos);
+  }
+  lock.unlock();
+
+  // Earlier blocks are immutable once the log has moved past them
+  file_manager_.Read(LogBlock(block_num), page);
+  if (record_pos < static_cast<int>(sizeof(int)) ||
+      record_pos >= page.GetInt(0)) {
+    throw std::runtime_error("ReadAt: LSN does not refer to a log record");
+  }
 
-  return block;
+  return page.GetBytes(record_pos);
+}
+
+Lsn LogManager::LatestLsn() {
+  std::scoped_lock lock{mutex_};
+  return latest_lsn_;
+}
+
+void LogManager::Truncate(Lsn min_lsn) {
+  if (min_lsn < 0) {
+    return;
+  }
+  int64_t segment_bytes =
+      static_cast<int64_t>(segment_blocks_) * file_manager_.BlockSize();
+
+  std::scoped_lock lock{truncate_mutex_, mutex_};
+  int64_t keep_segment = std::min(min_lsn / segment_bytes,
+                                  current_block_num_ / segment_blocks_);
+  for (; first_segment_ < keep_segment; first_segment_++) {
+    file_manager_.Remove(SegmentFile(first_segment_));
+  }
+}
+
+BlockId LogManager::LogBlock(int64_t block_num) const {
+  return BlockId{SegmentFile(block_num / segment_blocks_),
+                 static_cast<int>(block_num % segment_blocks_)};
+}
+
+void LogManager::OpenLog(const std::vector<std::string>& segment_files) {
+  std::vector<int64_t> segments;
+  for (const auto& filename : segment_files) {
+    auto suffix = filename.substr(log_file_.size() + 1);
+    if (!suffix.empty() &&
+        std::all_of(suffix.begin(), suffix.end(), ::isdigit)) {
+      segments.push_back(std::stoll(suffix));
+    }
+  }
+  if (segments.empty()) {
+    throw std::runtime_error("Log segment files are malformed");
+  }
+  std::sort(segments.begin(), segments.end());
+  first_segment_ = segments.front();
+
+  // Segments are allocated ahead of the log tail, so the tail lives in the
+  // last segment whose first block has been written
+  int64_t segment = first_segment_;
+  for (auto iter = segments.rbegin(); iter != segments.rend(); iter++) {
+    file_manager_.Read(BlockId{SegmentFile(*iter), 0}, log_page_);
+    if (log_page_.GetInt(0) != 0) {
+      segment = *iter;
+      break;
+    }
+  }
+
+  // Written blocks form a prefix of the segment, so binary search for the last
+  // one. A block that has never been written has a zero boundary.
+  int low = 0;
+  int high = segment_blocks_ - 1;
+  while (low < high) {
+    int mid = (low + high + 1) / 2;
+    file_manager_.Read(BlockId{SegmentFile(segment), mid}, log_page_);
+    if (log_page_.GetInt(0) != 0) {
+      low = mid;
+    } else {
+      high = mid - 1;
+    }
+  }
+  current_block_num_ = segment * segment_blocks_ + low;
+
+  {
+    std::scoped_lock lock{segment_mutex_};
+    prepared_segment_ = segment - 1;
+    PrepareSegment(segment);
+  }
+
+  file_manager_.Read(LogBlock(current_block_num_), log_page_);
+  if (log_page_.GetInt(0) == 0) {
+    log_page_.SetInt(0, sizeof(int));
+    file_manager_.Write(LogBlock(current_block_num_), log_page_);
+  }
+
+  latest_lsn_ = LastRecordLsn();
+  // A crash right after the log rolled over leaves an empty last block, so
+  // the latest record lives in an earlier one
+  if (latest_lsn_ == INVALID_LSN) {
+    auto iter = LogIterator{file_manager_, *this, current_block_num_,
+                            first_segment_ * segment_blocks_};
+    if (iter.HasNext()) {
+      iter.Next();
+      latest_lsn_ = iter.CurrentLsn();
+    }
+  }
+  last_saved_lsn_ = latest_lsn_;
+}
+
+void LogManager::AppendNewBlock() {
+  current_block_num_++;
+  auto block = LogBlock(current_block_num_);
+  if (block.BlockNumber() == 0) {
+    int64_t segment = current_block_num_ / segment_blocks_;
+    {
+      std::scoped_lock lock{segment_mutex_};
+      PrepareSegment(segment);
+      requested_segment_ = segment + 1;
+    }
+    segment_cv_.notify_one();
+  }
+  log_page_.SetInt(0, sizeof(int));
+  file_manager_.Write(block, log_page_);
 }
 
 void LogManager::Flush() {
-  file_manager_.Write(current_block_, log_page_);
+  file_manager_.Write(LogBlock(current_block_num_), log_page_);
   last_saved_lsn_ = latest_lsn_;
 }
+
+Lsn LogManager::LastRecordLsn() const noexcept {
+  int boundary = log_page_.GetInt(0);
+  if (boundary <= static_cast<int>(sizeof(int))) {
+    return INVALID_LSN;
+  }
+  int record_size = log_page_.GetInt(boundary - sizeof(int));
+  int record_pos = boundary - FrameSize() - record_size;
+
+  return current_block_num_ * file_manager_.BlockSize() + record_pos;
+}
+
+std::string LogManager::SegmentFile(int64_t segment) const {
+  std::stringstream output;
+  output << log_file_ << '.' << std::setw(6) << std::setfill('0') << segment;
+
+  return output.str();
+}
+
+void LogManager::PrepareSegment(int64_t segment) {
+  if (segment <= prepared_segment_) {
+    return;
+  }
+  auto filename = SegmentFile(segment);
+  while (file_manager_.Length(filename) < segment_blocks_) {
+    file_manager_.Append(filename);
+  }
+  prepared_segment_ = segment;
+}
+
+void LogManager::RunFlusher() {
+  std::unique_lock lock{mutex_};
+  auto waiting = [this] { return flush_later_lsn_ > last_saved_lsn_; };
+  while (true) {
+    flusher_cv_.wait(lock, [&] { return stop_flusher_ || waiting(); });
+    // A synchronous flush may write the records before the deadline
+    flusher_cv_.wait_until(lock, flush_deadline_,
+                           [&] { return stop_flusher_ || !waiting(); });
+    if (waiting()) {
+      Flush();
+    }
+    if (stop_flusher_) {
+      return;
+    }
+  }
+}
+
+void LogManager::RunSegmentAllocator() {
+  std::unique_lock lock{segment_mutex_};
+  while (true) {
+    segment_cv_.wait(lock, [this] {
+      return stop_allocator_ || requested_segment_ > prepared_segment_;
+    });
+    if (stop_allocator_) {
+      return;
+    }
+    PrepareSegment(requested_segment_);
+  }
+}
 }  // namespace simpledb
@@ -1,74 +1,306 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>              // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
 #include <mutex>  // NOLINT(build/c++11)
-#include <span>   // NOLINT(build/include_order)
+#include <shared_mutex>
+#include <span>  // NOLINT(build/include_order)
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
 
 #include "file/block_id.h"
 #include "file/file_manager.h"
 #include "file/page.h"
 #include "log/log_iterator.h"
+#include "utils/data_type.h"
 
 namespace simpledb {
 /**
- * The log manager is responsible for writing log records into a log file. The
+ * The log manager is responsible for writing log records into the log. The
  * tail of the log is kept in an in-memory log buffer, which is flushed to disk
  * when needed.
+ *
+ * Each log block starts with the "boundary", the offset just past the last
+ * record in the block. Records are written left to right; every record is
+ * framed by its size both before and after the bytes, so the log can be read
+ * in either direction. The LSN of a record is the byte offset of its frame in
+ * the log stream, which makes LSNs monotonic, persistent across restarts, and
+ * directly seekable.
+ *
+ * The log stream is split into fixed-size segment files named
+ * `<log_file>.<segment number>`. Segments are allocated ahead of time by a
+ * background thread, and segments that lie entirely before the oldest LSN
+ * still needed for recovery can be deleted with `Truncate`.
+ *
+ * A background flusher makes records durable that nobody waits for, such as
+ * the COMMIT records of asynchronous commits: each is written to disk within
+ * the flush interval after `FlushLater` is called for it.
  */
 class LogManager {
  public:
   /**
-   * @brief Create the manager for the specified log file. If the log file does
-   * not yet exist, it is created with an empty first block.
+   * @brief Create the manager for the specified log. If the log does not yet
+   * exist, it is created with an empty first block.
    * @param file_manager file manager of the database engine
-   * @param log_file name of the log file
+   * @param log_file base name of the log segment files
+   * @param segment_blocks number of blocks in each log segment
    */
-  LogManager(FileManager& file_manager, std::string_view log_file);
+  LogManager(FileManager& file_manager, std::string_view log_file,
+             int segment_blocks = DEFAULT_SEGMENT_BLOCKS);
+
+  /**
+   * @brief Flush the records left to the flusher, and stop the background
+   * threads
+   */
+  ~LogManager();
 
   /**
    * @brief Ensure that the log record corresponding to the specified LSN has
    * been written to disk. All earlier log records will also be written to disk.
    * @param lsn the LSN of a log record
    */
-  void Flush(int lsn);
+  void Flush(Lsn lsn);
+
+  /**
+   * @brief Ask for the log record with the specified LSN, and all earlier
+   * records, to be written to disk within the flush interval, without waiting
+   * for it
+   * @param lsn the LSN of a log record
+   */
+  void FlushLater(Lsn lsn);
+
+  /**
+   * @brief Set how long a record passed to `FlushLater` may wait before it is
+   * written to disk, i.e., how much of the log a crash may lose
+   * @param interval the flush interval
+   */
+  void SetFlushInterval(std::chrono::milliseconds interval);
+
+  /**
+   * @brief Set how many bytes of log may be written between two automatic
+   * checkpoints of this log
+   * @param interval the checkpoint interval in bytes of log
+   */
+  void SetCheckpointInterval(int64_t interval);
+
+  /**
+   * @brief Claim the next automatic checkpoint, if the log has grown by the
+   * checkpoint interval since the last checkpoint and no other automatic
+   * checkpoint is being written. A successful claim must be released with
+   * `ReleaseCheckpoint`.
+   * @return true if the caller should write a checkpoint; otherwise, false
+   */
+  bool ClaimCheckpoint();
+
+  /**
+   * @brief Release the claim taken by a successful `ClaimCheckpoint`, whether
+   * or not a checkpoint was written
+   */
+  void ReleaseCheckpoint();
+
+  /**
+   * @brief Suspend or resume the checkpoints of this log, such as while an
+   * on-demand restart still needs the log records that a checkpoint would
+   * truncate
+   * @param suspended true to suspend checkpoints, false to resume them
+   */
+  void SuspendCheckpoints(bool suspended);
+
+  /**
+   * @brief Return whether the checkpoints of this log are suspended. It takes
+   * no latch, so that it can be checked often.
+   * @return true if no checkpoint may be written; otherwise, false
+   */
+  bool CheckpointsSuspended() const noexcept { return checkpoints_suspended_; }
+
+  /**
+   * @brief Record that a checkpoint has been written, which starts the next
+   * checkpoint interval
+   * @param lsn the LSN of the checkpoint's last record
+   */
+  void CheckpointWritten(Lsn lsn);
+
+  /**
+   * @brief Return the LSN of the most recent log record written to disk
+   * @return the durable LSN, or `INVALID_LSN` if no record is durable
+   */
+  Lsn DurableLsn();
 
   /**
-   * @brief Get a log iterator to traverse through log records in the current
-   * block
-   * @return an iterator to the most recent log record of the current block
+   * @brief Get a log iterator to traverse backward through the log records
+   * @return an iterator positioned after the most recent log record
    */
   LogIterator Iterator();
 
+  /**
+   * @brief Get a log iterator to traverse forward through the log records
+   * @param start_lsn the LSN of the first record to visit. By default, the
+   * iterator starts at the oldest record still in the log.
+   * @return an iterator positioned at the specified log record
+   */
+  ForwardLogIterator ForwardIterator(Lsn start_lsn = INVALID_LSN);
+
   /**
    * @brief Append a log record to the log buffer. The record consists of an
-   * arbitrary array of bytes. Log records are written right to left in the
-   * buffer. The size of the record is written before the bytes. The beginning
-   * of the buffer contains the location of the last-written record (the
-   * "boundary"). Storing the records backwards makes it easy to read them in
-   * reverse order.
+   * arbitrary array of bytes, which is framed by its size on both sides.
    * @param log_record the log record to write
    * @return the LSN of this log record
    */
-  int Append(std::span<char> log_record);
+  Lsn Append(std::span<char> log_record);
+
+  /**
+   * @brief Read the log record with the specified LSN without scanning the log
+   * @param lsn the LSN of a log record previously returned by `Append`
+   * @return a copy of the bytes of that log record
+   */
+  std::vector<char> ReadAt(Lsn lsn);
+
+  /**
+   * @brief Read the log record with the specified LSN into a buffer owned by
+   * the caller, so that a caller reading many records can reuse one buffer
+   * instead of allocating for each record
+   * @param lsn the LSN of a log record previously returned by `Append`
+   * @param buffer the buffer to read into. It is grown to a log block the
+   * first time and overwritten by every read.
+   * @return a view of the bytes of that log record within the buffer
+   */
+  std::span<const char> ReadAt(Lsn lsn, std::vector<char>& buffer);
+
+  /**
+   * @brief Return the LSN of the most recently appended log record
+   * @return the latest LSN, or `INVALID_LSN` if the log is empty
+   */
+  Lsn LatestLsn();
+
+  /**
+   * @brief Delete the log segments that only contain records older than the
+   * specified LSN. The segment holding the tail of the log is never deleted.
+   * @param min_lsn the oldest LSN that must remain readable
+   */
+  void Truncate(Lsn min_lsn);
+
+  /**
+   * @brief Return the disk block that holds the specified block of the log
+   * stream
+   * @param block_num the position of the block in the log stream
+   * @return the block within its segment file
+   */
+  BlockId LogBlock(int64_t block_num) const;
+
+  /**
+   * @brief Return the number of blocks in each log segment
+   * @return the segment size in blocks
+   */
+  int SegmentBlocks() const noexcept { return segment_blocks_; }
+
+  /**
+   * @brief Return the number of bytes that frame a log record in a log block
+   * @return the framing overhead of a log record
+   */
+  static constexpr int FrameSize() noexcept { return 2 * sizeof(int); }
+
+  /**
+   * @brief Return the size of the largest log record that fits in a log block
+   * @return the maximum record size in bytes
+   */
+  int MaxRecordSize() const noexcept {
+    return file_manager_.BlockSize() - static_cast<int>(sizeof(int)) -
+           FrameSize();
+  }
+
+  static constexpr int DEFAULT_SEGMENT_BLOCKS = 256;
+  static constexpr std::chrono::milliseconds DEFAULT_FLUSH_INTERVAL{10};
+  static constexpr int64_t DEFAULT_CHECKPOINT_INTERVAL = 1 << 20;
 
  private:
   /**
-   * @brief Extend the log file by allocating a new empty disk block
-   * @return a newly allocated block
+   * @brief Find the end of the existing log and load its last block into the
+   * log page
+   * @param segment_files the existing segment files
+   */
+  void OpenLog(const std::vector<std::string>& segment_files);
+
+  /**
+   * @brief Move the log to the next block of the log stream, rolling over into
+   * the next segment if needed
    */
-  BlockId AppendNewBlock();
+  void AppendNewBlock();
 
   /**
-   * @brief Flush the in-memory page to the log file
+   * @brief Flush the in-memory page to the log
    */
   void Flush();
 
+  /**
+   * @brief Return the LSN of the last log record stored in the log page
+   * @return the LSN of the last record, or `INVALID_LSN` if there is none
+   */
+  Lsn LastRecordLsn() const noexcept;
+
+  /**
+   * @brief Return the name of the file holding the specified segment
+   * @param segment the segment number
+   * @return the segment's filename
+   */
+  std::string SegmentFile(int64_t segment) const;
+
+  /**
+   * @brief Make sure that the specified segment exists at its full size. The
+   * caller must hold `segment_mutex_`.
+   * @param segment the segment number
+   */
+  void PrepareSegment(int64_t segment);
+
+  /**
+   * @brief Body of the background thread that allocates the next segment
+   * ahead of the log tail
+   */
+  void RunSegmentAllocator();
+
+  /**
+   * @brief Body of the background thread that flushes the records passed to
+   * `FlushLater` once their flush interval has passed
+   */
+  void RunFlusher();
+
   FileManager& file_manager_;
   std::string log_file_;
+  int segment_blocks_{};
   Page log_page_;
-  BlockId current_block_;
-  int latest_lsn_{};
-  int last_saved_lsn_{};
+  int64_t current_block_num_{};
+  int64_t first_segment_{};
+  Lsn latest_lsn_{INVALID_LSN};
+  Lsn last_saved_lsn_{INVALID_LSN};
   std::mutex mutex_;
+  // Held shared while a segment is read without `mutex_`, and exclusively
+  // while segments are deleted, so that a read never recreates a deleted
+  // segment. Its latch is taken before `mutex_`, never after.
+  std::shared_mutex truncate_mutex_;
+
+  // When the next automatic checkpoint is due, protected by `mutex_`
+  int64_t checkpoint_interval_{DEFAULT_CHECKPOINT_INTERVAL};
+  Lsn checkpoint_lsn_{INVALID_LSN};
+  bool checkpoint_claimed_{};
+  // Atomic, since it is read without the mutex
+  std::atomic<bool> checkpoints_suspended_{};
+
+  // State shared with the flusher thread, protected by `mutex_`
+  Lsn flush_later_lsn_{INVALID_LSN};
+  std::chrono::steady_clock::time_point flush_deadline_;
+  std::chrono::milliseconds flush_interval_{DEFAULT_FLUSH_INTERVAL};
+  bool stop_flusher_{};
+  std::condition_variable flusher_cv_;
+  std::thread flusher_;
+
+  // State shared with the segment allocator thread
+  int64_t prepared_segment_{-1};
+  int64_t requested_segment_{-1};
+  bool stop_allocator_{};
+  std::mutex segment_mutex_;
+  std::condition_variable segment_cv_;
+  std::thread segment_allocator_;
 };
 }  // namespace simpledb
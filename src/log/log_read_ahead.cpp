@@ -0,0 +1,84 @@
+#include "log/log_read_ahead.h"
+
+#include <algorithm>
+#include <future>  // NOLINT(build/c++11)
+#include <span>    // NOLINT(build/include_order)
+#include <utility>
+
+#include "log/log_manager.h"
+
+namespace simpledb {
+LogReadAhead::LogReadAhead(FileManager& file_manager,
+                           const LogManager& log_manager,
+                           int64_t first_block_num, int64_t last_block_num,
+                           int window_blocks)
+    : file_manager_(file_manager),
+      log_manager_(log_manager),
+      first_block_num_(first_block_num),
+      last_block_num_(last_block_num),
+      window_blocks_(window_blocks),
+      window_(static_cast<size_t>(window_blocks) * file_manager.BlockSize()),
+      prefetch_window_(window_.size()) {}
+
+Page LogReadAhead::Fetch(int64_t block_num, bool forward) {
+  int block_size = file_manager_.BlockSize();
+  if (block_num < window_start_ || block_num >= window_start_ + window_count_) {
+    if (prefetch_.valid() && block_num >= prefetch_start_ &&
+        block_num < prefetch_start_ + prefetch_count_) {
+      prefetch_.get();
+      std::swap(window_, prefetch_window_);
+      window_start_ = prefetch_start_;
+      window_count_ = prefetch_count_;
+    } else {
+      // The iterator jumped elsewhere; a failed prefetch does not matter
+      if (prefetch_.valid()) {
+        prefetch_.wait();
+        prefetch_ = {};
+      }
+      WindowOf(block_num, forward, window_start_, window_count_);
+      file_manager_.Read(log_manager_.LogBlock(window_start_),
+                         std::span{window_.data(),
+                                   static_cast<size_t>(window_count_) *
+                                       block_size});
+    }
+    Prefetch(forward);
+  }
+
+  return Page{window_.data() + (block_num - window_start_) * block_size,
+              static_cast<size_t>(block_size)};
+}
+
+void LogReadAhead::WindowOf(int64_t block_num, bool forward, int64_t& start,
+                            int64_t& count) const noexcept {
+  int segment_blocks = log_manager_.SegmentBlocks();
+  int64_t segment_start = block_num / segment_blocks * segment_blocks;
+  int64_t segment_end = segment_start + segment_blocks - 1;
+  start = block_num;
+  int64_t end = block_num;
+  if (forward) {
+    end = std::min({block_num + window_blocks_ - 1, segment_end,
+                    std::max(last_block_num_, block_num)});
+  } else {
+    start = std::max({block_num - window_blocks_ + 1, segment_start,
+                      std::min(first_block_num_, block_num)});
+  }
+  count = end - start + 1;
+}
+
+void LogReadAhead::Prefetch(bool forward) {
+  int64_t next = forward ? window_start_ + window_count_ : window_start_ - 1;
+  if (next < first_block_num_ || next > last_block_num_) {
+    return;
+  }
+  WindowOf(next, forward, prefetch_start_, prefetch_count_);
+  auto block = log_manager_.LogBlock(prefetch_start_);
+  std::span bytes{prefetch_window_.data(),
+                  static_cast<size_t>(prefetch_count_) *
+                      file_manager_.BlockSize()};
+  // Iterators are returned by value, so the task must not capture `this`
+  prefetch_ = std::async(std::launch::async,
+                         [&file_manager = file_manager_, block, bytes] {
+                           file_manager.Read(block, bytes);
+                         });
+}
+}  // namespace simpledb
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <future>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "file/file_manager.h"
+#include "file/page.h"
+
+namespace simpledb {
+class LogManager;
+
+/**
+ * A window of consecutive log blocks that a log iterator reads with a single
+ * file read. Whenever a window is read, the next window in the direction of
+ * iteration is prefetched on a background thread into a second buffer, so that
+ * the iterator rarely waits for the disk when it steps outside the window. A
+ * window never crosses a log segment boundary, because each segment is a
+ * separate file.
+ */
+class LogReadAhead {
+ public:
+  /**
+   * @brief Create a read-ahead window for the blocks of the log stream in the
+   * range [first_block_num, last_block_num]
+   * @param file_manager file manager of the database engine
+   * @param log_manager the log manager that maps log blocks to segment files
+   * @param first_block_num the first block that may be read
+   * @param last_block_num the last block that may be read
+   * @param window_blocks the maximum number of blocks read at once
+   */
+  LogReadAhead(FileManager& file_manager, const LogManager& log_manager,
+               int64_t first_block_num, int64_t last_block_num,
+               int window_blocks = DEFAULT_WINDOW_BLOCKS);
+
+  /**
+   * @brief Return a page over the specified log block. If the block is not in
+   * the current window, the prefetched window becomes current when it holds
+   * the block; otherwise the block's window is read synchronously. Either way
+   * the window after it is then prefetched.
+   * @param block_num the position of the block in the log stream
+   * @param forward whether the window should extend after the block (for
+   * forward iteration) or before it (for backward iteration)
+   * @return a non-owning page over the block's bytes in the window
+   */
+  Page Fetch(int64_t block_num, bool forward);
+
+  static constexpr int DEFAULT_WINDOW_BLOCKS = 16;
+
+ private:
+  /**
+   * @brief Return the window that holds the specified block, extended in the
+   * direction of iteration
+   * @param block_num the position of the block in the log stream
+   * @param forward the direction of iteration
+   * @param start set to the first block of the window
+   * @param count set to the number of blocks in the window
+   */
+  void WindowOf(int64_t block_num, bool forward, int64_t& start,
+                int64_t& count) const noexcept;
+
+  /**
+   * @brief Start reading the window that follows the current one in the
+   * direction of iteration, if the range has one
+   * @param forward the direction of iteration
+   */
+  void Prefetch(bool forward);
+
+  FileManager& file_manager_;
+  const LogManager& log_manager_;
+  int64_t first_block_num_{};
+  int64_t last_block_num_{};
+  int window_blocks_{};
+  std::vector<char> window_;
+  int64_t window_start_{};
+  int64_t window_count_{};
+  std::vector<char> prefetch_window_;
+  int64_t prefetch_start_{};
+  int64_t prefetch_count_{};
+  // Declared after the buffers so that it is destroyed, waiting for the read
+  // in flight, before them
+  std::future<void> prefetch_;
+};
+}  // namespace simpledb
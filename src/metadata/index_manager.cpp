@@ -1,5 +1,6 @@
 #include "metadata/index_manager.h"
 
+#include "query/constant.h"
 #include "record/table_scan.h"
 #include "utils/data_type.h"
 
@@ -21,10 +22,9 @@ void IndexManager::CreateIndex(std::string_view index_name,
                                std::string_view table_name,
                                std::string_view field_name, Transaction& txn) {
   TableScan index_catalog{txn, "index_catalog", layout_};
-  index_catalog.Insert();
-  index_catalog.SetString("index_name", index_name);
-  index_catalog.SetString("table_name", table_name);
-  index_catalog.SetString("field_name", field_name);
+  index_catalog.InsertRow(
+      {"index_name", "table_name", "field_name"},
+      {Constant{index_name}, Constant{table_name}, Constant{field_name}});
   index_catalog.Close();
 }
 
@@ -3,6 +3,7 @@
 #include <string>
 #include <utility>
 
+#include "query/constant.h"
 #include "record/layout.h"
 #include "record/table_scan.h"
 #include "utils/data_type.h"
@@ -33,20 +34,18 @@ void TableManager::CreateTable(std::string_view table_name,
   Layout layout{schema};
   // insert one record into `table_catalog`
   TableScan table_catalog{txn, "table_catalog", table_catalog_layout_};
-  table_catalog.Insert();
-  table_catalog.SetString("table_name", table_name);
-  table_catalog.SetInt("slot_size", layout.SlotSize());
+  table_catalog.InsertRow({"table_name", "slot_size"},
+                          {Constant{table_name}, Constant{layout.SlotSize()}});
   table_catalog.Close();
 
   // insert a record into `field_catalog` for each field
   TableScan field_catalog{txn, "field_catalog", field_catalog_layout_};
   for (const auto& field_name : schema.Fields()) {
-    field_catalog.Insert();
-    field_catalog.SetString("table_name", table_name);
-    field_catalog.SetString("field_name", field_name);
-    field_catalog.SetInt("type", schema.Type(field_name));
-    field_catalog.SetInt("length", schema.Length(field_name));
-    field_catalog.SetInt("offset", layout.GetOffset(field_name));
+    field_catalog.InsertRow(
+        {"table_name", "field_name", "type", "length", "offset"},
+        {Constant{table_name}, Constant{field_name},
+         Constant{schema.Type(field_name)}, Constant{schema.Length(field_name)},
+         Constant{layout.GetOffset(field_name)}});
   }
   field_catalog.Close();
 }
@@ -3,6 +3,7 @@
 #include <string>
 #include <utility>
 
+#include "query/constant.h"
 #include "record/layout.h"
 #include "record/table_scan.h"
 
@@ -22,9 +23,8 @@ ViewManager::ViewManager(bool is_new, TableManager& table_manager,
 void ViewManager::CreateView(std::string_view view_name,
                              std::string_view view_def, Transaction& txn) {
   TableScan view_catalog{txn, "view_catalog", layout_};
-  view_catalog.Insert();
-  view_catalog.SetString("view_name", view_name);
-  view_catalog.SetString("view_def", view_def);
+  view_catalog.InsertRow({"view_name", "view_def"},
+                         {Constant{view_name}, Constant{view_def}});
   view_catalog.Close();
 }
 
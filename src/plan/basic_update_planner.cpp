@@ -19,13 +19,8 @@ int BasicUpdatePlanner::ExecuteInsert(const InsertData& data,
     throw std::bad_cast{};
   }
 
-  update_scan->Insert();
-  const auto& fields = data.Fields();
-  const auto& values = data.Values();
-  assert(fields.size() == values.size());
-  for (size_t i = 0; i < fields.size(); i++) {
-    update_scan->SetVal(fields[i], values[i]);
-  }
+  assert(data.Fields().size() == data.Values().size());
+  update_scan->InsertRow(data.Fields(), data.Values());
   update_scan->Close();
 
   return 1;
@@ -69,8 +64,8 @@ int BasicUpdatePlanner::ExecuteModify(const ModifyData& data,
 
   int count = 0;
   while (update_scan->Next()) {
-    update_scan->SetVal(data.TargetField(),
-                        data.NewValue().Evaluate(*update_scan));
+    update_scan->UpdateRow({data.TargetField()},
+                           {data.NewValue().Evaluate(*update_scan)});
     count++;
   }
   update_scan->Close();
@@ -82,6 +82,26 @@ void SelectScan::Insert() {
   update_scan->Insert();
 }
 
+void SelectScan::InsertRow(const std::vector<std::string>& field_names,
+                           const std::vector<Constant>& values) {
+  auto update_scan = dynamic_cast<UpdateScan*>(scan_.get());
+  if (update_scan == nullptr) {
+    std::cout << "InsertRow: the underlying scan is not an update scan\n";
+    return;
+  }
+  update_scan->InsertRow(field_names, values);
+}
+
+void SelectScan::UpdateRow(const std::vector<std::string>& field_names,
+                           const std::vector<Constant>& values) {
+  auto update_scan = dynamic_cast<UpdateScan*>(scan_.get());
+  if (update_scan == nullptr) {
+    std::cout << "UpdateRow: the underlying scan is not an update scan\n";
+    return;
+  }
+  update_scan->UpdateRow(field_names, values);
+}
+
 RID SelectScan::GetRID() const {
   auto update_scan = dynamic_cast<UpdateScan*>(scan_.get());
   if (update_scan == nullptr) {
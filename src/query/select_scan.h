@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "query/predicate.h"
 #include "query/scan.h"
@@ -47,6 +49,12 @@ class SelectScan final : public UpdateScan {
 
   void Insert() override;
 
+  void InsertRow(const std::vector<std::string>& field_names,
+                 const std::vector<Constant>& values) override;
+
+  void UpdateRow(const std::vector<std::string>& field_names,
+                 const std::vector<Constant>& values) override;
+
   RID GetRID() const override;
 
   void MoveToRID(const RID& rid) override;
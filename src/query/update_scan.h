@@ -1,6 +1,8 @@
 #pragma once
 
+#include <string>
 #include <string_view>
+#include <vector>
 
 #include "query/constant.h"
 #include "query/scan.h"
@@ -43,6 +45,33 @@ class UpdateScan : public Scan {
    */
   virtual void Insert() = 0;
 
+  /**
+   * @brief Insert a new record with the specified field values somewhere in the
+   * scan. Scans over stored tables write and log the whole row at once.
+   * @param field_names names of the fields to set
+   * @param values the values of those fields
+   */
+  virtual void InsertRow(const std::vector<std::string>& field_names,
+                         const std::vector<Constant>& values) {
+    Insert();
+    for (size_t i = 0; i < field_names.size(); i++) {
+      SetVal(field_names[i], values[i]);
+    }
+  }
+
+  /**
+   * @brief Modify several field values of the current record. Scans over
+   * stored tables write and log the changed fields at once.
+   * @param field_names names of the fields to change
+   * @param values the new values of those fields
+   */
+  virtual void UpdateRow(const std::vector<std::string>& field_names,
+                         const std::vector<Constant>& values) {
+    for (size_t i = 0; i < field_names.size(); i++) {
+      SetVal(field_names[i], values[i]);
+    }
+  }
+
   /**
    * @brief Delete the current record from the scan
    */
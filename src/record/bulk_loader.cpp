@@ -0,0 +1,45 @@
+#include "record/bulk_loader.h"
+
+#include <string>
+#include <vector>
+
+#include "query/constant.h"
+
+namespace simpledb {
+void BulkLoader::Insert(const std::vector<std::string>& field_names,
+                        const std::vector<Constant>& values) {
+  if (record_page_.has_value()) {
+    current_slot_ = record_page_.value().InsertAfter(current_slot_, field_names,
+                                                     values, false);
+  }
+  if (current_slot_ < 0) {
+    MoveToNewBlock();
+    current_slot_ = record_page_.value().InsertAfter(current_slot_, field_names,
+                                                     values, false);
+  }
+  num_rows_++;
+}
+
+int BulkLoader::Close() {
+  if (record_page_.has_value()) {
+    txn_.Unpin(record_page_.value().Block());
+    record_page_.reset();
+  }
+  if (num_blocks_ > 0) {
+    txn_.LogBulkLoad(filename_, num_blocks_, num_rows_);
+  }
+  return num_rows_;
+}
+
+void BulkLoader::MoveToNewBlock() {
+  if (record_page_.has_value()) {
+    txn_.Unpin(record_page_.value().Block());
+  }
+  // A freshly appended block is zeroed, which is already the formatted state
+  // of an empty record page
+  auto block = txn_.AppendUnlogged(filename_);
+  record_page_.emplace(txn_, block, layout_);
+  current_slot_ = -1;
+  num_blocks_++;
+}
+}  // namespace simpledb
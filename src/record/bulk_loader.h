@@ -0,0 +1,68 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "query/constant.h"
+#include "record/layout.h"
+#include "record/record_page.h"
+#include "txn/transaction.h"
+
+namespace simpledb {
+/**
+ * Load rows into a table with minimal logging. The loader never writes to the
+ * table's existing blocks: it appends fresh blocks and fills them without
+ * logging the rows. Only each block allocation is logged, plus a single
+ * LOADTABLE record when the load is closed. The loading transaction forces the
+ * blocks to disk at commit, and a rollback or recovery empties them again.
+ * Loaded rows get no index entries and no MVCC versions: indexes on the table
+ * are not maintained by the load, and the only version saved for a slot is
+ * its empty image from before the load, so snapshot transactions that started
+ * earlier see the new blocks as empty.
+ */
+class BulkLoader {
+ public:
+  /**
+   * @brief Construct a new `BulkLoader` object that appends to the table
+   * @param txn the transaction that loads the table
+   * @param table_name name of the table
+   * @param layout layout of a record in this table
+   */
+  BulkLoader(Transaction& txn, std::string_view table_name, Layout& layout)
+      : txn_(txn),
+        layout_(layout),
+        filename_(std::string(table_name) + ".tbl") {}
+
+  /**
+   * @brief Insert a new record with the specified field values, appending a
+   * new block when the current one is full. Fields without a value are
+   * zeroed.
+   * @param field_names names of the fields to set
+   * @param values the values of those fields
+   */
+  void Insert(const std::vector<std::string>& field_names,
+              const std::vector<Constant>& values);
+
+  /**
+   * @brief Close the loader: unpin the current block and log the load
+   * @return the number of rows loaded
+   */
+  int Close();
+
+ private:
+  /**
+   * @brief Append a new block to the table and make it the current block
+   */
+  void MoveToNewBlock();
+
+  Transaction& txn_;
+  Layout& layout_;
+  std::string filename_;
+  std::optional<RecordPage> record_page_;
+  int current_slot_{-1};
+  int num_blocks_{};
+  int num_rows_{};
+};
+}  // namespace simpledb
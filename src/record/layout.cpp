@@ -1,5 +1,6 @@
 #include "record/layout.h"
 
+#include <stdexcept>
 #include <utility>
 
 namespace simpledb {
@@ -1,69 +1,236 @@
 #include "record/record_page.h"
 
+#include <algorithm>
+
 namespace simpledb {
 
 int RecordPage::GetInt(int slot, std::string_view field_name) {
+  if (txn_.IsSnapshot()) {
+    auto& image = VisibleImage(slot);
+    return Page{image.data(), image.size()}.GetInt(
+        layout_.GetOffset(field_name));
+  }
   int field_pos = Offset(slot) + layout_.GetOffset(field_name);
-  return txn_.GetInt(block_, field_pos);
+  LockForRead(slot);
+  return txn_.GetInt(page_, field_pos);
 }
 
 std::string_view RecordPage::GetString(int slot, std::string_view field_name) {
+  if (txn_.IsSnapshot()) {
+    auto& image = VisibleImage(slot);
+    return Page{image.data(), image.size()}.GetString(
+        layout_.GetOffset(field_name));
+  }
   int field_pos = Offset(slot) + layout_.GetOffset(field_name);
-  return txn_.GetString(block_, field_pos);
+  LockForRead(slot);
+  return txn_.GetString(page_, field_pos);
 }
 
 void RecordPage::SetInt(int slot, std::string_view field_name, int val) {
   int field_pos = Offset(slot) + layout_.GetOffset(field_name);
-  txn_.SetInt(block_, field_pos, val, true);
+  LockForWrite(slot);
+  txn_.SetInt(page_, field_pos, val, true);
 }
 
 void RecordPage::SetString(int slot, std::string_view field_name,
                            std::string_view val) {
   int field_pos = Offset(slot) + layout_.GetOffset(field_name);
-  txn_.SetString(block_, field_pos, val, true);
+  LockForWrite(slot);
+  txn_.SetString(page_, field_pos, val, true);
 }
 
-void RecordPage::Delete(int slot) { SetFlag(slot, EMPTY); }
+void RecordPage::Update(int slot, const std::vector<std::string>& field_names,
+                        const std::vector<Constant>& values) {
+  if (field_names.empty()) {
+    return;
+  }
+  LockForWrite(slot);
+  // The image spans from the first to the last changed field
+  int begin = layout_.SlotSize();
+  int end = 0;
+  for (const auto& field_name : field_names) {
+    begin = std::min(begin, layout_.GetOffset(field_name));
+    end = std::max(end, layout_.GetOffset(field_name) + FieldSize(field_name));
+  }
+
+  // Unchanged fields inside the image keep their current values
+  std::vector<char> image(end - begin);
+  Page image_page{image.data(), image.size()};
+  for (const auto& field_name : layout_.GetSchema().Fields()) {
+    int field_offset = layout_.GetOffset(field_name);
+    if (field_offset >= begin && field_offset < end) {
+      WriteField(image_page, begin, field_name,
+                 layout_.GetSchema().Type(field_name) == INTEGER
+                     ? Constant{GetInt(slot, field_name)}
+                     : Constant{GetString(slot, field_name)});
+    }
+  }
+  for (size_t i = 0; i < field_names.size(); i++) {
+    WriteField(image_page, begin, field_names[i], values[i]);
+  }
+  txn_.SetRow(page_, Offset(slot) + begin, image, RowOp::UPDATE, true);
+}
+
+void RecordPage::Delete(int slot) {
+  char image[sizeof(int)];
+  Page{image, sizeof(image)}.SetInt(0, EMPTY);
+  LockForWrite(slot);
+  txn_.SetRow(page_, Offset(slot), image, RowOp::DELETE, true);
+}
 
 void RecordPage::Format() {
+  // The block was just appended, so the ExclusiveLock on the end of the file
+  // keeps other transactions from reaching it
   int slot = 0;
   while (IsValidSlot(slot)) {
-    txn_.SetInt(block_, Offset(slot), EMPTY, false);
+    txn_.SetInt(page_, Offset(slot), EMPTY, false);
     auto& schema = layout_.GetSchema();
     for (const auto& field_name : schema.Fields()) {
       int field_pos = Offset(slot) + layout_.GetOffset(field_name);
       if (schema.Type(field_name) == INTEGER) {
-        txn_.SetInt(block_, field_pos, 0, false);
+        txn_.SetInt(page_, field_pos, 0, false);
       } else {  // VARCHAR
-        txn_.SetString(block_, field_pos, "", false);
+        txn_.SetString(page_, field_pos, "", false);
       }
     }
     slot++;
   }
 }
 
-int RecordPage::NextAfter(int slot) { return SearchAfter(slot, USED); }
+int RecordPage::NextAfter(int slot) {
+  if (txn_.IsSnapshot()) {
+    for (slot++; IsValidSlot(slot); slot++) {
+      if (Page{VisibleImage(slot).data(), sizeof(int)}.GetInt(0) == USED) {
+        return slot;
+      }
+    }
+    return -1;
+  }
+  if (txn_.IsOptimistic()) {
+    // Empty slots are read too, so that an insert into one of them by
+    // another transaction fails validation
+    for (slot++; IsValidSlot(slot); slot++) {
+      LockForRead(slot);
+      if (ReadFlag(slot) == USED) {
+        return slot;
+      }
+    }
+    return -1;
+  }
+  for (slot++; IsValidSlot(slot); slot++) {
+    // A transaction that holds an ExclusiveLock on an empty slot may be
+    // inserting into it, or may roll back a deletion; wait until it is done
+    if (ReadFlag(slot) == USED ||
+        txn_.IsRecordExclusivelyLocked(block_, slot)) {
+      LockForRead(slot);
+      if (ReadFlag(slot) == USED) {
+        return slot;
+      }
+    }
+  }
+  return -1;
+}
 
 int RecordPage::InsertAfter(int slot) {
-  int new_slot = SearchAfter(slot, EMPTY);
+  int new_slot = SearchEmpty(slot);
   if (new_slot >= 0) {
     SetFlag(new_slot, USED);
   }
   return new_slot;
 }
 
+int RecordPage::InsertAfter(int slot,
+                            const std::vector<std::string>& field_names,
+                            const std::vector<Constant>& values,
+                            bool OkToLog) {
+  int new_slot = SearchEmpty(slot);
+  if (new_slot < 0) {
+    return new_slot;
+  }
+  LockForWrite(new_slot);
+  std::vector<char> image(layout_.SlotSize());
+  Page image_page{image.data(), image.size()};
+  image_page.SetInt(0, USED);
+  for (size_t i = 0; i < field_names.size(); i++) {
+    WriteField(image_page, 0, field_names[i], values[i]);
+  }
+  txn_.SetRow(page_, Offset(new_slot), image, RowOp::INSERT, OkToLog);
+
+  return new_slot;
+}
+
 void RecordPage::SetFlag(int slot, int flag) {
-  txn_.SetInt(block_, Offset(slot), flag, true);
+  LockForWrite(slot);
+  txn_.SetInt(page_, Offset(slot), flag, true);
 }
 
-int RecordPage::SearchAfter(int slot, int flag) {
-  slot++;
-  while (IsValidSlot(slot)) {
-    if (txn_.GetInt(block_, Offset(slot)) == flag) {
+int RecordPage::SearchEmpty(int slot) {
+  for (slot++; IsValidSlot(slot); slot++) {
+    // Slots locked by other transactions are skipped rather than waited for.
+    // Once locked, the slot is read again, since another transaction may have
+    // filled it in between.
+    if (ReadFlag(slot) == EMPTY && txn_.TryExclusiveLockRecord(block_, slot) &&
+        ReadFlag(slot) == EMPTY) {
       return slot;
     }
-    slot++;
   }
   return -1;
 }
+
+void RecordPage::LockForRead(int slot) {
+  // Locks are held until the transaction ends, so a slot that is already
+  // locked needs no trip to the lock table
+  if (slot != read_slot_ && slot != write_slot_) {
+    txn_.SharedLockRecord(block_, slot);
+    read_slot_ = slot;
+  }
+}
+
+void RecordPage::LockForWrite(int slot) {
+  if (slot == write_slot_) {
+    return;
+  }
+  txn_.ExclusiveLockRecord(block_, slot);
+  txn_.SaveVersion(block_, slot, Offset(slot), layout_.SlotSize());
+  write_slot_ = slot;
+}
+
+std::vector<char>& RecordPage::VisibleImage(int slot) {
+  // The version that a snapshot sees never changes, so it is read once
+  if (visible_slot_ != slot) {
+    visible_image_.resize(layout_.SlotSize());
+    txn_.ReadVersion(block_, slot, Offset(slot), visible_image_);
+    visible_slot_ = slot;
+  }
+  return visible_image_;
+}
+
+int RecordPage::ReadFlag(int slot) {
+  return txn_.GetInt(page_, Offset(slot));
+}
+
+void RecordPage::WriteField(Page& image, int image_pos,
+                            std::string_view field_name,
+                            const Constant& val) const {
+  int field_pos = layout_.GetOffset(field_name) - image_pos;
+  if (layout_.GetSchema().Type(field_name) == INTEGER) {
+    image.SetInt(field_pos, val.AsInt());
+  } else {
+    image.SetString(field_pos, val.AsString());
+  }
+}
+
+int RecordPage::FieldSize(std::string_view field_name) const {
+  // Fields are laid out back to back, so a field ends where the next one
+  // starts
+  int field_pos = layout_.GetOffset(field_name);
+  int next_pos = layout_.SlotSize();
+  for (const auto& other : layout_.GetSchema().Fields()) {
+    int other_pos = layout_.GetOffset(other);
+    if (other_pos > field_pos) {
+      next_pos = std::min(next_pos, other_pos);
+    }
+  }
+  return next_pos - field_pos;
+}
 }  // namespace simpledb
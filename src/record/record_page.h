@@ -1,11 +1,21 @@
 #pragma once
 
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "file/page.h"
+#include "query/constant.h"
 #include "record/layout.h"
 #include "txn/transaction.h"
 
 namespace simpledb {
 /**
- * Store a record at a given location in a block
+ * Store a record at a given location in a block. Records are locked one at a
+ * time: reading a record takes a SharedLock on it and changing it takes an
+ * ExclusiveLock, so transactions can work on different records of the same
+ * block concurrently. Snapshot transactions lock nothing and read the version
+ * of each record that their snapshot sees.
  */
 class RecordPage {
  public:
@@ -18,6 +28,7 @@ class RecordPage {
   RecordPage(Transaction& txn, const BlockId& block, Layout& layout)
       : txn_(txn), block_(block), layout_(layout) {
     txn_.Pin(block_);
+    page_ = txn_.GetHandle(block_);
   }
 
   /**
@@ -54,6 +65,16 @@ class RecordPage {
    */
   void SetString(int slot, std::string_view field_name, std::string_view val);
 
+  /**
+   * @brief Store new values for several fields of the specified slot. The
+   * update is logged as a single row record covering the changed fields.
+   * @param slot the record slot to store values at
+   * @param field_names names of the fields to change
+   * @param values the new values of those fields
+   */
+  void Update(int slot, const std::vector<std::string>& field_names,
+              const std::vector<Constant>& values);
+
   /**
    * @brief Delete a record at the specified slot
    * @param slot the slot to delete
@@ -67,7 +88,8 @@ class RecordPage {
   void Format();
 
   /**
-   * @brief Return the next used slot after the specified slot
+   * @brief Return the next used slot after the specified slot. The record in
+   * that slot is locked with a SharedLock.
    * @param slot the starting slot to begin searching
    * @return the next used slot
    */
@@ -80,6 +102,19 @@ class RecordPage {
    */
   int InsertAfter(int slot);
 
+  /**
+   * @brief Insert a new record with the specified field values into the first
+   * empty slot after the specified slot. The flag and all fields are written
+   * and logged as a single row record. Fields without a value are zeroed.
+   * @param slot the starting slot to begin searching
+   * @param field_names names of the fields to set
+   * @param values the values of those fields
+   * @param OkToLog whether to log the insertion
+   * @return slot of the newly-inserted record, or -1 if the page is full
+   */
+  int InsertAfter(int slot, const std::vector<std::string>& field_names,
+                  const std::vector<Constant>& values, bool OkToLog = true);
+
   /**
    * @brief Return a reference to the disk block underlying this record page
    * @return a reference to the disk block
@@ -95,12 +130,59 @@ class RecordPage {
   void SetFlag(int slot, int flag);
 
   /**
-   * @brief Search for a slot with the specified flag
+   * @brief Search for an empty slot that no other transaction has locked, and
+   * lock it with an ExclusiveLock
    * @param slot the starting slot to begin searching
-   * @param flag the flag to search for
-   * @return the id of the slot with the specified flag
+   * @return the id of the empty slot, or -1 if there is none
+   */
+  int SearchEmpty(int slot);
+
+  /**
+   * @brief Lock a record with a SharedLock before reading it, unless the
+   * record page has locked it already
+   * @param slot the slot of the record
+   */
+  void LockForRead(int slot);
+
+  /**
+   * @brief Lock a record exclusively before changing it, and save its current
+   * version for snapshot transactions, unless the record page has done so
+   * already
+   * @param slot the slot of the record
+   */
+  void LockForWrite(int slot);
+
+  /**
+   * @brief Return the image of the specified slot that the snapshot of the
+   * transaction sees. The image stays valid until another slot is read.
+   * @param slot the record slot
+   * @return the bytes of the record slot
+   */
+  std::vector<char>& VisibleImage(int slot);
+
+  /**
+   * @brief Read the flag of the specified slot without locking it
+   * @param slot the slot to read its flag
+   * @return the flag of the slot
+   */
+  int ReadFlag(int slot);
+
+  /**
+   * @brief Write a field value into an image of part of a slot
+   * @param image a page view over the image
+   * @param image_pos offset of the image within the slot
+   * @param field_name name of the field
+   * @param val the value to write
+   */
+  void WriteField(Page& image, int image_pos, std::string_view field_name,
+                  const Constant& val) const;
+
+  /**
+   * @brief Return the number of bytes that a field occupies in a slot
+   * @param field_name name of the field
+   * @return the size of the field in bytes
    */
-  int SearchAfter(int slot, int flag);
+  int FieldSize(std::string_view field_name) const;
 
   /**
    * @brief Return whether the specified slot is within this block
@@ -121,6 +203,12 @@ class RecordPage {
   Transaction& txn_;
   BlockId block_;
   Layout& layout_;
+  PageHandle page_;
+  // the last slots locked for reading and for writing
+  int read_slot_{-1};
+  int write_slot_{-1};
+  std::vector<char> visible_image_;
+  int visible_slot_{-1};
   enum Flag { EMPTY, USED };
 };
 }  // namespace simpledb
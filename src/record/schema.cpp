@@ -1,4 +1,7 @@
 #include "record/schema.h"
+
+#include <stdexcept>
+
 #include "utils/data_type.h"
 
 namespace simpledb {
@@ -4,7 +4,9 @@ namespace simpledb {
 TableScan::TableScan(Transaction& txn, std::string_view table_name,
                      Layout& layout)
     : txn_(txn), layout_(layout), filename_(std::string(table_name) + ".tbl") {
-  if (txn_.Size(filename_) == 0) {
+  // A snapshot transaction cannot append, and an empty file reads as an
+  // empty block
+  if (txn_.Size(filename_) == 0 && !txn_.IsSnapshot()) {
     MoveToNewBlock();
   } else {
     MoveToBlock(0);
@@ -14,6 +16,15 @@ TableScan::TableScan(Transaction& txn, std::string_view table_name,
 void TableScan::BeforeFirst() { MoveToBlock(0); }
 
 bool TableScan::Next() {
+  // A read-only transaction reads the whole table through its scan, so one
+  // SharedLock on the file replaces its record locks. A transaction that may
+  // write locks records under intention locks instead: its first write would
+  // turn a SharedLock on the file into SIX, which blocks every other writer
+  // of the table. Escalation still bounds the number of its record locks.
+  if (!table_locked_ && txn_.IsReadOnly()) {
+    txn_.SharedLockFile(filename_);
+    table_locked_ = true;
+  }
   current_slot_ = record_page_.value().NextAfter(current_slot_);
   while (current_slot_ < 0) {
     if (AtLastBlock()) {
@@ -79,6 +90,26 @@ void TableScan::Insert() {
   }
 }
 
+void TableScan::InsertRow(const std::vector<std::string>& field_names,
+                          const std::vector<Constant>& values) {
+  current_slot_ =
+      record_page_.value().InsertAfter(current_slot_, field_names, values);
+  while (current_slot_ < 0) {
+    if (AtLastBlock()) {
+      MoveToNewBlock();
+    } else {
+      MoveToBlock(record_page_.value().Block().BlockNumber() + 1);
+    }
+    current_slot_ =
+        record_page_.value().InsertAfter(current_slot_, field_names, values);
+  }
+}
+
+void TableScan::UpdateRow(const std::vector<std::string>& field_names,
+                          const std::vector<Constant>& values) {
+  record_page_.value().Update(current_slot_, field_names, values);
+}
+
 void TableScan::Delete() { record_page_.value().Delete(current_slot_); }
 
 void TableScan::MoveToRID(const RID& rid) {
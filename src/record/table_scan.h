@@ -2,6 +2,7 @@
 
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "query/constant.h"
 #include "query/update_scan.h"
@@ -13,7 +14,10 @@
 
 namespace simpledb {
 /**
- * Provide the abstraction of an arbitrarily large array of records
+ * Provide the abstraction of an arbitrarily large array of records. A scan of
+ * a read-only transaction that steps through the records with `Next()` locks
+ * the whole table once, instead of each record it reads. Other scans, and
+ * records reached through `MoveToRID`, lock records one at a time.
  */
 class TableScan final : public UpdateScan {
  public:
@@ -105,6 +109,25 @@ class TableScan final : public UpdateScan {
    */
   void Insert() override;
 
+  /**
+   * @brief Insert a new record with the specified field values somewhere in the
+   * table and move the scan to it. The record is logged as a single row
+   * record.
+   * @param field_names names of the fields to set
+   * @param values the values of those fields
+   */
+  void InsertRow(const std::vector<std::string>& field_names,
+                 const std::vector<Constant>& values) override;
+
+  /**
+   * @brief Modify several field values of the current record, logged as a
+   * single row record
+   * @param field_names names of the fields to change
+   * @param values the new values of those fields
+   */
+  void UpdateRow(const std::vector<std::string>& field_names,
+                 const std::vector<Constant>& values) override;
+
   /**
    * @brief Delete the current record from the table
    */
@@ -142,7 +165,7 @@ class TableScan final : public UpdateScan {
    * @return true if the scan is in the last block; otherwise, false
    */
   bool AtLastBlock() {
-    return record_page_.value().Block().BlockNumber() ==
+    return record_page_.value().Block().BlockNumber() >=
            txn_.Size(filename_) - 1;
   }
 
@@ -151,5 +174,6 @@ class TableScan final : public UpdateScan {
   std::optional<RecordPage> record_page_;
   std::string filename_;
   int current_slot_{-1};
+  bool table_locked_{};
 };
 }  // namespace simpledb
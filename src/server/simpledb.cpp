@@ -1,6 +1,9 @@
 #include "server/simpledb.h"
 
+#include <exception>
 #include <iostream>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
 #include <string_view>
 #include <utility>
 
@@ -10,23 +13,47 @@
 #include "plan/basic_update_planner.h"
 #include "plan/query_planner.h"
 #include "plan/update_planner.h"
+#include "txn/recovery/recovery_manager.h"
 #include "txn/transaction.h"
 
 namespace simpledb {
 Transaction SimpleDB::NewTxn() noexcept {
-  return Transaction{file_manager_, log_manager_, buffer_manager_};
+  return Transaction{file_manager_, log_manager_, buffer_manager_,
+                     commit_policy_};
+}
+
+Transaction SimpleDB::NewTxn(int start_ts) noexcept {
+  return Transaction{file_manager_, log_manager_, buffer_manager_,
+                     commit_policy_, TxnMode::LOCKING, false, start_ts};
+}
+
+Transaction SimpleDB::NewSnapshotTxn() {
+  return Transaction{file_manager_, log_manager_, buffer_manager_,
+                     commit_policy_, TxnMode::SNAPSHOT};
+}
+
+Transaction SimpleDB::NewOptimisticTxn() noexcept {
+  return Transaction{file_manager_, log_manager_, buffer_manager_,
+                     commit_policy_, TxnMode::OPTIMISTIC};
+}
+
+Transaction SimpleDB::NewReadOnlyTxn() noexcept {
+  auto mode =
+      Transaction::MultiVersion() ? TxnMode::SNAPSHOT : TxnMode::LOCKING;
+  return Transaction{file_manager_, log_manager_, buffer_manager_,
+                     commit_policy_, mode, true};
 }
 
 SimpleDB::SimpleDB(std::string_view dirname)
     : SimpleDB(dirname, BLOCK_SIZE, BUFFER_SIZE) {
-  auto txn = NewTxn();
   bool is_new = file_manager_.IsNew();
   if (is_new) {
     std::cout << "Creating new database\n";
   } else {
     std::cout << "Recovering existing database\n";
-    txn.Recover();
+    Recover();
   }
+  auto txn = NewTxn();
   metadata_manager_ = std::make_unique<MetadataManager>(is_new, txn);
   std::unique_ptr<QueryPlanner> query_planner =
       std::make_unique<BasicQueryPlanner>(*metadata_manager_);
@@ -40,4 +67,44 @@ SimpleDB::SimpleDB(std::string_view dirname)
   txn.Commit();
 }
 
+SimpleDB::~SimpleDB() {
+  if (recovery_thread_.joinable()) {
+    recovery_thread_.join();
+  }
+}
+
+void SimpleDB::WaitForRecovery() {
+  if (recovery_thread_.joinable()) {
+    recovery_thread_.join();
+  }
+  if (recovery_error_) {
+    std::rethrow_exception(std::exchange(recovery_error_, nullptr));
+  }
+}
+
+void SimpleDB::Recover() {
+  // Transaction ids restart at each run: the recovering transaction must not
+  // take the id of a transaction that it rolls back
+  Transaction::ReserveTxnIds(RecoveryManager::MaxTxnId(log_manager_));
+  recovery_txn_ = std::make_unique<Transaction>(file_manager_, log_manager_,
+                                                buffer_manager_);
+  if (!RecoveryManager::OnDemandRecovery()) {
+    recovery_txn_->Recover();
+    recovery_txn_->Commit();
+    recovery_txn_.reset();
+    return;
+  }
+  recovery_txn_->RecoverOnDemand();
+  recovery_thread_ = std::thread{[this] {
+    // An exception must not escape the thread, which would terminate the
+    // process; it is handed to `WaitForRecovery` instead
+    try {
+      recovery_txn_->CompleteRecovery();
+      recovery_txn_->Commit();
+    } catch (...) {
+      recovery_error_ = std::current_exception();
+    }
+  }};
+}
+
 }  // namespace simpledb
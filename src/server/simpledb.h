@@ -1,7 +1,9 @@
 #pragma once
 
+#include <exception>
 #include <memory>
 #include <string_view>
+#include <thread>  // NOLINT(build/c++11)
 
 #include "buffer/buffer_manager.h"
 #include "file/file_manager.h"
@@ -35,6 +37,23 @@ class SimpleDB {
    */
   explicit SimpleDB(std::string_view dirname);
 
+  SimpleDB(const SimpleDB&) = delete;
+  SimpleDB& operator=(const SimpleDB&) = delete;
+
+  /**
+   * @brief Wait for a background recovery to finish before shutting down. An
+   * error of the recovery that nobody waited for is dropped.
+   */
+  ~SimpleDB();
+
+  /**
+   * @brief Wait until the recovery of an existing database is complete. With
+   * on-demand recovery, the constructor returns once the log is analyzed, and
+   * the rest of the recovery runs in the background.
+   * @throw the exception that stopped the background recovery, if any
+   */
+  void WaitForRecovery();
+
   /**
    * @brief A convenient way for clients to create transactions and access the
    * metadata
@@ -42,6 +61,51 @@ class SimpleDB {
    */
   Transaction NewTxn() noexcept;
 
+  /**
+   * @brief Create a transaction that retries an aborted one. It keeps the
+   * start timestamp of the aborted transaction, so that the deadlock policy
+   * treats it as old as the first attempt, and it is not aborted again and
+   * again for being the youngest.
+   * @param start_ts the start timestamp of the aborted transaction (see
+   * `Transaction::StartTimestamp`)
+   * @return a new transaction
+   */
+  Transaction NewTxn(int start_ts) noexcept;
+
+  /**
+   * @brief Create a read-only transaction that sees the database as it was
+   * committed when the transaction started, without locking what it reads.
+   * The multi-version mode must be on (see `Transaction::SetMultiVersion`).
+   * @return a new snapshot transaction
+   */
+  Transaction NewSnapshotTxn();
+
+  /**
+   * @brief Create a transaction that takes no locks and is validated at
+   * commit instead (see `TxnMode::OPTIMISTIC`). Its operations and its commit
+   * throw a `LockAbortException` when it conflicts with another transaction.
+   * @return a new optimistic transaction
+   */
+  Transaction NewOptimisticTxn() noexcept;
+
+  /**
+   * @brief Create a transaction that only reads. It writes no log records and
+   * flushes nothing at commit. In the multi-version mode it reads a snapshot
+   * and takes no locks; otherwise, it takes shared locks like any other
+   * transaction, since reading without them could see uncommitted changes.
+   * @return a new read-only transaction
+   */
+  Transaction NewReadOnlyTxn() noexcept;
+
+  /**
+   * @brief Choose how transactions created by `NewTxn()` make their changes
+   * durable at commit (see `CommitPolicy`)
+   * @param commit_policy the commit policy of new transactions
+   */
+  void SetCommitPolicy(CommitPolicy commit_policy) noexcept {
+    commit_policy_ = commit_policy;
+  }
+
   /**
    * @brief Get the metadata manager
    * @return a reference to the metadata manager
@@ -74,6 +138,13 @@ class SimpleDB {
   BufferManager& GetBufferManager() noexcept { return buffer_manager_; }
 
  private:
+  /**
+   * @brief Recover the database, either completely or, if on-demand recovery
+   * is enabled, up to the log analysis, leaving the rest to a background
+   * thread
+   */
+  void Recover();
+
   static constexpr std::string_view LOG_FILE{"simpledb.log"};
   static constexpr int BLOCK_SIZE{400};
   static constexpr int BUFFER_SIZE{8};
@@ -83,5 +154,9 @@ class SimpleDB {
   BufferManager buffer_manager_;
   std::unique_ptr<MetadataManager> metadata_manager_;
   Planner planner_;
+  CommitPolicy commit_policy_{CommitPolicy::FORCE};
+  std::unique_ptr<Transaction> recovery_txn_;
+  std::thread recovery_thread_;
+  std::exception_ptr recovery_error_;  // set by the recovery thread
 };
 }  // namespace simpledb
@@ -1,9 +1,15 @@
 #include "txn/buffer_list.h"
 
+#include <utility>
+
 #include "buffer/buffer.h"
 #include "file/block_id.h"
 
 namespace simpledb {
+BufferList::~BufferList() {
+  TablePool<BufferMap>::Release(std::move(buffers_));
+}
+
 Buffer* BufferList::GetBuffer(const BlockId& block) const noexcept {
   if (!buffers_.contains(block)) {
     return nullptr;
@@ -6,6 +6,7 @@
 #include "buffer/buffer.h"
 #include "buffer/buffer_manager.h"
 #include "file/block_id.h"
+#include "utils/table_pool.h"
 
 namespace simpledb {
 /**
@@ -13,13 +14,22 @@ namespace simpledb {
  */
 class BufferList {
  public:
+  using BufferMap = std::unordered_map<BlockId, std::pair<Buffer*, int>>;
+
   /**
    * @brief Construct a new buffer list that holds the transaction's
    * currently-pinned buffers
    * @param buffer_manager buffer manager of the database engine
    */
   explicit BufferList(BufferManager& buffer_manager)
-      : buffer_manager_(buffer_manager) {}
+      : buffers_(TablePool<BufferMap>::Acquire()),
+        buffer_manager_(buffer_manager) {}
+
+  /**
+   * @brief Return the buffer map to the pool, so that the next transaction
+   * reuses it
+   */
+  ~BufferList();
 
   /**
    * @brief Return the buffer pinned to the specified block. The method returns
@@ -47,7 +57,7 @@ class BufferList {
   void UnpinAll();
 
  private:
-  std::unordered_map<BlockId, std::pair<Buffer*, int>> buffers_;
+  BufferMap buffers_;
   BufferManager& buffer_manager_;
 };
 }  // namespace simpledb
@@ -1,32 +1,179 @@
 #include "txn/concurrency/concurrency_manager.h"
 
+#include <utility>
+
 namespace simpledb {
 // Define class static variable
 LockTable ConcurrencyManager::lock_table_{};
 
+ConcurrencyManager::~ConcurrencyManager() {
+  TablePool<LockCache>::Release(std::move(locks_));
+}
+
+void ConcurrencyManager::SharedLockFile(std::string_view filename) {
+  Lock({locks_.FileId(filename)}, LockMode::S);
+}
+
 void ConcurrencyManager::SharedLock(const BlockId& block) {
-  if (!locks_.contains(block)) {
-    lock_table_.SharedLock(block);
-    locks_.emplace(block, "S");
+  int file = locks_.FileId(block.Filename());
+  if (!Covers({file}, LockMode::S)) {
+    Lock({file}, LockMode::IS);
+    Lock({file, block.BlockNumber()}, LockMode::S);
+    MaybeEscalate(file);
   }
 }
 
 void ConcurrencyManager::ExclusiveLock(const BlockId& block) {
-  if (!HasExclusiveLock(block)) {
-    SharedLock(block);
-    lock_table_.ExclusiveLock(block);
-    locks_[block] = "X";
+  int file = locks_.FileId(block.Filename());
+  if (!Covers({file}, LockMode::X)) {
+    Lock({file}, LockMode::IX);
+    Lock({file, block.BlockNumber()}, LockMode::X);
+    MaybeEscalate(file);
   }
 }
 
-void ConcurrencyManager::Release() {
-  for (const auto& [block, _] : locks_) {
-    lock_table_.Unlock(block);
+void ConcurrencyManager::SharedLock(const BlockId& block, int slot) {
+  int file = locks_.FileId(block.Filename());
+  LockCache::Key page{file, block.BlockNumber()};
+  if (!Covers({file}, LockMode::S) && !Covers(page, LockMode::S)) {
+    Lock({file}, LockMode::IS);
+    Lock(page, LockMode::IS);
+    Lock({file, block.BlockNumber(), slot}, LockMode::S);
+    MaybeEscalate(file);
   }
+}
+
+void ConcurrencyManager::ExclusiveLock(const BlockId& block, int slot) {
+  int file = locks_.FileId(block.Filename());
+  LockCache::Key page{file, block.BlockNumber()};
+  if (!Covers({file}, LockMode::X) && !Covers(page, LockMode::X)) {
+    Lock({file}, LockMode::IX);
+    Lock(page, LockMode::IX);
+    Lock({file, block.BlockNumber(), slot}, LockMode::X);
+    MaybeEscalate(file);
+  }
+}
+
+bool ConcurrencyManager::TryExclusiveLock(const BlockId& block, int slot) {
+  int file = locks_.FileId(block.Filename());
+  LockCache::Key page{file, block.BlockNumber()};
+  if (Covers({file}, LockMode::X) || Covers(page, LockMode::X)) {
+    return true;
+  }
+  Lock({file}, LockMode::IX);
+  Lock(page, LockMode::IX);
+  if (!TryLock({file, block.BlockNumber(), slot}, LockMode::X)) {
+    return false;
+  }
+  MaybeEscalate(file);
+  return true;
+}
+
+bool ConcurrencyManager::TryExclusiveLockNoWait(const BlockId& block) {
+  int file = locks_.FileId(block.Filename());
+  return Covers({file}, LockMode::X) ||
+         (TryLock({file}, LockMode::IX) &&
+          TryLock({file, block.BlockNumber()}, LockMode::X));
+}
+
+bool ConcurrencyManager::TryExclusiveLockNoWait(const BlockId& block,
+                                                int slot) {
+  int file = locks_.FileId(block.Filename());
+  LockCache::Key page{file, block.BlockNumber()};
+  return Covers({file}, LockMode::X) || Covers(page, LockMode::X) ||
+         (TryLock({file}, LockMode::IX) && TryLock(page, LockMode::IX) &&
+          TryLock({file, block.BlockNumber(), slot}, LockMode::X));
+}
+
+bool ConcurrencyManager::IsWriteLocked(const BlockId& block) {
+  // An enclosing item is in the way only if it is locked as a whole
+  return lock_table_.Conflicts(LockId{block.Filename()}, owner_.txn_id,
+                               LockMode::IS) ||
+         lock_table_.Conflicts(LockId{block}, owner_.txn_id, LockMode::S);
+}
+
+bool ConcurrencyManager::IsWriteLocked(const BlockId& block, int slot) {
+  return lock_table_.Conflicts(LockId{block.Filename()}, owner_.txn_id,
+                               LockMode::IS) ||
+         lock_table_.Conflicts(LockId{block}, owner_.txn_id, LockMode::IS) ||
+         lock_table_.Conflicts(LockId{block, slot}, owner_.txn_id,
+                               LockMode::S);
+}
+
+bool ConcurrencyManager::IsExclusivelyLocked(const BlockId& block, int slot) {
+  return lock_table_.Conflicts(LockId{block, slot}, owner_.txn_id,
+                               LockMode::S);
+}
+
+void ConcurrencyManager::AwaitExclusiveLock(const BlockId& block) {
+  LockId id{block};
+  lock_table_.Lock(id, owner_, LockMode::S);
+  lock_table_.Unlock(id, owner_.txn_id);
+}
+
+void ConcurrencyManager::Release(Lsn commit_lsn) {
+  lock_table_.UnlockAll(locks_.Ids(), owner_.txn_id, commit_lsn);
   locks_.clear();
+  dependency_lsn_ = INVALID_LSN;
+  LockTable::EndTxn(owner_);
+}
+
+void ConcurrencyManager::Lock(const LockCache::Key& key, LockMode mode) {
+  auto* held = locks_.Find(key);
+  if (held == nullptr) {
+    auto id = locks_.Id(key);
+    lock_table_.Lock(id, owner_, mode);
+    AddDependency(id);
+    locks_.Insert(key, mode);
+    return;
+  }
+  auto upgraded = Supremum(*held, mode);
+  if (upgraded != *held) {
+    auto id = locks_.Id(key);
+    lock_table_.Lock(id, owner_, upgraded);
+    AddDependency(id);
+    *held = upgraded;
+  }
 }
 
-bool ConcurrencyManager::HasExclusiveLock(const BlockId& block) const noexcept {
-  return locks_.contains(block) && locks_.at(block) == "X";
+bool ConcurrencyManager::TryLock(const LockCache::Key& key, LockMode mode) {
+  auto* held = locks_.Find(key);
+  if (held == nullptr) {
+    auto id = locks_.Id(key);
+    if (!lock_table_.TryLock(id, owner_, mode)) {
+      return false;
+    }
+    AddDependency(id);
+    locks_.Insert(key, mode);
+    return true;
+  }
+  auto upgraded = Supremum(*held, mode);
+  if (upgraded != *held) {
+    auto id = locks_.Id(key);
+    if (!lock_table_.TryLock(id, owner_, upgraded)) {
+      return false;
+    }
+    AddDependency(id);
+    *held = upgraded;
+  }
+  return true;
+}
+
+bool ConcurrencyManager::Covers(const LockCache::Key& key,
+                                LockMode mode) const {
+  const auto* held = locks_.Find(key);
+  return held != nullptr && Supremum(*held, mode) == *held;
+}
+
+void ConcurrencyManager::MaybeEscalate(int file) {
+  if (locks_.FineLocks(file) <= escalation_threshold_) {
+    return;
+  }
+  // An intention to lock exclusively means that some lock below is exclusive
+  auto held = *locks_.Find({file});
+  bool exclusive = held == LockMode::IX || held == LockMode::SIX ||
+                   held == LockMode::X;
+  Lock({file}, exclusive ? LockMode::X : LockMode::S);
+  lock_table_.UnlockAll(locks_.EraseFineLocks(file), owner_.txn_id);
 }
 }  // namespace simpledb
@@ -1,9 +1,14 @@
 #pragma once
 
-#include <string>
-#include <unordered_map>
+#include <algorithm>
+#include <string_view>
 
+#include "file/block_id.h"
+#include "txn/concurrency/lock_cache.h"
+#include "txn/concurrency/lock_id.h"
 #include "txn/concurrency/lock_table.h"
+#include "utils/data_type.h"
+#include "utils/table_pool.h"
 
 namespace simpledb {
 /**
@@ -11,42 +16,222 @@ namespace simpledb {
  * concurrency manager. The concurrency manager keeps track of which locks the
  * transaction currently has, and interacts with the global lock table as
  * needed.
+ *
+ * Locks are taken on files, blocks, or records. Each lock is preceded by
+ * intention locks on the enclosing file and block, and is not needed at all
+ * if a lock on an enclosing item already covers it. Once a transaction holds
+ * more than a threshold of block and record locks in a file, they are
+ * escalated to a single lock on the file.
  */
 class ConcurrencyManager {
  public:
+
+  /**
+   * @brief Create the concurrency manager of a transaction
+   * @param txn_id id of the transaction
+   * @param start_ts the start timestamp that orders the transaction against
+   * the others when deadlocks are prevented (see `LockOwner`)
+   */
+  ConcurrencyManager(int txn_id, int start_ts)
+      : owner_{txn_id, start_ts},
+        locks_(TablePool<LockCache>::Acquire()) {}
+
+  /**
+   * @brief Return the lock table of the transaction to the pool, so that the
+   * next transaction reuses them
+   */
+  ~ConcurrencyManager();
+
+  /**
+   * @brief Obtain a SharedLock on a whole file, which covers all its blocks
+   * and records
+   * @param filename name of the file
+   */
+  void SharedLockFile(std::string_view filename);
+
   /**
    * @brief Obtain a SharedLock on the block, if necessary. The method will ask
    * the lock table for a SharedLock if the transaction currently has no locks
-   * on that block.
+   * on that block, after an IS lock on its file.
    * @param block a reference to the disk block
    */
   void SharedLock(const BlockId& block);
 
   /**
    * @brief Obtain an ExclusiveLock on the block, if necessary. If the
-   * transaction does not have an ExclusiveLock on that block, then the method
-   * first gets a SharedLock on that block (if necessary) and then upgrades it
-   * to an ExclusiveLock.
+   * transaction already holds a weaker lock on that block, the lock is
+   * upgraded to an ExclusiveLock. An IX lock on its file is taken first.
    * @param block a reference to the disk block
    */
   void ExclusiveLock(const BlockId& block);
 
   /**
-   * @brief Release all locks held by the transaction
+   * @brief Obtain a SharedLock on a record, after IS locks on its file and
+   * block
+   * @param block a reference to the disk block that holds the record
+   * @param slot the slot of the record
    */
-  void Release();
+  void SharedLock(const BlockId& block, int slot);
+
+  /**
+   * @brief Obtain an ExclusiveLock on a record, after IX locks on its file
+   * and block
+   * @param block a reference to the disk block that holds the record
+   * @param slot the slot of the record
+   */
+  void ExclusiveLock(const BlockId& block, int slot);
+
+  /**
+   * @brief Obtain an ExclusiveLock on a record only if no other transaction
+   * holds a lock on it. The IX locks on its file and block may still be
+   * waited for.
+   * @param block a reference to the disk block that holds the record
+   * @param slot the slot of the record
+   * @return true if the lock was obtained; otherwise, false
+   */
+  bool TryExclusiveLock(const BlockId& block, int slot);
+
+  /**
+   * @brief Obtain an ExclusiveLock on the block, after an IX lock on its
+   * file, only if neither has to be waited for. Optimistic transactions lock
+   * what they change this way, so that they never wait. Their locks are not
+   * escalated, since that could wait.
+   * @param block a reference to the disk block
+   * @return true if the lock was obtained; otherwise, false
+   */
+  bool TryExclusiveLockNoWait(const BlockId& block);
+
+  /**
+   * @brief Obtain an ExclusiveLock on a record, after IX locks on its file
+   * and block, only if none of them has to be waited for (see
+   * `TryExclusiveLockNoWait(const BlockId&)`)
+   * @param block a reference to the disk block that holds the record
+   * @param slot the slot of the record
+   * @return true if the lock was obtained; otherwise, false
+   */
+  bool TryExclusiveLockNoWait(const BlockId& block, int slot);
+
+  /**
+   * @brief Return whether another transaction holds a lock that keeps the
+   * block from being read, i.e., an ExclusiveLock on the block or its file,
+   * or an intention to change some of its records
+   * @param block a reference to the disk block
+   * @return true if the block may be being changed; otherwise, false
+   */
+  bool IsWriteLocked(const BlockId& block);
+
+  /**
+   * @brief Return whether another transaction holds an ExclusiveLock on a
+   * record or on its block or file, e.g., a transaction changing the record
+   * or a restart rolling the block back
+   * @param block a reference to the disk block that holds the record
+   * @param slot the slot of the record
+   * @return true if the record may be being changed; otherwise, false
+   */
+  bool IsWriteLocked(const BlockId& block, int slot);
 
- private:
   /**
-   * @brief Return whether the transaction is holding an exclusive lock
+   * @brief Return whether another transaction holds an ExclusiveLock on a
+   * record, i.e., whether it may be changing the record
+   * @param block a reference to the disk block that holds the record
+   * @param slot the slot of the record
+   * @return true if the record is locked by another writer; otherwise, false
+   */
+  bool IsExclusivelyLocked(const BlockId& block, int slot);
+
+  /**
+   * @brief Wait until no other transaction holds an ExclusiveLock on the
+   * block, without keeping a lock: a SharedLock on the block is taken and
+   * released at once. The transaction must hold no lock on the block.
    * @param block a reference to the disk block
-   * @return true if the transaction holds the exclusive lock; otherwise, false
    */
-  bool HasExclusiveLock(const BlockId& block) const noexcept;
+  void AwaitExclusiveLock(const BlockId& block);
+
+  /**
+   * @brief Release all locks held by the transaction in one batch, taking
+   * the latch of each stripe of the lock table once
+   * @param commit_lsn the LSN of the transaction's COMMIT record if it may
+   * not be durable yet; otherwise, `INVALID_LSN`
+   */
+  void Release(Lsn commit_lsn = INVALID_LSN);
+
+  /**
+   * @brief Return how far the log must be durable before the transaction may
+   * report what it read: the latest COMMIT record of the transactions that
+   * released, before that record was durable, a lock it then took
+   * @return the LSN, or `INVALID_LSN` if the transaction depends on none
+   */
+  Lsn DependencyLsn() const noexcept { return dependency_lsn_; }
+
+  /**
+   * @brief Choose how the global lock table prevents or resolves deadlocks
+   * @param policy the deadlock policy
+   */
+  static void SetDeadlockPolicy(DeadlockPolicy policy) noexcept {
+    lock_table_.SetDeadlockPolicy(policy);
+  }
+
+  /**
+   * @brief Set the number of block and record locks that a transaction may
+   * hold in a file before they are escalated to a lock on the file
+   * @param threshold the number of locks
+   */
+  static void SetEscalationThreshold(int threshold) noexcept {
+    escalation_threshold_ = threshold;
+  }
+
+ private:
+  /**
+   * @brief Obtain a lock in the specified mode, or upgrade the lock that the
+   * transaction holds, unless the held mode already grants the requested one
+   * @param key the locked item
+   * @param mode the requested mode
+   */
+  void Lock(const LockCache::Key& key, LockMode mode);
+
+  /**
+   * @brief Obtain or upgrade a lock as `Lock` does, only if this is possible
+   * without waiting
+   * @param key the locked item
+   * @param mode the requested mode
+   * @return true if the transaction holds the lock; otherwise, false
+   */
+  bool TryLock(const LockCache::Key& key, LockMode mode);
+
+  /**
+   * @brief Return whether the transaction holds a lock on an item that grants
+   * the specified mode on everything the item contains
+   * @param key the enclosing item
+   * @param mode S or X
+   * @return true if the lock on the item covers its contents; otherwise,
+   * false
+   */
+  bool Covers(const LockCache::Key& key, LockMode mode) const;
+
+  /**
+   * @brief Replace the block and record locks of a file by a single lock on
+   * the file, if the transaction holds more of them than the threshold. The
+   * file is locked exclusively if any of them is exclusive, and shared
+   * otherwise.
+   * @param file the file id
+   */
+  void MaybeEscalate(int file);
+
+  /**
+   * @brief Note the dependency on the transactions that released a lock
+   * that the transaction has just taken
+   * @param id the locked item
+   */
+  void AddDependency(const LockId& id) noexcept {
+    dependency_lsn_ = std::max(dependency_lsn_, lock_table_.CommitLsn(id));
+  }
 
   // The global lock table. This variable is static because all transactions
   // share the same table.
   static LockTable lock_table_;
-  std::unordered_map<BlockId, std::string> locks_;
+  static inline int escalation_threshold_ = 5000;
+  LockOwner owner_;
+  LockCache locks_;
+  Lsn dependency_lsn_{INVALID_LSN};
 };
 }  // namespace simpledb
@@ -0,0 +1,90 @@
+#include "txn/concurrency/lock_cache.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace simpledb {
+int LockCache::FileId(std::string_view filename) {
+  for (size_t i = 0; i < files_.size(); i++) {
+    if (files_[i].name == filename) {
+      return static_cast<int>(i);
+    }
+  }
+  files_.push_back(File{std::string{filename}});
+  return static_cast<int>(files_.size()) - 1;
+}
+
+void LockCache::Insert(const Key& key, LockMode mode) {
+  if ((size_ + 1) * 2 > entries_.size()) {
+    Grow();
+  }
+  Place(key, mode);
+  size_++;
+  if (key.block_num != LockId::NO_BLOCK) {
+    files_[key.file].fine_locks++;
+  }
+}
+
+std::vector<LockId> LockCache::EraseFineLocks(int file) {
+  // Linear probing cannot leave holes in a probe sequence, so the table is
+  // rebuilt from the locks that remain. Escalation is rare.
+  std::vector<LockId> erased;
+  std::vector<Entry> kept;
+  for (auto& entry : entries_) {
+    if (entry.key.file == EMPTY) {
+      continue;
+    }
+    if (entry.key.file == file && entry.key.block_num != LockId::NO_BLOCK) {
+      erased.push_back(Id(entry.key));
+    } else {
+      kept.push_back(entry);
+    }
+    entry = Entry{};
+  }
+  for (const auto& entry : kept) {
+    Place(entry.key, entry.mode);
+  }
+  size_ = kept.size();
+  files_[file].fine_locks = 0;
+  return erased;
+}
+
+std::vector<LockId> LockCache::Ids() const {
+  std::vector<LockId> ids;
+  ids.reserve(size_);
+  for (const auto& entry : entries_) {
+    if (entry.key.file != EMPTY) {
+      ids.push_back(Id(entry.key));
+    }
+  }
+  return ids;
+}
+
+void LockCache::clear() noexcept {
+  if (size_ > 0) {
+    std::fill(entries_.begin(), entries_.end(), Entry{});
+  }
+  size_ = 0;
+  files_.clear();
+}
+
+void LockCache::Place(const Key& key, LockMode mode) noexcept {
+  size_t mask = entries_.size() - 1;
+  size_t i = Hash(key) & mask;
+  while (entries_[i].key.file != EMPTY) {
+    i = (i + 1) & mask;
+  }
+  entries_[i] = Entry{key, mode};
+}
+
+void LockCache::Grow() {
+  auto old = std::exchange(
+      entries_, std::vector<Entry>(
+                    std::max(INITIAL_CAPACITY, entries_.size() * 2)));
+  for (const auto& entry : old) {
+    if (entry.key.file != EMPTY) {
+      Place(entry.key, entry.mode);
+    }
+  }
+}
+}  // namespace simpledb
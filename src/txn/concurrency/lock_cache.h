@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "txn/concurrency/lock_id.h"
+#include "txn/concurrency/lock_table.h"
+
+namespace simpledb {
+/**
+ * The locks that one transaction holds, in an open-addressing table with
+ * linear probing. The filenames are interned once per transaction, so that
+ * an item is keyed by three integers: a lock on a record hashes no string,
+ * and its three lookups (file, block, record) probe one flat array. A
+ * transaction locks only a few files, so a filename is interned by a linear
+ * search.
+ *
+ * `clear` and `bucket_count` follow the standard containers, so that the
+ * table can be kept in a `TablePool`.
+ */
+class LockCache {
+ public:
+  /**
+   * A locked item: the interned id of its file, and its block and slot as in
+   * `LockId`
+   */
+  struct Key {
+    int file;
+    int block_num{LockId::NO_BLOCK};
+    int slot{LockId::NO_SLOT};
+
+    bool operator==(const Key& other) const noexcept = default;
+  };
+
+  /**
+   * @brief Return the id of a file, interning its name if the transaction has
+   * not locked anything in it yet
+   * @param filename name of the file
+   * @return the file id
+   */
+  int FileId(std::string_view filename);
+
+  /**
+   * @brief Return the mode in which the transaction holds a lock
+   * @param key the locked item
+   * @return a pointer to the held mode, valid until the next insertion or
+   * erasure, or nullptr if the item is not locked
+   */
+  LockMode* Find(const Key& key) noexcept {
+    if (entries_.empty()) {
+      return nullptr;
+    }
+    size_t mask = entries_.size() - 1;
+    for (size_t i = Hash(key) & mask;; i = (i + 1) & mask) {
+      auto& entry = entries_[i];
+      if (entry.key.file == EMPTY) {
+        return nullptr;
+      }
+      if (entry.key == key) {
+        return &entry.mode;
+      }
+    }
+  }
+
+  /**
+   * @brief Return the mode in which the transaction holds a lock
+   * @param key the locked item
+   * @return a pointer to the held mode, or nullptr if the item is not locked
+   */
+  const LockMode* Find(const Key& key) const noexcept {
+    return const_cast<LockCache*>(this)->Find(key);
+  }
+
+  /**
+   * @brief Record a lock that the transaction did not hold
+   * @param key the locked item
+   * @param mode the held mode
+   */
+  void Insert(const Key& key, LockMode mode);
+
+  /**
+   * @brief Return the number of block and record locks held in a file
+   * @param file the file id
+   * @return the number of locks
+   */
+  int FineLocks(int file) const noexcept { return files_[file].fine_locks; }
+
+  /**
+   * @brief Forget the block and record locks held in a file
+   * @param file the file id
+   * @return the forgotten locks, for the lock table to release
+   */
+  std::vector<LockId> EraseFineLocks(int file);
+
+  /**
+   * @brief Return every lock the transaction holds
+   * @return the locked items
+   */
+  std::vector<LockId> Ids() const;
+
+  /**
+   * @brief Return the identity of an item in the global lock table
+   * @param key the locked item
+   * @return the LockId of the item
+   */
+  LockId Id(const Key& key) const {
+    return LockId{files_[key.file].name, key.block_num, key.slot};
+  }
+
+  /**
+   * @brief Forget every lock and filename, keeping the allocated table
+   */
+  void clear() noexcept;
+
+  /**
+   * @brief Return the capacity of the table
+   * @return the number of entries the table has allocated
+   */
+  size_t bucket_count() const noexcept { return entries_.size(); }
+
+ private:
+  struct Entry {
+    Key key{EMPTY};
+    LockMode mode{};
+  };
+
+  struct File {
+    std::string name;
+    // The number of block and record locks held in the file
+    int fine_locks{};
+  };
+
+  /**
+   * @brief Mix the three parts of a key, since the records of a block differ
+   * only in slot
+   * @param key the locked item
+   * @return the hash value of the key
+   */
+  static size_t Hash(const Key& key) noexcept {
+    uint64_t h = (static_cast<uint64_t>(static_cast<uint32_t>(key.block_num))
+                  << 32) |
+                 static_cast<uint32_t>(key.slot);
+    h ^= static_cast<uint64_t>(key.file) * 0x9e3779b97f4a7c15ULL;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    return h ^ (h >> 31);
+  }
+
+  /**
+   * @brief Put an entry into the first free position of its probe sequence.
+   * The table must have room for it.
+   * @param key the locked item
+   * @param mode the held mode
+   */
+  void Place(const Key& key, LockMode mode) noexcept;
+
+  /**
+   * @brief Double the capacity of the table, or allocate it on the first
+   * insertion
+   */
+  void Grow();
+
+  // Marks a free entry; no file has a negative id
+  static constexpr int EMPTY = -1;
+  static constexpr size_t INITIAL_CAPACITY = 16;
+  // The capacity is a power of two, and at most half of it is used
+  std::vector<Entry> entries_;
+  size_t size_{};
+  std::vector<File> files_;
+};
+}  // namespace simpledb
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+
+#include "file/block_id.h"
+
+namespace simpledb {
+/**
+ * A LockId identifies an item that transactions lock: a whole file, a block of
+ * a file, or a record within a block, identified by its slot
+ */
+class LockId {
+ public:
+  /**
+   * @brief Default constructor
+   */
+  LockId() = default;
+
+  /**
+   * @brief Identify the lock of a whole file, such as a table
+   * @param filename name of the file
+   */
+  explicit LockId(std::string_view filename)
+      : filename_(filename), block_num_(NO_BLOCK) {}
+
+  /**
+   * @brief Identify the lock of a block, or of a record in that block
+   * @param block a reference to the disk block
+   * @param slot the slot of the record, or `NO_SLOT` to lock the whole block
+   */
+  explicit LockId(const BlockId& block, int slot = NO_SLOT)
+      : filename_(block.Filename()),
+        block_num_(block.BlockNumber()),
+        slot_(slot) {}
+
+  /**
+   * @brief Identify the lock of a file, a block, or a record by its parts
+   * @param filename name of the file
+   * @param block_num the block number, or `NO_BLOCK` to lock the whole file
+   * @param slot the slot of the record, or `NO_SLOT` to lock the whole block
+   */
+  LockId(std::string_view filename, int block_num, int slot)
+      : filename_(filename), block_num_(block_num), slot_(slot) {}
+
+  /**
+   * @brief Return the name of the file of the locked item
+   * @return the filename
+   */
+  const std::string& Filename() const noexcept { return filename_; }
+
+  /**
+   * @brief Return the number of the locked block, or of the block that holds
+   * the locked record
+   * @return the block number, or `NO_BLOCK` if a whole file is locked
+   */
+  int BlockNumber() const noexcept { return block_num_; }
+
+  /**
+   * @brief Return the slot of the locked record
+   * @return the slot, or `NO_SLOT` if a whole block is locked
+   */
+  int Slot() const noexcept { return slot_; }
+
+  /**
+   * @brief Return whether the lock covers a whole file
+   * @return true if a file is locked; otherwise, false
+   */
+  bool IsFile() const noexcept { return block_num_ == NO_BLOCK; }
+
+  /**
+   * @brief Return whether the lock covers a single record
+   * @return true if a record is locked; otherwise, false
+   */
+  bool IsRecord() const noexcept { return slot_ != NO_SLOT; }
+
+  /**
+   * @brief Compare whether two LockId objects identify the same item
+   * @param other the other LockId to compare
+   * @return true if both identify the same item; otherwise, false
+   */
+  bool operator==(const LockId& other) const noexcept {
+    return block_num_ == other.block_num_ && slot_ == other.slot_ &&
+           filename_ == other.filename_;
+  }
+
+  static constexpr int NO_SLOT = -1;
+  // -1 is taken by the "end of file" block that guards the size of a file
+  static constexpr int NO_BLOCK = -2;
+
+ private:
+  std::string filename_;
+  int block_num_{};
+  int slot_{NO_SLOT};
+};
+}  // namespace simpledb
+
+template <>
+struct std::hash<simpledb::LockId> {
+  size_t operator()(const simpledb::LockId& id) const noexcept {
+    // Mix the numbers in, since the records of a block differ only in slot
+    size_t h = std::hash<std::string_view>{}(id.Filename());
+    for (int part : {id.BlockNumber(), id.Slot()}) {
+      h ^= std::hash<int>{}(part) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    }
+    return h;
+  }
+};
@@ -1,59 +1,362 @@
 #include "txn/concurrency/lock_table.h"
 
+#include <algorithm>
+#include <iterator>
+#include <mutex>  // NOLINT(build/c++11)
+#include <numeric>
+#include <utility>
+#include <vector>
+
 namespace simpledb {
-void LockTable::SharedLock(const BlockId& block) {
-  std::unique_lock lock{mutex_};
-  auto timestamp = system_clock::now();
-  while (HasExclusiveLock(block) && !WaitingTooLong(timestamp)) {
-    cv_.wait_for(lock, MAX_TIME);
+namespace {
+// Rows: the held mode; columns: the requested mode, both in the order IS, IX,
+// S, SIX, X
+constexpr bool COMPATIBLE[5][5] = {{true, true, true, true, false},
+                                   {true, true, false, false, false},
+                                   {true, false, true, false, false},
+                                   {true, false, false, false, false},
+                                   {false, false, false, false, false}};
+
+constexpr LockMode SUPREMUM[5][5] = {
+    {LockMode::IS, LockMode::IX, LockMode::S, LockMode::SIX, LockMode::X},
+    {LockMode::IX, LockMode::IX, LockMode::SIX, LockMode::SIX, LockMode::X},
+    {LockMode::S, LockMode::SIX, LockMode::S, LockMode::SIX, LockMode::X},
+    {LockMode::SIX, LockMode::SIX, LockMode::SIX, LockMode::SIX, LockMode::X},
+    {LockMode::X, LockMode::X, LockMode::X, LockMode::X, LockMode::X}};
+}  // namespace
+
+bool Compatible(LockMode held, LockMode requested) noexcept {
+  return COMPATIBLE[static_cast<int>(held)][static_cast<int>(requested)];
+}
+
+LockMode Supremum(LockMode held, LockMode requested) noexcept {
+  return SUPREMUM[static_cast<int>(held)][static_cast<int>(requested)];
+}
+
+void LockTable::Lock(const LockId& id, LockOwner& owner, LockMode mode) {
+  auto& stripe = GetStripe(id);
+  std::unique_lock guard{stripe.mutex};
+  // References to the elements of an unordered map stay valid while other
+  // elements are inserted; this lock is not erased while it has waiters
+  auto& lock = stripe.locks[id];
+  // A wounded transaction must notice its abort even if the lock is free
+  if (!owner.aborted &&
+      CanGrant(lock, owner.txn_id, mode, lock.waiters.end())) {
+    Grant(lock, owner, mode);
+    return;
+  }
+  Waiter waiter;
+  waiter.owner = &owner;
+  waiter.mode = mode;
+  bool queued = false;
+  auto pos = lock.waiters.end();
+  while (true) {
+    std::vector<std::pair<Stripe*, int>> wakeups;
+    {
+      std::scoped_lock graph_guard{graph_mutex_};
+      WaiterIter queue_pos = queued ? pos : lock.waiters.end();
+      bool aborted = owner.aborted;
+      if (aborted || CanGrant(lock, owner.txn_id, mode, queue_pos)) {
+        if (queued) {
+          lock.waiters.erase(pos);
+        }
+        txns_.erase(owner.txn_id);
+        if (!aborted) {
+          break;
+        }
+        if (queued) {
+          // The requests queued behind this one no longer wait for it
+          for (auto other : lock.waiters) {
+            auto other_iter = txns_.find(other->owner->txn_id);
+            if (other_iter != txns_.end()) {
+              other_iter->second.waits_for.erase(owner.txn_id);
+            }
+          }
+          WakeGrantable(lock);
+        }
+        if (lock.waiters.empty() && lock.holders.empty()) {
+          stripe.locks.erase(id);
+        }
+        throw LockAbortException();
+      }
+
+      auto blockers = Blockers(lock, owner.txn_id, mode, queue_pos);
+      auto& state = txns_[owner.txn_id];
+      state.owner = &owner;
+      state.waits_for.clear();
+      for (auto blocker : blockers) {
+        state.waits_for.insert(blocker->txn_id);
+      }
+      for (auto victim : ChooseVictims(owner, blockers)) {
+        if (victim->aborted.exchange(true) || victim == &owner) {
+          continue;
+        }
+        auto victim_iter = txns_.find(victim->txn_id);
+        if (victim_iter != txns_.end() &&
+            victim_iter->second.waiter != nullptr) {
+          wakeups.emplace_back(victim_iter->second.stripe, victim->txn_id);
+        }
+      }
+      if (owner.aborted) {
+        continue;
+      }
+      if (!queued) {
+        pos = lock.waiters.insert(lock.waiters.end(), &waiter);
+        queued = true;
+      }
+      state.waiter = &waiter;
+      state.stripe = &stripe;
+    }
+
+    if (!wakeups.empty()) {
+      guard.unlock();
+      for (const auto& [victim_stripe, victim] : wakeups) {
+        WakeVictim(victim_stripe, victim);
+      }
+      guard.lock();
+      continue;
+    }
+    waiter.cv.wait(guard);
+  }
+  Grant(lock, owner, mode);
+}
+
+bool LockTable::TryLock(const LockId& id, LockOwner& owner, LockMode mode) {
+  auto& stripe = GetStripe(id);
+  std::scoped_lock guard{stripe.mutex};
+  auto iter = stripe.locks.find(id);
+  if (iter == stripe.locks.end()) {
+    stripe.locks[id].holders.push_back(Holder{&owner, mode});
+    return true;
+  }
+  if (!CanGrant(iter->second, owner.txn_id, mode,
+                iter->second.waiters.end())) {
+    return false;
+  }
+  Grant(iter->second, owner, mode);
+  return true;
+}
+
+bool LockTable::Conflicts(const LockId& id, int txn_id, LockMode mode) {
+  auto& stripe = GetStripe(id);
+  std::scoped_lock guard{stripe.mutex};
+  auto iter = stripe.locks.find(id);
+  return iter != stripe.locks.end() &&
+         !CanGrant(iter->second, txn_id, mode, iter->second.waiters.begin());
+}
+
+void LockTable::Unlock(const LockId& id, int txn_id, Lsn commit_lsn) {
+  auto& stripe = GetStripe(id);
+  std::scoped_lock guard{stripe.mutex};
+  if (commit_lsn > stripe.commit_lsn) {
+    stripe.commit_lsn = commit_lsn;
   }
-  if (HasExclusiveLock(block)) {
-    throw LockAbortException();
+  Release(stripe, id, txn_id);
+}
+
+void LockTable::UnlockAll(const std::vector<LockId>& ids, int txn_id,
+                          Lsn commit_lsn) {
+  // Sort the items by stripe with a counting sort: `starts[i]` is where the
+  // items of stripe i begin in `grouped`
+  std::vector<size_t> stripe_of(ids.size());
+  std::array<size_t, NUM_STRIPES + 1> starts{};
+  for (size_t i = 0; i < ids.size(); i++) {
+    stripe_of[i] = StripeIndex(ids[i]);
+    starts[stripe_of[i] + 1]++;
+  }
+  std::partial_sum(starts.begin(), starts.end(), starts.begin());
+  std::vector<const LockId*> grouped(ids.size());
+  auto next = starts;
+  for (size_t i = 0; i < ids.size(); i++) {
+    grouped[next[stripe_of[i]]++] = &ids[i];
+  }
+
+  for (size_t index = 0; index < NUM_STRIPES; index++) {
+    if (starts[index] == starts[index + 1]) {
+      continue;
+    }
+    auto& stripe = stripes_[index];
+    std::scoped_lock guard{stripe.mutex};
+    if (commit_lsn > stripe.commit_lsn) {
+      stripe.commit_lsn = commit_lsn;
+    }
+    for (size_t i = starts[index]; i < starts[index + 1]; i++) {
+      Release(stripe, *grouped[i], txn_id);
+    }
   }
-  locks_[block]++;
 }
 
-void LockTable::ExclusiveLock(const BlockId& block) {
-  std::unique_lock lock{mutex_};
-  auto timestamp = system_clock::now();
-  while (HasOtherSharedLocks(block) && !WaitingTooLong(timestamp)) {
-    cv_.wait_for(lock, MAX_TIME);
+void LockTable::Release(Stripe& stripe, const LockId& id, int txn_id) {
+  auto iter = stripe.locks.find(id);
+  if (iter == stripe.locks.end()) {
+    return;
+  }
+  auto& lock = iter->second;
+  auto holder = std::find_if(
+      lock.holders.begin(), lock.holders.end(),
+      [txn_id](const Holder& entry) { return entry.owner->txn_id == txn_id; });
+  if (holder != lock.holders.end()) {
+    *holder = lock.holders.back();
+    lock.holders.pop_back();
   }
-  if (HasOtherSharedLocks(block)) {
-    throw LockAbortException();
+  if (!lock.waiters.empty()) {
+    {
+      std::scoped_lock graph_guard{graph_mutex_};
+      for (auto waiter : lock.waiters) {
+        auto state_iter = txns_.find(waiter->owner->txn_id);
+        if (state_iter != txns_.end()) {
+          state_iter->second.waits_for.erase(txn_id);
+        }
+      }
+    }
+    WakeGrantable(lock);
+  } else if (lock.holders.empty()) {
+    stripe.locks.erase(iter);
   }
-  locks_[block] = -1;
 }
 
-void LockTable::Unlock(const BlockId& block) {
-  std::scoped_lock lock{mutex_};
-  int val = GetLockVal(block);
-  if (val > 1) {
-    locks_[block] = val - 1;
+void LockTable::Grant(LockState& lock, LockOwner& owner, LockMode mode) {
+  auto holder = std::find_if(
+      lock.holders.begin(), lock.holders.end(),
+      [&owner](const Holder& entry) { return entry.owner == &owner; });
+  if (holder == lock.holders.end()) {
+    lock.holders.push_back(Holder{&owner, mode});
   } else {
-    locks_.erase(block);
-    cv_.notify_all();
+    holder->mode = mode;
+  }
+  // The waiters that conflict with the new holder now wait for it too
+  if (!lock.waiters.empty()) {
+    std::scoped_lock graph_guard{graph_mutex_};
+    for (auto waiter : lock.waiters) {
+      if (waiter->owner != &owner && !Compatible(mode, waiter->mode)) {
+        auto state_iter = txns_.find(waiter->owner->txn_id);
+        if (state_iter != txns_.end()) {
+          state_iter->second.waits_for.insert(owner.txn_id);
+        }
+      }
+    }
+  }
+}
+
+std::vector<LockOwner*> LockTable::Blockers(const LockState& lock,
+                                            int txn_id, LockMode mode,
+                                            WaiterIter queue_pos) {
+  std::vector<LockOwner*> blockers;
+  bool upgrade = false;
+  for (const auto& holder : lock.holders) {
+    if (holder.owner->txn_id == txn_id) {
+      upgrade = true;
+    } else if (!Compatible(holder.mode, mode)) {
+      blockers.push_back(holder.owner);
+    }
+  }
+  if (!upgrade) {
+    for (auto iter = lock.waiters.begin(); iter != queue_pos; ++iter) {
+      if (!Compatible((*iter)->mode, mode)) {
+        blockers.push_back((*iter)->owner);
+      }
+    }
   }
+  return blockers;
 }
 
-bool LockTable::WaitingTooLong(
-    const time_point<system_clock>& start_time) const noexcept {
-  return duration_cast<milliseconds>(system_clock::now() - start_time) >
-         MAX_TIME;
+bool LockTable::CanGrant(const LockState& lock, int txn_id, LockMode mode,
+                         WaiterIter queue_pos) noexcept {
+  // The requester's own lock, which it may want to upgrade, never conflicts
+  bool upgrade = false;
+  for (const auto& holder : lock.holders) {
+    if (holder.owner->txn_id == txn_id) {
+      upgrade = true;
+    } else if (!Compatible(holder.mode, mode)) {
+      return false;
+    }
+  }
+  // An upgrade goes ahead of the queue; any other request must not overtake
+  // a conflicting request queued before it
+  return upgrade ||
+         std::all_of(lock.waiters.begin(), queue_pos,
+                     [mode](const Waiter* waiter) {
+                       return Compatible(waiter->mode, mode);
+                     });
 }
 
-bool LockTable::HasExclusiveLock(const BlockId& block) const noexcept {
-  return GetLockVal(block) < 0;
+void LockTable::WakeGrantable(const LockState& lock) {
+  for (auto iter = lock.waiters.begin(); iter != lock.waiters.end(); ++iter) {
+    if (CanGrant(lock, (*iter)->owner->txn_id, (*iter)->mode, iter)) {
+      (*iter)->cv.notify_one();
+    }
+  }
 }
 
-bool LockTable::HasOtherSharedLocks(const BlockId& block) const noexcept {
-  return GetLockVal(block) > 1;
+std::vector<LockOwner*> LockTable::ChooseVictims(
+    LockOwner& owner, const std::vector<LockOwner*>& blockers) {
+  std::vector<LockOwner*> victims;
+  auto older = [&owner](const LockOwner* other) {
+    return other->start_ts < owner.start_ts;
+  };
+  auto younger = [&owner](const LockOwner* other) {
+    return other->start_ts > owner.start_ts;
+  };
+  switch (policy_) {
+    case DeadlockPolicy::DETECT: {
+      auto cycle = FindCycle(owner.txn_id);
+      if (!cycle.empty()) {
+        victims.push_back(*std::max_element(
+            cycle.begin(), cycle.end(),
+            [](const LockOwner* a, const LockOwner* b) {
+              return a->start_ts < b->start_ts;
+            }));
+      }
+      break;
+    }
+    case DeadlockPolicy::WAIT_DIE:
+      if (std::any_of(blockers.begin(), blockers.end(), older)) {
+        victims.push_back(&owner);
+      }
+      break;
+    case DeadlockPolicy::WOUND_WAIT:
+      std::copy_if(blockers.begin(), blockers.end(),
+                   std::back_inserter(victims), younger);
+      break;
+  }
+  return victims;
+}
+
+std::vector<LockOwner*> LockTable::FindCycle(int txn_id) const {
+  // Depth-first search from the transaction back to itself. Aborted
+  // transactions are about to stop waiting, so their edges are ignored.
+  std::vector<LockOwner*> path;
+  std::unordered_set<int> visited;
+  auto visit = [&](auto& self, int node) -> bool {
+    auto iter = txns_.find(node);
+    if (iter == txns_.end() || iter->second.owner->aborted) {
+      return false;
+    }
+    path.push_back(iter->second.owner);
+    for (int next : iter->second.waits_for) {
+      if (next == txn_id ||
+          (visited.insert(next).second && self(self, next))) {
+        return true;
+      }
+    }
+    path.pop_back();
+    return false;
+  };
+  if (!visit(visit, txn_id)) {
+    path.clear();
+  }
+  return path;
 }
 
-int LockTable::GetLockVal(const BlockId& block) const noexcept {
-  if (!locks_.contains(block)) {
-    return 0;
+void LockTable::WakeVictim(Stripe* stripe, int txn_id) {
+  std::scoped_lock guard{stripe->mutex};
+  std::scoped_lock graph_guard{graph_mutex_};
+  auto iter = txns_.find(txn_id);
+  // If the victim has moved on to another lock, it checks its abort flag
+  // before waiting there
+  if (iter != txns_.end() && iter->second.waiter != nullptr &&
+      iter->second.stripe == stripe) {
+    iter->second.waiter->cv.notify_one();
   }
-  return locks_.at(block);
 }
 }  // namespace simpledb
@@ -1,12 +1,18 @@
 #pragma once
 
-#include <chrono>              // NOLINT(build/c++11)
+#include <array>
+#include <atomic>
 #include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
 #include <exception>
+#include <list>
 #include <mutex>  // NOLINT(build/c++11)
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
-#include "file/block_id.h"
+#include "txn/concurrency/lock_id.h"
+#include "utils/data_type.h"
 
 namespace simpledb {
 /**
@@ -15,89 +21,325 @@ namespace simpledb {
  */
 class LockAbortException : public std::exception {};
 
-using namespace std::chrono;  // NOLINT(build/namespaces)
+/**
+ * How the lock table keeps waiting transactions from deadlocking. Transactions
+ * are ordered by their start timestamps (see `LockOwner`), so a smaller
+ * timestamp means an older transaction.
+ * - DETECT: a transaction that has to wait adds its edges to the waits-for
+ *   graph and searches it for a cycle. The youngest transaction on a cycle is
+ *   aborted immediately.
+ * - WAIT_DIE: a transaction waits only for younger lock holders; if an older
+ *   one holds the lock, the requester aborts.
+ * - WOUND_WAIT: a transaction aborts the younger lock holders and waits for
+ *   the older ones. A wounded transaction aborts when it waits for or
+ *   requests a lock.
+ */
+enum class DeadlockPolicy { DETECT, WAIT_DIE, WOUND_WAIT };
+
+/**
+ * A transaction as the lock table sees it. A new transaction starts at its
+ * id, so start timestamps grow with time. A transaction that retries an
+ * aborted one may keep the aborted one's timestamp instead, so that it grows
+ * older with every retry rather than younger, and is eventually neither
+ * killed nor wounded. The lock table refers to the owner while the
+ * transaction holds or waits for locks, so it must stay in place meanwhile.
+ */
+struct LockOwner {
+  int txn_id{};
+  int start_ts{};
+  // Set when the deadlock policy aborts the transaction. It is atomic so that
+  // a request checks it without taking the latch of the waits-for graph.
+  std::atomic<bool> aborted{false};
+};
+
+/**
+ * The modes in which an item can be locked. Items form a hierarchy: files
+ * contain blocks, which contain records. Before a transaction locks an item,
+ * it takes an intention lock on each enclosing item: IS before a shared lock,
+ * IX before an exclusive one. Intention locks are compatible with each other,
+ * so transactions can lock different records of the same block or different
+ * blocks of the same file, but they conflict with a lock on the enclosing
+ * item as a whole, such as the SharedLock a scan takes on a table or the
+ * ExclusiveLock that recovery holds on a block it rolls back. SIX is a shared
+ * lock combined with an intention to lock some contained items exclusively,
+ * as a scan that updates some of the records it reads holds.
+ */
+enum class LockMode : uint8_t { IS, IX, S, SIX, X };
 
 /**
- * The lock table, which provides methods to lock and unlock blocks. If a
- * transaction requests a lock that causes a conflict with an existing lock,
- * then that transaction is placed on a wait list. There is only one wait list
- * for all blocks. When the last lock on a block is unlocked, then all
- * transactions are removed from the wait list and rescheduled. If one of those
- * transactions discovers that the lock it is waiting for is still locked, it
- * will place itself back on the wait list.
+ * @brief Return whether two transactions may hold locks on the same item in
+ * the specified modes
+ * @param held the mode held by one transaction
+ * @param requested the mode requested by the other
+ * @return true if the modes are compatible; otherwise, false
+ */
+bool Compatible(LockMode held, LockMode requested) noexcept;
+
+/**
+ * @brief Return the weakest mode that grants everything both modes grant, the
+ * mode to which a lock is upgraded when its holder requests another mode
+ * @param held the mode currently held
+ * @param requested the requested mode
+ * @return the combined mode
+ */
+LockMode Supremum(LockMode held, LockMode requested) noexcept;
+
+/**
+ * The lock table, which provides methods to lock and unlock files, blocks and
+ * records on behalf of transactions. The table is partitioned into stripes by
+ * the hash of the locked item, each with its own latch, so that transactions
+ * locking different items rarely contend. If a transaction requests a lock
+ * that conflicts with an existing lock, or with a request already waiting for
+ * it, then that transaction is placed on the wait queue of that lock. Requests
+ * are thus granted in arrival order, except that a holder upgrading its lock
+ * goes ahead of the queue, since the waiters may be waiting for the lock it
+ * already holds. When a lock is released, only the waiters of that lock whose
+ * request can now be granted are woken up. Waits never time out: deadlocks
+ * are resolved by the deadlock policy instead.
+ *
+ * A committing transaction releases its locks as soon as its COMMIT record is
+ * in the log buffer, before the record is durable. Each stripe remembers the
+ * latest such COMMIT record, so that a transaction that then takes a lock in
+ * the stripe knows how far the log must be flushed before it may report
+ * anything it read.
  */
 class LockTable {
  public:
   /**
-   * @brief Grant a SharedLock on the specified block. If an ExclusiveLock
-   * exists when the method is called, then the calling thread will be placed on
-   * a wait list until the lock is released. If the thread remains on the wait
-   * list for a certain amount of time (currently 10 seconds), then an exception
-   * is thrown.
-   * @param block a reference to the disk block
+   * @brief Grant a lock in the specified mode on the specified item. If
+   * another transaction holds a conflicting lock when the method is called,
+   * then the calling thread will be placed on the wait queue of the lock until
+   * the conflicting locks are released. If the deadlock policy aborts the
+   * transaction, then an exception is thrown. A transaction that already holds
+   * the lock upgrades it, so the requested mode must include the held one
+   * (see `Supremum`).
+   * @param id the locked item
+   * @param owner the requesting transaction
+   * @param mode the lock mode
+   */
+  void Lock(const LockId& id, LockOwner& owner, LockMode mode);
+
+  /**
+   * @brief Grant a lock in the specified mode on the specified item only if
+   * this is possible without waiting
+   * @param id the locked item
+   * @param owner the requesting transaction
+   * @param mode the lock mode
+   * @return true if the lock was granted; otherwise, false
+   */
+  bool TryLock(const LockId& id, LockOwner& owner, LockMode mode);
+
+  /**
+   * @brief Return whether another transaction holds a lock on the specified
+   * item that conflicts with the specified mode
+   * @param id the locked item
+   * @param txn_id id of the asking transaction
+   * @param mode the lock mode
+   * @return true if a request in that mode would have to wait; otherwise,
+   * false
    */
-  void SharedLock(const BlockId& block);
+  bool Conflicts(const LockId& id, int txn_id, LockMode mode);
 
   /**
-   * @brief Grant an ExclusiveLock on the specified block. If a lock of any type
-   * exists when the method is called, then the calling thread will placed on a
-   * wait list until the locks are released. If the thread remains on the wait
-   * list for a certain amount of time (currently 10 seconds), then an exception
-   * is thrown.
-   * Note: If the number of shared locks granted is 1, it's this calling thread
-   * holding that shared lock.
-   * @param block a reference to the disk block
+   * @brief Release the lock of a transaction on the specified item, and wake
+   * up the waiters of that lock that can now be granted
+   * @param id the locked item
+   * @param txn_id id of the transaction holding the lock
+   * @param commit_lsn the LSN of the transaction's COMMIT record if it may
+   * not be durable yet; otherwise, `INVALID_LSN`
    */
-  void ExclusiveLock(const BlockId& block);
+  void Unlock(const LockId& id, int txn_id, Lsn commit_lsn = INVALID_LSN);
 
   /**
-   * @brief Release a lock on the specified block. If this lock is the last lock
-   * on that block, then the waiting transactions are notified.
-   * @param block a reference to the disk block
+   * @brief Release the locks of a transaction on the specified items, and
+   * wake up the waiters that can now be granted. The items are grouped by
+   * stripe, so that each stripe latch is taken once however many locks the
+   * transaction releases in it.
+   * @param ids the locked items
+   * @param txn_id id of the transaction holding the locks
+   * @param commit_lsn the LSN of the transaction's COMMIT record if it may
+   * not be durable yet; otherwise, `INVALID_LSN`
    */
-  void Unlock(const BlockId& block);
+  void UnlockAll(const std::vector<LockId>& ids, int txn_id,
+                 Lsn commit_lsn = INVALID_LSN);
+
+  /**
+   * @brief Return the LSN of the latest COMMIT record written by a
+   * transaction that released a lock in the stripe of the specified item.
+   * A transaction that has just locked the item may depend on it.
+   * @param id the locked item
+   * @return the LSN, or `INVALID_LSN` if there is none
+   */
+  Lsn CommitLsn(const LockId& id) noexcept { return GetStripe(id).commit_lsn; }
+
+  /**
+   * @brief Forget that a transaction was aborted once it has released all
+   * its locks
+   * @param owner the transaction
+   */
+  static void EndTxn(LockOwner& owner) noexcept { owner.aborted = false; }
+
+  /**
+   * @brief Choose how deadlocks are prevented or resolved
+   * @param policy the deadlock policy
+   */
+  void SetDeadlockPolicy(DeadlockPolicy policy) noexcept { policy_ = policy; }
 
  private:
   /**
-   * @brief Return whether `MAX_TIME` milliseconds has passed since the
-   * specified start time
-   * @param start_time start time of the duration
-   * @return true if `MAX_TIME` milliseconds has passed; otherwise, false
+   * A transaction waiting for a lock. Each waiter has its own condition
+   * variable so that it can be woken up on its own.
    */
-  bool WaitingTooLong(
-      const time_point<system_clock>& start_time) const noexcept;
+  struct Waiter {
+    LockOwner* owner{};
+    LockMode mode{};
+    std::condition_variable cv;
+  };
 
   /**
-   * @brief Return whether an exclusive lock is currently assigned to the
-   * specified block
-   * @param block a reference to the disk block
-   * @return true if an exclusive lock is assigned to the block; otherwise,
-   * false
+   * A transaction holding a lock, and the mode it holds it in
    */
-  bool HasExclusiveLock(const BlockId& block) const noexcept;
+  struct Holder {
+    LockOwner* owner{};
+    LockMode mode{};
+  };
 
   /**
-   * @brief Return whether there are other shared locks also assigned to the
-   * specified block. The thread calling this method is currently holding a
-   * shared lock. It wants to know whether other threads also hold shared locks.
-   * @param block a reference to the disk block
-   * @return true if there are more than one shared locks assigned; otherwise,
-   * false
+   * The state of a lock: the transactions holding it and the transactions
+   * waiting for it, queued in arrival order. A lock rarely has more than a
+   * few holders, so they are kept in a flat vector.
+   */
+  struct LockState {
+    std::vector<Holder> holders;
+    std::list<Waiter*> waiters;
+  };
+
+  using WaiterIter = std::list<Waiter*>::const_iterator;
+
+  /**
+   * A partition of the lock table and the latch that protects it
+   */
+  struct Stripe {
+    std::mutex mutex;
+    std::unordered_map<LockId, LockState> locks;
+    // only grows; written under the mutex
+    std::atomic<Lsn> commit_lsn{INVALID_LSN};
+  };
+
+  /**
+   * The waits-for state of a transaction. A transaction has an entry while it
+   * waits for a lock.
+   */
+  struct TxnState {
+    std::unordered_set<int> waits_for;  // the transactions it waits for
+    LockOwner* owner{nullptr};
+    Waiter* waiter{nullptr};  // set once it is queued
+    Stripe* stripe{nullptr};  // the stripe of the awaited lock
+  };
+
+  /**
+   * @brief Release the lock of a transaction on an item, and wake up the
+   * waiters that can now be granted. The caller holds the stripe latch.
+   * @param stripe the stripe of the item
+   * @param id the locked item
+   * @param txn_id id of the transaction holding the lock
+   */
+  void Release(Stripe& stripe, const LockId& id, int txn_id);
+
+  /**
+   * @brief Add a transaction to the holders of a lock, and make the waiters
+   * that conflict with it wait for it too. The caller holds the stripe latch.
+   * @param lock the state of the lock
+   * @param owner the requesting transaction
+   * @param mode the granted mode
+   */
+  void Grant(LockState& lock, LockOwner& owner, LockMode mode);
+
+  /**
+   * @brief Return the transactions that a request has to wait for: the
+   * holders of conflicting locks, and unless the request is an upgrade, the
+   * conflicting requests queued ahead of it
+   * @param lock the state of the lock
+   * @param txn_id id of the requesting transaction
+   * @param mode the requested mode
+   * @param queue_pos the position of the request in the wait queue, or the
+   * end of the queue if it is not queued
+   * @return the conflicting transactions
+   */
+  static std::vector<LockOwner*> Blockers(const LockState& lock, int txn_id,
+                                          LockMode mode, WaiterIter queue_pos);
+
+  /**
+   * @brief Return whether a lock request can be granted, i.e., whether it
+   * has no blockers (see `Blockers`)
+   * @param lock the state of the lock
+   * @param txn_id id of the requesting transaction
+   * @param mode the requested mode
+   * @param queue_pos the position of the request in the wait queue, or the
+   * end of the queue if it is not queued
+   * @return true if the request can be granted; otherwise, false
+   */
+  static bool CanGrant(const LockState& lock, int txn_id, LockMode mode,
+                       WaiterIter queue_pos) noexcept;
+
+  /**
+   * @brief Wake up the waiters of a lock whose request can now be granted,
+   * in queue order
+   * @param lock the state of the lock
+   */
+  static void WakeGrantable(const LockState& lock);
+
+  /**
+   * @brief Apply the deadlock policy to a transaction that is about to wait.
+   * The caller holds the graph latch.
+   * @param owner the waiting transaction
+   * @param blockers the transactions it waits for
+   * @return the transactions to abort, which may include the waiting one
+   */
+  std::vector<LockOwner*> ChooseVictims(
+      LockOwner& owner, const std::vector<LockOwner*>& blockers);
+
+  /**
+   * @brief Search the waits-for graph for a cycle through a transaction. The
+   * caller holds the graph latch.
+   * @param txn_id id of the transaction
+   * @return the transactions on a cycle, or an empty vector if there is none
+   */
+  std::vector<LockOwner*> FindCycle(int txn_id) const;
+
+  /**
+   * @brief Wake up a victim if it is waiting, so that it notices the abort.
+   * The caller holds no latch.
+   * @param stripe the stripe of the lock the victim was waiting for
+   * @param txn_id id of the victim
+   */
+  void WakeVictim(Stripe* stripe, int txn_id);
+
+  /**
+   * @brief Return the stripe that holds the lock of the specified item
+   * @param id the locked item
+   * @return a reference to the stripe
    */
-  bool HasOtherSharedLocks(const BlockId& block) const noexcept;
+  Stripe& GetStripe(const LockId& id) noexcept {
+    return stripes_[StripeIndex(id)];
+  }
 
   /**
-   * @brief Return the lock value associated with the specified block: a value
-   * of -1 denotes an exclusive lock; 0 denotes no lock is currently assigned; a
-   * positive value denotes the number of shared locks assigned.
-   * @param block a reference to the disk block
-   * @return a value indicating the locking status of the specified block
+   * @brief Return the index of the stripe that holds the lock of the
+   * specified item
+   * @param id the locked item
+   * @return the index of the stripe
    */
-  int GetLockVal(const BlockId& block) const noexcept;
+  static size_t StripeIndex(const LockId& id) noexcept {
+    return std::hash<LockId>{}(id) % NUM_STRIPES;
+  }
 
-  static constexpr milliseconds MAX_TIME = 10000ms;
-  std::unordered_map<BlockId, int> locks_{};
-  mutable std::mutex mutex_;
-  std::condition_variable cv_;
+  static constexpr size_t NUM_STRIPES = 64;
+  std::array<Stripe, NUM_STRIPES> stripes_;
+  std::atomic<DeadlockPolicy> policy_{DeadlockPolicy::DETECT};
+  // The waits-for graph. Its latch is taken after a stripe latch, never
+  // before.
+  std::mutex graph_mutex_;
+  std::unordered_map<int, TxnState> txns_;
 };
 }  // namespace simpledb
@@ -0,0 +1,70 @@
+#include "txn/concurrency/optimistic_manager.h"
+
+#include <utility>
+#include <vector>
+
+#include "txn/concurrency/lock_table.h"
+
+namespace simpledb {
+// Define class static variable
+VersionTable OptimisticManager::version_table_{};
+
+OptimisticManager::~OptimisticManager() {
+  TablePool<ItemMap>::Release(std::move(items_));
+}
+
+void OptimisticManager::Read(const LockId& id) {
+  if (items_.contains(id)) {
+    return;
+  }
+  auto version = version_table_.Read(id, txn_id_);
+  if (!version.has_value()) {
+    throw LockAbortException();
+  }
+  items_.emplace(id, Access{version.value(), false});
+}
+
+bool OptimisticManager::TryWrite(const LockId& id) {
+  auto iter = items_.find(id);
+  if (iter != items_.end() && iter->second.written) {
+    return true;
+  }
+  if (!version_table_.Acquire(id, txn_id_)) {
+    return false;
+  }
+  if (iter == items_.end()) {
+    items_.emplace(id, Access{0, true});
+    return true;
+  }
+  // The item is claimed either way, so that Release gives it a new version
+  iter->second.written = true;
+  // What the transaction read is checked now: no one else can change it
+  // any more
+  if (!version_table_.Validate(id, txn_id_, iter->second.version)) {
+    throw LockAbortException();
+  }
+  return true;
+}
+
+bool OptimisticManager::Validate() {
+  for (const auto& [id, access] : items_) {
+    if (!access.written &&
+        !version_table_.Validate(id, txn_id_, access.version)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void OptimisticManager::Release() {
+  std::vector<LockId> written;
+  for (const auto& [id, access] : items_) {
+    if (access.written) {
+      written.push_back(id);
+    }
+  }
+  version_table_.Release(written);
+  version_table_.End(start_);
+  items_.clear();
+}
+}  // namespace simpledb
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "txn/concurrency/lock_id.h"
+#include "txn/concurrency/version_table.h"
+#include "utils/table_pool.h"
+
+namespace simpledb {
+/**
+ * The concurrency manager of an optimistic transaction, which takes no locks.
+ * It keeps the read set of the transaction, the version of each item it read,
+ * and its write set, the items it claimed in the global version table before
+ * changing them. At commit, the transaction is validated: if another
+ * transaction has changed or is changing an item it read, it has to abort.
+ *
+ * A transaction that reads an item being changed by another, or that tries
+ * to change it, aborts right away instead of waiting, so optimistic
+ * transactions never deadlock. The version table only knows about optimistic
+ * transactions; the transaction also locks what it changes in the lock table
+ * (see `TxnMode::OPTIMISTIC`).
+ */
+class OptimisticManager {
+ public:
+  /**
+   * @brief Create the optimistic manager of a transaction
+   * @param txn_id id of the transaction
+   */
+  explicit OptimisticManager(int txn_id)
+      : txn_id_(txn_id), items_(TablePool<ItemMap>::Acquire()) {}
+
+  /**
+   * @brief Return the item map of the transaction to the pool, so that the
+   * next transaction reuses it
+   */
+  ~OptimisticManager();
+
+  /**
+   * @brief Register the transaction in the version table as it starts
+   */
+  void Begin() { start_ = version_table_.Begin(); }
+
+  /**
+   * @brief Note the version of an item before the transaction reads it. A
+   * `LockAbortException` is thrown if another transaction is changing it.
+   * @param id the item
+   */
+  void Read(const LockId& id);
+
+  /**
+   * @brief Return whether the transaction has already read or claimed an
+   * item
+   * @param id the item
+   * @return true if the item is in the read or write set; otherwise, false
+   */
+  bool Accessed(const LockId& id) const { return items_.contains(id); }
+
+  /**
+   * @brief Claim an item only if no other transaction has claimed it. A
+   * `LockAbortException` is still thrown if the transaction read the item and
+   * another transaction has changed it since.
+   * @param id the item
+   * @return true if the item was claimed; otherwise, false
+   */
+  bool TryWrite(const LockId& id);
+
+  /**
+   * @brief Check that the items the transaction only read are unchanged. The
+   * items it changed stay claimed until it ends, so they need no check.
+   * @return true if the transaction may commit; otherwise, false
+   */
+  bool Validate();
+
+  /**
+   * @brief Release the claimed items with new versions and unregister the
+   * transaction
+   */
+  void Release();
+
+ private:
+  /**
+   * How the transaction accessed an item
+   */
+  struct Access {
+    VersionTable::Version version{};  // the version read, if not written
+    bool written{};
+  };
+
+  using ItemMap = std::unordered_map<LockId, Access>;
+
+  // The global version table. This variable is static because all
+  // transactions share the same table.
+  static VersionTable version_table_;
+  int txn_id_{};
+  VersionTable::Version start_{};
+  ItemMap items_;
+};
+}  // namespace simpledb
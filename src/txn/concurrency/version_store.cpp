@@ -0,0 +1,120 @@
+#include "txn/concurrency/version_store.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace simpledb {
+void VersionStore::Save(int txn_id, const LockId& record,
+                        std::span<const char> image) {
+  if (!enabled_) {
+    return;
+  }
+  std::scoped_lock guard{mutex_};
+  auto& chain = chains_[record];
+  // The exclusive lock on the record means that only the newest version can
+  // belong to an uncommitted transaction
+  if (!chain.empty() && chain.front().txn_id == txn_id &&
+      chain.front().commit_ts == UNCOMMITTED) {
+    return;
+  }
+  chain.push_front(
+      Version{txn_id, UNCOMMITTED, {image.begin(), image.end()}});
+  txn_records_[txn_id].push_back(record);
+}
+
+void VersionStore::Commit(int txn_id, Lsn commit_lsn) {
+  std::scoped_lock guard{mutex_};
+  auto iter = txn_records_.find(txn_id);
+  if (iter == txn_records_.end()) {
+    return;
+  }
+  commit_lsn_ = std::max(commit_lsn_, commit_lsn);
+  auto records = std::move(iter->second);
+  txn_records_.erase(iter);
+  Timestamp commit_ts = ++clock_;
+  // Without snapshots, no one can see the old versions any more
+  if (snapshots_.empty()) {
+    Prune(txn_id, records);
+    return;
+  }
+  for (const auto& record : records) {
+    chains_.at(record).front().commit_ts = commit_ts;
+  }
+  committed_.push_back(CommittedTxn{commit_ts, txn_id, std::move(records)});
+}
+
+void VersionStore::Rollback(int txn_id) {
+  std::scoped_lock guard{mutex_};
+  auto iter = txn_records_.find(txn_id);
+  if (iter == txn_records_.end()) {
+    return;
+  }
+  for (const auto& record : iter->second) {
+    auto chain = chains_.find(record);
+    chain->second.pop_front();
+    if (chain->second.empty()) {
+      chains_.erase(chain);
+    }
+  }
+  txn_records_.erase(iter);
+}
+
+VersionStore::Timestamp VersionStore::BeginSnapshot() {
+  std::scoped_lock guard{mutex_};
+  snapshots_[clock_]++;
+  return clock_;
+}
+
+Lsn VersionStore::CommitLsn() {
+  std::scoped_lock guard{mutex_};
+  return commit_lsn_;
+}
+
+void VersionStore::EndSnapshot(Timestamp snapshot) {
+  std::scoped_lock guard{mutex_};
+  auto iter = snapshots_.find(snapshot);
+  if (--iter->second == 0) {
+    snapshots_.erase(iter);
+  }
+  // A version replaced at a timestamp not after the oldest snapshot is seen
+  // by no one
+  Timestamp oldest =
+      snapshots_.empty() ? UNCOMMITTED : snapshots_.begin()->first;
+  while (!committed_.empty() && committed_.front().commit_ts <= oldest) {
+    Prune(committed_.front().txn_id, committed_.front().records);
+    committed_.pop_front();
+  }
+}
+
+void VersionStore::Read(const LockId& record, Timestamp snapshot,
+                        std::span<char> image) {
+  std::scoped_lock guard{mutex_};
+  auto iter = chains_.find(record);
+  if (iter == chains_.end()) {
+    return;
+  }
+  for (const auto& version : iter->second) {
+    if (version.commit_ts <= snapshot) {
+      return;
+    }
+    std::copy(version.image.begin(), version.image.end(), image.begin());
+  }
+}
+
+void VersionStore::Prune(int txn_id, const std::vector<LockId>& records) {
+  for (const auto& record : records) {
+    auto chain = chains_.find(record);
+    if (chain == chains_.end()) {
+      continue;
+    }
+    auto& versions = chain->second;
+    auto iter = std::find_if(
+        versions.begin(), versions.end(),
+        [txn_id](const Version& version) { return version.txn_id == txn_id; });
+    versions.erase(iter, versions.end());
+    if (versions.empty()) {
+      chains_.erase(chain);
+    }
+  }
+}
+}  // namespace simpledb
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>  // NOLINT(build/c++11)
+#include <span>   // NOLINT(build/include_order)
+#include <unordered_map>
+#include <vector>
+
+#include "txn/concurrency/lock_id.h"
+#include "utils/data_type.h"
+
+namespace simpledb {
+/**
+ * The version store keeps the prior versions of records for snapshot reads.
+ * Before a transaction first changes a record, it saves the record's current
+ * image here, so each record slot has a chain of older versions, newest
+ * first. When the transaction commits, its versions are stamped with a commit
+ * timestamp from a global clock.
+ *
+ * A snapshot reader takes the clock value when it starts. For each record, it
+ * starts from the image in the page and walks down the chain while the change
+ * that replaced a version was not committed by the start of the snapshot.
+ * Readers therefore neither lock records nor wait for writers, and writers
+ * still lock records among themselves.
+ *
+ * A version is dropped once every active snapshot sees the change that
+ * replaced it.
+ */
+class VersionStore {
+ public:
+  using Timestamp = int64_t;
+
+  /**
+   * @brief Turn the keeping of versions on or off. Snapshots may only be
+   * started while versions are kept, and the mode should be chosen before
+   * any transaction starts changing records.
+   * @param enabled whether to keep versions
+   */
+  void SetEnabled(bool enabled) noexcept { enabled_ = enabled; }
+
+  /**
+   * @brief Return whether versions are kept
+   * @return true if versions are kept; otherwise, false
+   */
+  bool Enabled() const noexcept { return enabled_; }
+
+  /**
+   * @brief Save the image of a record before a transaction changes it. Only
+   * the image before the first change of each transaction is kept.
+   * @param txn_id id of the changing transaction, which locks the record
+   * exclusively
+   * @param record the lock id of the record
+   * @param image the current bytes of the record slot
+   */
+  void Save(int txn_id, const LockId& record, std::span<const char> image);
+
+  /**
+   * @brief Stamp the versions saved by a transaction with a commit timestamp
+   * @param txn_id id of the committing transaction
+   * @param commit_lsn the LSN of its COMMIT record, which may not be durable
+   * yet
+   */
+  void Commit(int txn_id, Lsn commit_lsn);
+
+  /**
+   * @brief Forget the versions saved by a transaction whose changes have been
+   * rolled back
+   * @param txn_id id of the transaction
+   */
+  void Rollback(int txn_id);
+
+  /**
+   * @brief Start a snapshot of the committed state of the database
+   * @return the timestamp of the snapshot
+   */
+  Timestamp BeginSnapshot();
+
+  /**
+   * @brief Return the LSN of the latest COMMIT record of a transaction whose
+   * changes have been stamped. A snapshot started before this call sees no
+   * later changes, so it is enough for the log to be durable up to there
+   * before the snapshot reports what it read.
+   * @return the LSN, or `INVALID_LSN` if there is none
+   */
+  Lsn CommitLsn();
+
+  /**
+   * @brief End a snapshot, dropping the versions that only it could see
+   * @param snapshot the timestamp of the snapshot
+   */
+  void EndSnapshot(Timestamp snapshot);
+
+  /**
+   * @brief Replace the image of a record by the version that a snapshot sees.
+   * The caller holds the latch of the record's buffer while it copies the
+   * image from the page and calls this method.
+   * @param record the lock id of the record
+   * @param snapshot the timestamp of the snapshot
+   * @param image the bytes of the record slot in the page, overwritten with
+   * the visible version
+   */
+  void Read(const LockId& record, Timestamp snapshot, std::span<char> image);
+
+ private:
+  /**
+   * The image of a record before a transaction changed it
+   */
+  struct Version {
+    int txn_id{};
+    // when the change that replaced this version was committed, or
+    // `UNCOMMITTED`
+    Timestamp commit_ts{};
+    std::vector<char> image;
+  };
+
+  /**
+   * The records changed by a committed transaction whose versions some
+   * snapshot may still need
+   */
+  struct CommittedTxn {
+    Timestamp commit_ts{};
+    int txn_id{};
+    std::vector<LockId> records;
+  };
+
+  /**
+   * @brief Drop the versions replaced by a committed transaction, and the
+   * older versions of the same records. The caller holds the mutex.
+   * @param txn_id id of the transaction
+   * @param records the records that the transaction changed
+   */
+  void Prune(int txn_id, const std::vector<LockId>& records);
+
+  static constexpr Timestamp UNCOMMITTED = INT64_MAX;
+
+  std::atomic<bool> enabled_{};
+  std::mutex mutex_;
+  Timestamp clock_{};
+  Lsn commit_lsn_{INVALID_LSN};
+  // the version chain of each record, newest first
+  std::unordered_map<LockId, std::deque<Version>> chains_;
+  // the records changed by each uncommitted transaction
+  std::unordered_map<int, std::vector<LockId>> txn_records_;
+  // the number of active snapshots taken at each timestamp
+  std::map<Timestamp, int> snapshots_;
+  // in commit order
+  std::deque<CommittedTxn> committed_;
+};
+}  // namespace simpledb
@@ -0,0 +1,103 @@
+#include "txn/concurrency/version_table.h"
+
+#include <limits>
+#include <utility>
+
+namespace simpledb {
+VersionTable::Version VersionTable::Begin() {
+  std::scoped_lock guard{mutex_};
+  Version start = clock_;
+  active_[start]++;
+  return start;
+}
+
+void VersionTable::End(Version start) {
+  std::scoped_lock guard{mutex_};
+  auto iter = active_.find(start);
+  if (--iter->second == 0) {
+    active_.erase(iter);
+  }
+  Prune();
+}
+
+std::optional<VersionTable::Version> VersionTable::Read(const LockId& id,
+                                                        int txn_id) {
+  auto& stripe = GetStripe(id);
+  std::scoped_lock guard{stripe.mutex};
+  auto iter = stripe.entries.find(id);
+  if (iter == stripe.entries.end()) {
+    return 0;
+  }
+  if (iter->second.writer != NO_WRITER && iter->second.writer != txn_id) {
+    return std::nullopt;
+  }
+  return iter->second.version;
+}
+
+bool VersionTable::Acquire(const LockId& id, int txn_id) {
+  auto& stripe = GetStripe(id);
+  std::scoped_lock guard{stripe.mutex};
+  auto& entry = stripe.entries[id];
+  if (entry.writer != NO_WRITER && entry.writer != txn_id) {
+    return false;
+  }
+  entry.writer = txn_id;
+  return true;
+}
+
+bool VersionTable::Validate(const LockId& id, int txn_id, Version version) {
+  auto& stripe = GetStripe(id);
+  std::scoped_lock guard{stripe.mutex};
+  auto iter = stripe.entries.find(id);
+  // A dropped entry was last released before the reader started, so the
+  // reader saw its final version
+  if (iter == stripe.entries.end()) {
+    return true;
+  }
+  auto& entry = iter->second;
+  if (entry.writer != NO_WRITER && entry.writer != txn_id) {
+    return false;
+  }
+  // An entry claimed while it was dropped keeps version 0 until it is
+  // released
+  return entry.version == version || entry.version == 0;
+}
+
+void VersionTable::Release(const std::vector<LockId>& ids) {
+  if (ids.empty()) {
+    return;
+  }
+  // The new version is later than the start of every active transaction, so
+  // a reader that saw the old one fails validation
+  Version version = ++clock_;
+  for (const auto& id : ids) {
+    auto& stripe = GetStripe(id);
+    std::scoped_lock guard{stripe.mutex};
+    auto& entry = stripe.entries[id];
+    entry.version = version;
+    entry.writer = NO_WRITER;
+  }
+  std::scoped_lock guard{mutex_};
+  released_.push_back(ReleasedItems{version, ids});
+  Prune();
+}
+
+void VersionTable::Prune() {
+  Version oldest = active_.empty() ? std::numeric_limits<Version>::max()
+                                   : active_.begin()->first;
+  while (!released_.empty() && released_.front().version <= oldest) {
+    for (const auto& id : released_.front().ids) {
+      auto& stripe = GetStripe(id);
+      std::scoped_lock guard{stripe.mutex};
+      auto iter = stripe.entries.find(id);
+      // The item may have been claimed or released again since
+      if (iter != stripe.entries.end() &&
+          iter->second.writer == NO_WRITER &&
+          iter->second.version <= oldest) {
+        stripe.entries.erase(iter);
+      }
+    }
+    released_.pop_front();
+  }
+}
+}  // namespace simpledb
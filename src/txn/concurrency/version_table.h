@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>  // NOLINT(build/c++11)
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "txn/concurrency/lock_id.h"
+
+namespace simpledb {
+/**
+ * The version table gives each item that optimistic transactions touch a
+ * version number and, while a transaction changes it, a writer. Items are
+ * identified like locks: files, blocks, or records.
+ *
+ * A reader notes the version of an item before it reads the item, and checks
+ * at commit that the version is unchanged and that no one is writing the item.
+ * A writer claims the item before it changes it, and gives it a new version
+ * when it ends, whether it commits or rolls back. Versions come from a global
+ * clock, so they never repeat.
+ *
+ * Items nobody has written have no entry, and read as version 0. Once an
+ * unclaimed entry is older than every active transaction, no reader can still
+ * hold an older version of it, so the entry is dropped and reads as 0 again:
+ * a transaction that noted its version sees it unchanged.
+ *
+ * Like the lock table, the table is partitioned into stripes by the hash of
+ * the item.
+ */
+class VersionTable {
+ public:
+  using Version = uint64_t;
+
+  /**
+   * @brief Register an optimistic transaction that starts
+   * @return the clock value when the transaction starts
+   */
+  Version Begin();
+
+  /**
+   * @brief Unregister a transaction, and drop the entries that no active
+   * transaction needs any more
+   * @param start the value that `Begin` returned for the transaction
+   */
+  void End(Version start);
+
+  /**
+   * @brief Return the version of an item that a transaction is about to read
+   * @param id the item
+   * @param txn_id id of the reading transaction
+   * @return the version, or nothing if another transaction is writing the item
+   */
+  std::optional<Version> Read(const LockId& id, int txn_id);
+
+  /**
+   * @brief Claim an item for writing
+   * @param id the item
+   * @param txn_id id of the writing transaction
+   * @return true if the item is now claimed by the transaction; false if
+   * another transaction has claimed it
+   */
+  bool Acquire(const LockId& id, int txn_id);
+
+  /**
+   * @brief Return whether an item that a transaction has read is unchanged
+   * @param id the item
+   * @param txn_id id of the reading transaction, which may have claimed the
+   * item since it read it
+   * @param version the version that `Read` returned
+   * @return true if the version is the same and no other transaction is
+   * writing the item; otherwise, false
+   */
+  bool Validate(const LockId& id, int txn_id, Version version);
+
+  /**
+   * @brief Give the items claimed by a transaction a new version and release
+   * them
+   * @param ids the claimed items
+   */
+  void Release(const std::vector<LockId>& ids);
+
+ private:
+  /**
+   * The version of an item and the transaction writing it, if any
+   */
+  struct Entry {
+    Version version{};
+    int writer{NO_WRITER};
+  };
+
+  /**
+   * A partition of the table and the latch that protects it
+   */
+  struct Stripe {
+    std::mutex mutex;
+    std::unordered_map<LockId, Entry> entries;
+  };
+
+  /**
+   * The items released by a transaction whose entries some active
+   * transaction may still need
+   */
+  struct ReleasedItems {
+    Version version{};
+    std::vector<LockId> ids;
+  };
+
+  /**
+   * @brief Drop the entries released before every active transaction
+   * started. The caller holds the mutex.
+   */
+  void Prune();
+
+  /**
+   * @brief Return the stripe that holds the entry of the specified item
+   * @param id the item
+   * @return a reference to the stripe
+   */
+  Stripe& GetStripe(const LockId& id) noexcept {
+    return stripes_[std::hash<LockId>{}(id) % NUM_STRIPES];
+  }
+
+  static constexpr int NO_WRITER = -1;
+  static constexpr size_t NUM_STRIPES = 64;
+  std::array<Stripe, NUM_STRIPES> stripes_;
+  std::atomic<Version> clock_{};
+  // Protects the active transactions and the released items. Its latch is
+  // taken before a stripe latch, never after.
+  std::mutex mutex_;
+  // the number of active transactions started at each clock value
+  std::map<Version, int> active_;
+  // in release order
+  std::deque<ReleasedItems> released_;
+};
+}  // namespace simpledb
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "buffer/buffer.h"
+
+namespace simpledb {
+/**
+ * A handle to a buffer that a transaction has pinned. Page classes obtain a
+ * handle once per block and pass it to the field accessors of the transaction,
+ * which then reach the buffer directly instead of looking it up by block on
+ * every access. The handle is valid while the transaction keeps the block
+ * pinned; it does not lock anything, so the caller locks the block or the
+ * records it accesses before using it.
+ */
+class PageHandle {
+ public:
+  PageHandle() = default;
+
+  /**
+   * @brief Create a handle to a pinned buffer
+   * @param buffer the buffer pinned by the transaction
+   */
+  explicit PageHandle(Buffer* buffer) noexcept : buffer_(buffer) {}
+
+  /**
+   * @brief Return the buffer of the handle
+   * @return the buffer pinned by the transaction
+   */
+  Buffer* GetBuffer() const noexcept { return buffer_; }
+
+  /**
+   * @brief Return whether the handle refers to a buffer
+   * @return true if the handle refers to a buffer
+   */
+  bool IsValid() const noexcept { return buffer_ != nullptr; }
+
+ private:
+  Buffer* buffer_{nullptr};
+};
+}  // namespace simpledb
@@ -0,0 +1,56 @@
+#include "txn/recovery/allocate_record.h"
+
+#include <memory>
+#include <span>  // NOLINT(build/include_order)
+#include <sstream>
+#include <vector>
+
+#include "file/block_id.h"
+#include "file/page.h"
+#include "log/log_manager.h"
+
+namespace simpledb {
+AllocateRecord::AllocateRecord(const Page& page) {
+  int txn_pos = sizeof(int);
+  int prev_lsn_pos = txn_pos + sizeof(int);
+  int file_pos = prev_lsn_pos + sizeof(Lsn);
+  int block_pos = file_pos + Page::StringLength(page.GetString(file_pos));
+  txn_id_ = page.GetInt(txn_pos);
+  prev_lsn_ = page.GetLong(prev_lsn_pos);
+  block_ = BlockId{page.GetString(file_pos), page.GetInt(block_pos)};
+}
+
+void AllocateRecord::Undo(Transaction& txn) {
+  std::vector<char> zeros(txn.BlockSize());
+  txn.Pin(block_);
+  txn.SetRow(block_, 0, zeros, RowOp::DELETE, false);
+  txn.Unpin(block_);
+}
+
+std::string AllocateRecord::ToString() const {
+  std::stringstream output;
+  output << "<ALLOCATE " << txn_id_ << ' ' << prev_lsn_ << ' '
+         << block_.ToString() << '>';
+
+  return output.str();
+}
+
+Lsn AllocateRecord::WriteToLog(LogManager& log_manager, int txn_id,
+                               Lsn prev_lsn, const BlockId& block) {
+  int txn_pos = sizeof(int);
+  int prev_lsn_pos = txn_pos + sizeof(int);
+  int file_pos = prev_lsn_pos + sizeof(Lsn);
+  int block_pos = file_pos + Page::StringLength(block.Filename());
+
+  size_t record_size = block_pos + sizeof(int);
+  auto record = std::make_unique<char[]>(record_size);
+  Page page{record.get(), record_size};
+  page.SetInt(0, static_cast<int>(LogType::ALLOCATE));
+  page.SetInt(txn_pos, txn_id);
+  page.SetLong(prev_lsn_pos, prev_lsn);
+  page.SetString(file_pos, block.Filename());
+  page.SetInt(block_pos, block.BlockNumber());
+
+  return log_manager.Append(std::span{record.get(), record_size});
+}
+}  // namespace simpledb
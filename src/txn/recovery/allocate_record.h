@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+
+#include "file/block_id.h"
+#include "file/page.h"
+#include "log/log_manager.h"
+#include "txn/recovery/log_record.h"
+#include "txn/transaction.h"
+
+namespace simpledb {
+/**
+ * The ALLOCATE log record. It records that a transaction appended a block to
+ * a file and fills it without logging its contents, as a bulk load does.
+ * Undoing it empties the block again; there is nothing to redo, because the
+ * transaction forces the block to disk before it commits.
+ */
+class AllocateRecord : public LogRecord {
+ public:
+  /**
+   * @brief Construct a new ALLOCATE log record that uses the given `page` as
+   * the underlying storage
+   * @param page the page containing the log values
+   */
+  explicit AllocateRecord(const Page& page);
+
+  /**
+   * @brief Return the log record's type
+   * @return the log record's type
+   */
+  LogType Op() const noexcept override { return LogType::ALLOCATE; }
+
+  /**
+   * @brief Return the transaction id stored with the log record
+   * @return the log record's transaction id
+   */
+  int TxnId() const noexcept override { return txn_id_; }
+
+  /**
+   * @brief Zero the contents of the allocated block
+   * @param txn the transaction to undo
+   */
+  void Undo(Transaction& txn) override;
+
+  /**
+   * @brief Return the string representation of the ALLOCATE log record
+   * @return the string representation of this record
+   */
+  std::string ToString() const;
+
+  /**
+   * @brief Write an ALLOCATE record to the log. This log record contains the
+   * ALLOCATE operator, followed by the transaction id, the LSN of the
+   * transaction's previous log record, filename, and block number.
+   * @param log_manager log manager of the database engine
+   * @param txn_id transaction id
+   * @param prev_lsn LSN of the transaction's previous log record
+   * @param block a reference to the allocated disk block
+   * @return LSN of the last log value
+   */
+  static Lsn WriteToLog(LogManager& log_manager, int txn_id, Lsn prev_lsn,
+                        const BlockId& block);
+
+ private:
+  int txn_id_{};
+  Lsn prev_lsn_{INVALID_LSN};
+  BlockId block_;
+};
+}  // namespace simpledb
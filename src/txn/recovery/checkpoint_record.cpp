@@ -1,19 +1,160 @@
 #include "txn/recovery/checkpoint_record.h"
 
+#include <algorithm>
 #include <memory>
 #include <span>  // NOLINT(build/include_order)
+#include <sstream>
+#include <utility>
+#include <vector>
 
 #include "file/page.h"
 #include "log/log_manager.h"
 #include "txn/recovery/log_record.h"
 
 namespace simpledb {
-int CheckpointRecord::WriteToLog(LogManager& log_manager) {
-  size_t record_size = sizeof(int);
+CheckpointRecord::CheckpointRecord(const Page& page) {
+  int pos = sizeof(int);
+  snapshot_lsn_ = page.GetLong(pos);
+  pos += sizeof(Lsn);
+  part_ = page.GetInt(pos);
+  parts_ = page.GetInt(pos + sizeof(int));
+  pos += 2 * sizeof(int);
+
+  int num_txns = page.GetInt(pos);
+  pos += sizeof(int);
+  for (int i = 0; i < num_txns; i++) {
+    int txn_id = page.GetInt(pos);
+    Lsn start_lsn = page.GetLong(pos + sizeof(int));
+    active_txns_.emplace_back(txn_id, start_lsn);
+    pos += sizeof(int) + sizeof(Lsn);
+  }
+
+  int num_pages = page.GetInt(pos);
+  pos += sizeof(int);
+  for (int i = 0; i < num_pages; i++) {
+    auto filename = page.GetString(pos);
+    pos += Page::StringLength(filename);
+    int block_num = page.GetInt(pos);
+    Lsn recovery_lsn = page.GetLong(pos + sizeof(int));
+    dirty_pages_.emplace_back(BlockId{filename, block_num}, recovery_lsn);
+    pos += sizeof(int) + sizeof(Lsn);
+  }
+}
+
+std::string CheckpointRecord::ToString() const {
+  std::stringstream output;
+  output << "<CHECKPOINT " << snapshot_lsn_ << ' ' << part_ + 1 << '/'
+         << parts_ << " {";
+  for (const auto& [txn_id, start_lsn] : active_txns_) {
+    output << ' ' << txn_id << ':' << start_lsn;
+  }
+  output << " } {";
+  for (const auto& [block, recovery_lsn] : dirty_pages_) {
+    output << ' ' << block.ToString() << ':' << recovery_lsn;
+  }
+  output << " }>";
+
+  return output.str();
+}
+
+Lsn CheckpointRecord::RedoLsn(
+    Lsn snapshot_lsn, std::span<const std::pair<int, Lsn>> active_txns,
+    std::span<const std::pair<BlockId, Lsn>> dirty_pages) {
+  Lsn redo_lsn = snapshot_lsn;
+  for (const auto& [txn_id, start_lsn] : active_txns) {
+    redo_lsn = std::min(redo_lsn, start_lsn);
+  }
+  for (const auto& [block, recovery_lsn] : dirty_pages) {
+    redo_lsn = std::min(redo_lsn, recovery_lsn);
+  }
+
+  return redo_lsn;
+}
+
+Lsn CheckpointRecord::WriteToLog(
+    LogManager& log_manager, Lsn snapshot_lsn,
+    const std::vector<std::pair<int, Lsn>>& active_txns,
+    const std::vector<std::pair<BlockId, Lsn>>& dirty_pages) {
+  // Cut the tables into parts that each fit in a log block. A part ends
+  // where its shares of the two tables end.
+  std::vector<std::pair<size_t, size_t>> part_ends;
+  int max_size = log_manager.MaxRecordSize();
+  int size = HEADER_SIZE;
+  for (size_t i = 0; i < active_txns.size(); i++) {
+    if (size + TXN_ENTRY_SIZE > max_size) {
+      part_ends.emplace_back(i, 0);
+      size = HEADER_SIZE;
+    }
+    size += TXN_ENTRY_SIZE;
+  }
+  for (size_t i = 0; i < dirty_pages.size(); i++) {
+    int entry_size = PageEntrySize(dirty_pages[i].first);
+    if (size + entry_size > max_size) {
+      part_ends.emplace_back(active_txns.size(), i);
+      size = HEADER_SIZE;
+    }
+    size += entry_size;
+  }
+  part_ends.emplace_back(active_txns.size(), dirty_pages.size());
+
+  std::span<const std::pair<int, Lsn>> txns{active_txns};
+  std::span<const std::pair<BlockId, Lsn>> pages{dirty_pages};
+  int parts = part_ends.size();
+  size_t txn_begin = 0;
+  size_t page_begin = 0;
+  Lsn lsn = INVALID_LSN;
+  for (int part = 0; part < parts; part++) {
+    auto [txn_end, page_end] = part_ends[part];
+    lsn = WritePart(log_manager, snapshot_lsn, part, parts,
+                    txns.subspan(txn_begin, txn_end - txn_begin),
+                    pages.subspan(page_begin, page_end - page_begin));
+    txn_begin = txn_end;
+    page_begin = page_end;
+  }
+
+  return lsn;
+}
+
+Lsn CheckpointRecord::WritePart(
+    LogManager& log_manager, Lsn snapshot_lsn, int part, int parts,
+    std::span<const std::pair<int, Lsn>> active_txns,
+    std::span<const std::pair<BlockId, Lsn>> dirty_pages) {
+  size_t record_size = HEADER_SIZE + active_txns.size() * TXN_ENTRY_SIZE;
+  for (const auto& [block, recovery_lsn] : dirty_pages) {
+    record_size += PageEntrySize(block);
+  }
   auto record = std::make_unique<char[]>(record_size);
   Page page{record.get(), record_size};
   page.SetInt(0, static_cast<int>(LogType::CHECKPOINT));
+  int pos = sizeof(int);
+  page.SetLong(pos, snapshot_lsn);
+  pos += sizeof(Lsn);
+  page.SetInt(pos, part);
+  page.SetInt(pos + sizeof(int), parts);
+  pos += 2 * sizeof(int);
+
+  page.SetInt(pos, active_txns.size());
+  pos += sizeof(int);
+  for (const auto& [txn_id, start_lsn] : active_txns) {
+    page.SetInt(pos, txn_id);
+    page.SetLong(pos + sizeof(int), start_lsn);
+    pos += TXN_ENTRY_SIZE;
+  }
+
+  page.SetInt(pos, dirty_pages.size());
+  pos += sizeof(int);
+  for (const auto& [block, recovery_lsn] : dirty_pages) {
+    page.SetString(pos, block.Filename());
+    pos += Page::StringLength(block.Filename());
+    page.SetInt(pos, block.BlockNumber());
+    page.SetLong(pos + sizeof(int), recovery_lsn);
+    pos += sizeof(int) + sizeof(Lsn);
+  }
 
   return log_manager.Append(std::span{record.get(), record_size});
 }
+
+int CheckpointRecord::PageEntrySize(const BlockId& block) noexcept {
+  return Page::StringLength(block.Filename()) + sizeof(int) + sizeof(Lsn);
+}
 }  // namespace simpledb
@@ -1,17 +1,35 @@
 #pragma once
 
+#include <span>  // NOLINT(build/include_order)
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "file/block_id.h"
+#include "file/page.h"
 #include "log/log_manager.h"
 #include "txn/recovery/log_record.h"
 #include "txn/transaction.h"
 
 namespace simpledb {
 /**
- * The CHECKPOINT log record
+ * The CHECKPOINT log record. Checkpoints are fuzzy: they are written while
+ * transactions keep running, and they save the active transaction table and
+ * the dirty page table instead of waiting for those tables to empty. Tables
+ * that do not fit in one log block are split over several CHECKPOINT records,
+ * the parts of the checkpoint, which are written one after another and share
+ * the checkpoint's snapshot LSN. Recovery ignores a checkpoint whose last part
+ * never reached the log.
  */
 class CheckpointRecord : public LogRecord {
  public:
+  /**
+   * @brief Construct a new CHECKPOINT log record that uses the given `page`
+   * as the underlying storage
+   * @param page the page containing the log values
+   */
+  explicit CheckpointRecord(const Page& page);
+
   /**
    * @brief Return the log record's type
    * @return the log record's type
@@ -35,14 +53,121 @@ class CheckpointRecord : public LogRecord {
    * @brief Return the string representation of the CHECKPOINT log record
    * @return the string representation of this log record
    */
-  std::string ToString() const noexcept { return "<CHECKPOINT>"; }
+  std::string ToString() const;
+
+  /**
+   * @brief Return the LSN at which the checkpoint's tables were captured, which
+   * identifies the checkpoint that this record is part of
+   * @return the snapshot LSN
+   */
+  Lsn SnapshotLsn() const noexcept { return snapshot_lsn_; }
+
+  /**
+   * @brief Return the position of this record among the parts of its
+   * checkpoint
+   * @return the part number, starting from 0
+   */
+  int Part() const noexcept { return part_; }
 
   /**
-   * @brief Write this CHECKPOINT record to the log. This log record contains
-   * the CHECKPOINT operator and nothing else.
+   * @brief Return the number of records that make up the checkpoint
+   * @return the number of parts
+   */
+  int Parts() const noexcept { return parts_; }
+
+  /**
+   * @brief Return the transactions in this part of the checkpoint that were
+   * active when it was taken
+   * @return the ids of the active transactions and the LSNs of their START
+   * records
+   */
+  const std::vector<std::pair<int, Lsn>>& ActiveTxns() const noexcept {
+    return active_txns_;
+  }
+
+  /**
+   * @brief Return the blocks in this part of the checkpoint that were dirty
+   * when it was taken
+   * @return the dirty blocks and their recovery LSNs
+   */
+  const std::vector<std::pair<BlockId, Lsn>>& DirtyPages() const noexcept {
+    return dirty_pages_;
+  }
+
+  /**
+   * @brief Return the LSN where recovery starts reading the log forward. It
+   * is the oldest of the LSN at which the tables were captured, the START
+   * records of the active transactions, and the recovery LSNs of the dirty
+   * pages. Every update that may be missing from the disk, and every record of
+   * a transaction that may need undo, is at or after this LSN. For a split
+   * checkpoint, it is the oldest of the LSNs of its parts.
+   * @return the LSN to start recovery from, as far as this part knows
+   */
+  Lsn RedoLsn() const noexcept {
+    return RedoLsn(snapshot_lsn_, active_txns_, dirty_pages_);
+  }
+
+  /**
+   * @brief Return the LSN where recovery starts for a checkpoint holding the
+   * specified tables
+   * @param snapshot_lsn the latest LSN when the tables were captured
+   * @param active_txns the active transaction table
+   * @param dirty_pages the dirty page table
+   * @return the LSN to start recovery from
+   */
+  static Lsn RedoLsn(Lsn snapshot_lsn,
+                     std::span<const std::pair<int, Lsn>> active_txns,
+                     std::span<const std::pair<BlockId, Lsn>> dirty_pages);
+
+  /**
+   * @brief Write a checkpoint to the log, split over as many CHECKPOINT records
+   * as its tables need. Each record contains the CHECKPOINT operator, followed
+   * by the LSN at which the tables were captured, the part number and the
+   * number of parts, its share of the active transaction table (count, then id
+   * and START LSN of each transaction), and its share of the dirty page table
+   * (count, then filename, block number, and recovery LSN of each block).
+   * @param log_manager log manager of the database engine
+   * @param snapshot_lsn the latest LSN when the tables were captured
+   * @param active_txns the active transaction table
+   * @param dirty_pages the dirty page table
+   * @return LSN of the checkpoint's last record
+   */
+  static Lsn WriteToLog(LogManager& log_manager, Lsn snapshot_lsn,
+                        const std::vector<std::pair<int, Lsn>>& active_txns,
+                        const std::vector<std::pair<BlockId, Lsn>>& dirty_pages);
+
+ private:
+  /**
+   * @brief Write one part of a checkpoint to the log
    * @param log_manager log manager of the database engine
-   * @return LSN of the last log value
+   * @param snapshot_lsn the latest LSN when the tables were captured
+   * @param part the part number
+   * @param parts the number of parts
+   * @param active_txns the part's share of the active transaction table
+   * @param dirty_pages the part's share of the dirty page table
+   * @return LSN of the record
+   */
+  static Lsn WritePart(LogManager& log_manager, Lsn snapshot_lsn, int part,
+                       int parts,
+                       std::span<const std::pair<int, Lsn>> active_txns,
+                       std::span<const std::pair<BlockId, Lsn>> dirty_pages);
+
+  /**
+   * @brief Return the number of bytes that a dirty page takes in a record
+   * @param block the dirty block
+   * @return the size of its entry in bytes
    */
-  static int WriteToLog(LogManager& log_manager);
+  static int PageEntrySize(const BlockId& block) noexcept;
+
+  // The operator, the snapshot LSN, the part number, the number of parts, and
+  // the sizes of the two tables
+  static constexpr int HEADER_SIZE = 5 * sizeof(int) + sizeof(Lsn);
+  static constexpr int TXN_ENTRY_SIZE = sizeof(int) + sizeof(Lsn);
+
+  Lsn snapshot_lsn_{INVALID_LSN};
+  int part_{};
+  int parts_{1};
+  std::vector<std::pair<int, Lsn>> active_txns_;
+  std::vector<std::pair<BlockId, Lsn>> dirty_pages_;
 };
 }  // namespace simpledb
@@ -11,22 +11,26 @@
 namespace simpledb {
 CommitRecord::CommitRecord(const Page& page) {
   int txn_pos = sizeof(int);
+  int prev_lsn_pos = txn_pos + sizeof(int);
   txn_id_ = page.GetInt(txn_pos);
+  prev_lsn_ = page.GetLong(prev_lsn_pos);
 }
 
 std::string CommitRecord::ToString() const {
   std::stringstream output;
-  output << "<COMMMIT " << txn_id_ << '>';
+  output << "<COMMMIT " << txn_id_ << ' ' << prev_lsn_ << '>';
 
   return output.str();
 }
 
-int CommitRecord::WriteToLog(LogManager& log_manager, int txn_id) {
-  size_t record_size = 2 * sizeof(int);
+Lsn CommitRecord::WriteToLog(LogManager& log_manager, int txn_id,
+                             Lsn prev_lsn) {
+  size_t record_size = 2 * sizeof(int) + sizeof(Lsn);
   auto record = std::make_unique<char[]>(record_size);
   Page page{record.get(), record_size};
   page.SetInt(0, static_cast<int>(LogType::COMMIT));
   page.SetInt(sizeof(int), txn_id);
+  page.SetLong(2 * sizeof(int), prev_lsn);
 
   return log_manager.Append(std::span{record.get(), record_size});
 }
@@ -46,14 +46,17 @@ class CommitRecord : public LogRecord {
 
   /**
    * @brief Write this COMMIT record to the log. This log record contains the
-   * COMMIT operator, followed by the transaction id.
+   * COMMIT operator, followed by the transaction id and the LSN of the
+   * transaction's previous log record.
    * @param log_manager log manager of the database engine
    * @param txn_id transaction id
+   * @param prev_lsn LSN of the transaction's previous log record
    * @return LSN of the last log value
    */
-  static int WriteToLog(LogManager& log_manager, int txn_id);
+  static Lsn WriteToLog(LogManager& log_manager, int txn_id, Lsn prev_lsn);
 
  private:
   int txn_id_{};
+  Lsn prev_lsn_{INVALID_LSN};
 };
 }  // namespace simpledb
@@ -0,0 +1,127 @@
+#include "txn/recovery/compensation_record.h"
+
+#include <memory>
+#include <span>  // NOLINT(build/include_order)
+#include <sstream>
+
+#include "file/block_id.h"
+#include "file/page.h"
+#include "log/log_manager.h"
+
+namespace simpledb {
+CompensationRecord::CompensationRecord(const Page& page) {
+  int txn_pos = sizeof(int);
+  int prev_lsn_pos = txn_pos + sizeof(int);
+  int undo_next_pos = prev_lsn_pos + sizeof(Lsn);
+  int undone_op_pos = undo_next_pos + sizeof(Lsn);
+  int file_pos = undone_op_pos + sizeof(int);
+  int block_pos = file_pos + Page::StringLength(page.GetString(file_pos));
+  int offset_pos = block_pos + sizeof(int);
+  int val_pos = offset_pos + sizeof(int);
+
+  txn_id_ = page.GetInt(txn_pos);
+  prev_lsn_ = page.GetLong(prev_lsn_pos);
+  undo_next_lsn_ = page.GetLong(undo_next_pos);
+  undone_op_ = static_cast<LogType>(page.GetInt(undone_op_pos));
+  block_ = BlockId{page.GetString(file_pos), page.GetInt(block_pos)};
+  offset_ = page.GetInt(offset_pos);
+  if (undone_op_ == LogType::SETINT) {
+    int_val_ = page.GetInt(val_pos);
+  } else if (undone_op_ == LogType::SETSTRING) {
+    string_val_ = page.GetString(val_pos);
+  } else {
+    auto image = page.GetBytes(val_pos);
+    string_val_.assign(image.begin(), image.end());
+  }
+}
+
+std::string CompensationRecord::ToString() const {
+  std::stringstream output;
+  output << "<CLR " << txn_id_ << ' ' << prev_lsn_ << ' ' << undo_next_lsn_
+         << ' ' << block_.ToString() << ' ' << offset_ << ' ';
+  if (undone_op_ == LogType::SETINT) {
+    output << int_val_;
+  } else if (undone_op_ == LogType::SETSTRING) {
+    output << string_val_;
+  } else {
+    output << string_val_.size() << " bytes";
+  }
+  output << '>';
+
+  return output.str();
+}
+
+Lsn CompensationRecord::WriteToLog(LogManager& log_manager, int txn_id,
+                                   Lsn prev_lsn, Lsn undo_next_lsn,
+                                   std::string_view filename, int block_num,
+                                   int offset, int val) {
+  int val_pos = HeaderSize(filename);
+  size_t record_size = val_pos + sizeof(int);
+  auto record = std::make_unique<char[]>(record_size);
+  Page page{record.get(), record_size};
+  WriteHeader(page, txn_id, prev_lsn, undo_next_lsn, LogType::SETINT, filename,
+              block_num, offset);
+  page.SetInt(val_pos, val);
+
+  return log_manager.Append(std::span{record.get(), record_size});
+}
+
+Lsn CompensationRecord::WriteToLog(LogManager& log_manager, int txn_id,
+                                   Lsn prev_lsn, Lsn undo_next_lsn,
+                                   std::string_view filename, int block_num,
+                                   int offset, std::string_view val) {
+  int val_pos = HeaderSize(filename);
+  size_t record_size = val_pos + Page::StringLength(val);
+  auto record = std::make_unique<char[]>(record_size);
+  Page page{record.get(), record_size};
+  WriteHeader(page, txn_id, prev_lsn, undo_next_lsn, LogType::SETSTRING,
+              filename, block_num, offset);
+  page.SetString(val_pos, val);
+
+  return log_manager.Append(std::span{record.get(), record_size});
+}
+
+Lsn CompensationRecord::WriteToLog(LogManager& log_manager, int txn_id,
+                                   Lsn prev_lsn, Lsn undo_next_lsn,
+                                   LogType undone_op, std::string_view filename,
+                                   int block_num, int offset,
+                                   std::span<const char> image) {
+  int val_pos = HeaderSize(filename);
+  size_t record_size = val_pos + sizeof(int) + image.size();
+  auto record = std::make_unique<char[]>(record_size);
+  Page page{record.get(), record_size};
+  WriteHeader(page, txn_id, prev_lsn, undo_next_lsn, undone_op, filename,
+              block_num, offset);
+  // `SetBytes` does not modify the bytes, so casting away const is safe
+  page.SetBytes(val_pos,
+                std::span{const_cast<char*>(image.data()), image.size()});
+
+  return log_manager.Append(std::span{record.get(), record_size});
+}
+
+int CompensationRecord::HeaderSize(std::string_view filename) noexcept {
+  return 5 * sizeof(int) + 2 * sizeof(Lsn) + Page::StringLength(filename);
+}
+
+void CompensationRecord::WriteHeader(Page& page, int txn_id, Lsn prev_lsn,
+                                     Lsn undo_next_lsn, LogType undone_op,
+                                     std::string_view filename, int block_num,
+                                     int offset) {
+  int txn_pos = sizeof(int);
+  int prev_lsn_pos = txn_pos + sizeof(int);
+  int undo_next_pos = prev_lsn_pos + sizeof(Lsn);
+  int undone_op_pos = undo_next_pos + sizeof(Lsn);
+  int file_pos = undone_op_pos + sizeof(int);
+  int block_pos = file_pos + Page::StringLength(filename);
+  int offset_pos = block_pos + sizeof(int);
+
+  page.SetInt(0, static_cast<int>(LogType::COMPENSATION));
+  page.SetInt(txn_pos, txn_id);
+  page.SetLong(prev_lsn_pos, prev_lsn);
+  page.SetLong(undo_next_pos, undo_next_lsn);
+  page.SetInt(undone_op_pos, static_cast<int>(undone_op));
+  page.SetString(file_pos, filename);
+  page.SetInt(block_pos, block_num);
+  page.SetInt(offset_pos, offset);
+}
+}  // namespace simpledb
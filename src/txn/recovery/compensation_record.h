@@ -0,0 +1,147 @@
+#pragma once
+
+#include <span>  // NOLINT(build/include_order)
+#include <string>
+#include <string_view>
+
+#include "file/block_id.h"
+#include "file/page.h"
+#include "log/log_manager.h"
+#include "txn/recovery/log_record.h"
+#include "txn/transaction.h"
+
+namespace simpledb {
+/**
+ * The compensation log record (CLR). A CLR is written for every update undone
+ * during a rollback or recovery and records the value that the undo restored.
+ * CLRs are redone like ordinary updates but never undone: their undo-next LSN
+ * points at the next record of the transaction that still needs undo, so an
+ * interrupted rollback resumes where it stopped instead of undoing an update
+ * twice.
+ */
+class CompensationRecord : public LogRecord {
+ public:
+  /**
+   * @brief Construct a new compensation log record that uses the given `page`
+   * as the underlying storage
+   * @param page the page containing the log values
+   */
+  explicit CompensationRecord(const Page& page);
+
+  /**
+   * @brief Return the log record's type
+   * @return the log record's type
+   */
+  LogType Op() const noexcept override { return LogType::COMPENSATION; }
+
+  /**
+   * @brief Return the transaction id stored with the log record
+   * @return the log record's transaction id
+   */
+  int TxnId() const noexcept override { return txn_id_; }
+
+  /**
+   * @brief Do nothing because compensation log records are never undone
+   * @param txn the transaction to undo
+   */
+  void Undo([[maybe_unused]] Transaction& txn) override {}
+
+  /**
+   * @brief Return the string representation of this compensation log record
+   * @return the string representation of this record
+   */
+  std::string ToString() const;
+
+  /**
+   * @brief Write a compensation log record for an undone SETINT record. This
+   * log record contains the COMPENSATION operator, followed by the transaction
+   * id, the LSN of the transaction's previous log record, the undo-next LSN,
+   * the operator of the undone record, filename, block number, offset within
+   * the block, and the restored value.
+   * @param log_manager log manager of the database engine
+   * @param txn_id transaction id
+   * @param prev_lsn LSN of the transaction's previous log record
+   * @param undo_next_lsn LSN of the next record to undo
+   * @param filename name of the file holding the block
+   * @param block_num block number within the file
+   * @param offset offset in the block
+   * @param val the restored value at the specified offset
+   * @return LSN of the last log value
+   */
+  static Lsn WriteToLog(LogManager& log_manager, int txn_id, Lsn prev_lsn,
+                        Lsn undo_next_lsn, std::string_view filename,
+                        int block_num, int offset, int val);
+
+  /**
+   * @brief Write a compensation log record for an undone SETSTRING record. The
+   * layout is the same as for a SETINT record, except that the restored value
+   * is a string.
+   * @param log_manager log manager of the database engine
+   * @param txn_id transaction id
+   * @param prev_lsn LSN of the transaction's previous log record
+   * @param undo_next_lsn LSN of the next record to undo
+   * @param filename name of the file holding the block
+   * @param block_num block number within the file
+   * @param offset offset in the block
+   * @param val the restored value at the specified offset
+   * @return LSN of the last log value
+   */
+  static Lsn WriteToLog(LogManager& log_manager, int txn_id, Lsn prev_lsn,
+                        Lsn undo_next_lsn, std::string_view filename,
+                        int block_num, int offset, std::string_view val);
+
+  /**
+   * @brief Write a compensation log record for an undone row record. The
+   * layout is the same as for a SETINT record, except that the restored value
+   * is the old image of the row.
+   * @param log_manager log manager of the database engine
+   * @param txn_id transaction id
+   * @param prev_lsn LSN of the transaction's previous log record
+   * @param undo_next_lsn LSN of the next record to undo
+   * @param undone_op the operator of the undone row record
+   * @param filename name of the file holding the block
+   * @param block_num block number within the file
+   * @param offset offset of the image in the block
+   * @param image the restored image at the specified offset
+   * @return LSN of the last log value
+   */
+  static Lsn WriteToLog(LogManager& log_manager, int txn_id, Lsn prev_lsn,
+                        Lsn undo_next_lsn, LogType undone_op,
+                        std::string_view filename, int block_num, int offset,
+                        std::span<const char> image);
+
+ private:
+  /**
+   * @brief Return the size of a compensation log record, excluding the
+   * restored value
+   * @param filename name of the file holding the block
+   * @return the size of the record header in bytes
+   */
+  static int HeaderSize(std::string_view filename) noexcept;
+
+  /**
+   * @brief Write the fields that precede the restored value
+   * @param page the page holding the record
+   * @param txn_id transaction id
+   * @param prev_lsn LSN of the transaction's previous log record
+   * @param undo_next_lsn LSN of the next record to undo
+   * @param undone_op the operator of the undone record
+   * @param filename name of the file holding the block
+   * @param block_num block number within the file
+   * @param offset offset in the block
+   */
+  static void WriteHeader(Page& page, int txn_id, Lsn prev_lsn,
+                          Lsn undo_next_lsn, LogType undone_op,
+                          std::string_view filename, int block_num,
+                          int offset);
+
+  int txn_id_{};
+  Lsn prev_lsn_{INVALID_LSN};
+  Lsn undo_next_lsn_{INVALID_LSN};
+  LogType undone_op_{LogType::SETINT};
+  BlockId block_;
+  int offset_{};
+  int int_val_{};
+  std::string string_val_;  // a string value, or the image of a row
+};
+}  // namespace simpledb
@@ -0,0 +1,53 @@
+#include "txn/recovery/load_table_record.h"
+
+#include <memory>
+#include <span>  // NOLINT(build/include_order)
+#include <sstream>
+
+#include "file/page.h"
+#include "log/log_manager.h"
+
+namespace simpledb {
+LoadTableRecord::LoadTableRecord(const Page& page) {
+  int txn_pos = sizeof(int);
+  int prev_lsn_pos = txn_pos + sizeof(int);
+  int file_pos = prev_lsn_pos + sizeof(Lsn);
+  int blocks_pos = file_pos + Page::StringLength(page.GetString(file_pos));
+  int rows_pos = blocks_pos + sizeof(int);
+  txn_id_ = page.GetInt(txn_pos);
+  prev_lsn_ = page.GetLong(prev_lsn_pos);
+  filename_ = page.GetString(file_pos);
+  num_blocks_ = page.GetInt(blocks_pos);
+  num_rows_ = page.GetInt(rows_pos);
+}
+
+std::string LoadTableRecord::ToString() const {
+  std::stringstream output;
+  output << "<LOADTABLE " << txn_id_ << ' ' << prev_lsn_ << ' ' << filename_
+         << ' ' << num_blocks_ << ' ' << num_rows_ << '>';
+
+  return output.str();
+}
+
+Lsn LoadTableRecord::WriteToLog(LogManager& log_manager, int txn_id,
+                                Lsn prev_lsn, std::string_view filename,
+                                int num_blocks, int num_rows) {
+  int txn_pos = sizeof(int);
+  int prev_lsn_pos = txn_pos + sizeof(int);
+  int file_pos = prev_lsn_pos + sizeof(Lsn);
+  int blocks_pos = file_pos + Page::StringLength(filename);
+  int rows_pos = blocks_pos + sizeof(int);
+
+  size_t record_size = rows_pos + sizeof(int);
+  auto record = std::make_unique<char[]>(record_size);
+  Page page{record.get(), record_size};
+  page.SetInt(0, static_cast<int>(LogType::LOADTABLE));
+  page.SetInt(txn_pos, txn_id);
+  page.SetLong(prev_lsn_pos, prev_lsn);
+  page.SetString(file_pos, filename);
+  page.SetInt(blocks_pos, num_blocks);
+  page.SetInt(rows_pos, num_rows);
+
+  return log_manager.Append(std::span{record.get(), record_size});
+}
+}  // namespace simpledb
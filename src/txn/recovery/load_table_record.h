@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "file/page.h"
+#include "log/log_manager.h"
+#include "txn/recovery/log_record.h"
+#include "txn/transaction.h"
+
+namespace simpledb {
+/**
+ * The LOADTABLE log record. A bulk load writes it once, after filling its
+ * blocks, in place of a log record per inserted row. It documents the load
+ * and has nothing to undo or redo: the blocks themselves are covered by their
+ * ALLOCATE records.
+ */
+class LoadTableRecord : public LogRecord {
+ public:
+  /**
+   * @brief Construct a new LOADTABLE log record that uses the given `page` as
+   * the underlying storage
+   * @param page the page containing the log values
+   */
+  explicit LoadTableRecord(const Page& page);
+
+  /**
+   * @brief Return the log record's type
+   * @return the log record's type
+   */
+  LogType Op() const noexcept override { return LogType::LOADTABLE; }
+
+  /**
+   * @brief Return the transaction id stored with the log record
+   * @return the log record's transaction id
+   */
+  int TxnId() const noexcept override { return txn_id_; }
+
+  /**
+   * @brief Do nothing because the ALLOCATE records of the load undo it
+   * @param txn the transaction to undo
+   */
+  void Undo([[maybe_unused]] Transaction& txn) override {}
+
+  /**
+   * @brief Return the string representation of the LOADTABLE log record
+   * @return the string representation of this record
+   */
+  std::string ToString() const;
+
+  /**
+   * @brief Write a LOADTABLE record to the log. This log record contains the
+   * LOADTABLE operator, followed by the transaction id, the LSN of the
+   * transaction's previous log record, filename, the number of blocks loaded,
+   * and the number of rows loaded.
+   * @param log_manager log manager of the database engine
+   * @param txn_id transaction id
+   * @param prev_lsn LSN of the transaction's previous log record
+   * @param filename name of the loaded file
+   * @param num_blocks number of blocks appended by the load
+   * @param num_rows number of rows written by the load
+   * @return LSN of the last log value
+   */
+  static Lsn WriteToLog(LogManager& log_manager, int txn_id, Lsn prev_lsn,
+                        std::string_view filename, int num_blocks,
+                        int num_rows);
+
+ private:
+  int txn_id_{};
+  Lsn prev_lsn_{INVALID_LSN};
+  std::string filename_;
+  int num_blocks_{};
+  int num_rows_{};
+};
+}  // namespace simpledb
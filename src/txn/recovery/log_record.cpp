@@ -4,9 +4,13 @@
 #include <span>  // NOLINT(build/include_order)
 
 #include "file/page.h"
+#include "txn/recovery/allocate_record.h"
 #include "txn/recovery/checkpoint_record.h"
 #include "txn/recovery/commit_record.h"
+#include "txn/recovery/compensation_record.h"
+#include "txn/recovery/load_table_record.h"
 #include "txn/recovery/rollback_record.h"
+#include "txn/recovery/row_record.h"
 #include "txn/recovery/set_int_record.h"
 #include "txn/recovery/set_string_record.h"
 #include "txn/recovery/start_record.h"
@@ -16,7 +20,7 @@ std::unique_ptr<LogRecord> LogRecord::CreateLogRecord(std::span<char> bytes) {
   Page page{bytes.data(), bytes.size()};
   switch (static_cast<LogType>(page.GetInt(0))) {
     case LogType::CHECKPOINT:
-      return std::make_unique<CheckpointRecord>();
+      return std::make_unique<CheckpointRecord>(page);
     case LogType::START:
       return std::make_unique<StartRecord>(page);
     case LogType::COMMIT:
@@ -27,6 +31,16 @@ std::unique_ptr<LogRecord> LogRecord::CreateLogRecord(std::span<char> bytes) {
       return std::make_unique<SetIntRecord>(page);
     case LogType::SETSTRING:
       return std::make_unique<SetStringRecord>(page);
+    case LogType::COMPENSATION:
+      return std::make_unique<CompensationRecord>(page);
+    case LogType::INSERTROW:
+    case LogType::DELETEROW:
+    case LogType::UPDATEROW:
+      return std::make_unique<RowRecord>(page);
+    case LogType::ALLOCATE:
+      return std::make_unique<AllocateRecord>(page);
+    case LogType::LOADTABLE:
+      return std::make_unique<LoadTableRecord>(page);
     default:
       return nullptr;
   }
@@ -15,7 +15,13 @@ enum class LogType : int {
   COMMIT,
   ROLLBACK,
   SETINT,
-  SETSTRING
+  SETSTRING,
+  COMPENSATION,
+  INSERTROW,
+  DELETEROW,
+  UPDATEROW,
+  ALLOCATE,
+  LOADTABLE
 };
 
 /**
@@ -45,7 +51,9 @@ class LogRecord {
   virtual void Undo([[maybe_unused]] Transaction& txn) = 0;
 
   /**
-   * @brief Interpret the bytes returned by the log iterator.
+   * @brief Interpret the bytes returned by the log iterator. This allocates a
+   * record object per call; hot paths such as rollback and recovery decode
+   * with `LogRecordView` instead.
    * @param bytes the bytes to interpret
    * @return the log record encoded by the bytes
    */
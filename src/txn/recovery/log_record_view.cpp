@@ -0,0 +1,213 @@
+#include "txn/recovery/log_record_view.h"
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>  // NOLINT(build/c++11)
+#include <stdexcept>
+
+#include "file/page.h"
+#include "txn/recovery/compensation_record.h"
+
+namespace simpledb {
+namespace {
+/**
+ * @brief Read an integer and advance the position past it
+ * @param bytes the bytes of the log record
+ * @param pos the position to read at
+ * @return the integer at that position
+ */
+int ReadInt(std::span<const char> bytes, int& pos) noexcept {
+  int val;
+  std::memcpy(&val, bytes.data() + pos, sizeof(int));
+  pos += sizeof(int);
+  return val;
+}
+
+/**
+ * @brief Read a 64-bit integer and advance the position past it
+ * @param bytes the bytes of the log record
+ * @param pos the position to read at
+ * @return the 64-bit integer at that position
+ */
+int64_t ReadLong(std::span<const char> bytes, int& pos) noexcept {
+  int64_t val;
+  std::memcpy(&val, bytes.data() + pos, sizeof(int64_t));
+  pos += sizeof(int64_t);
+  return val;
+}
+
+/**
+ * @brief Read a string and advance the position past it
+ * @param bytes the bytes of the log record
+ * @param pos the position to read at
+ * @return a view of the string at that position
+ */
+std::string_view ReadString(std::span<const char> bytes, int& pos) noexcept {
+  int length = ReadInt(bytes, pos);
+  std::string_view s{bytes.data() + pos, static_cast<size_t>(length)};
+  pos += length;
+  return s;
+}
+
+/**
+ * @brief Read a blob of bytes and advance the position past it
+ * @param bytes the bytes of the log record
+ * @param pos the position to read at
+ * @return a view of the blob at that position
+ */
+std::span<const char> ReadBytes(std::span<const char> bytes,
+                                int& pos) noexcept {
+  int length = ReadInt(bytes, pos);
+  auto blob = bytes.subspan(pos, length);
+  pos += length;
+  return blob;
+}
+
+/**
+ * @brief Copy a row image into a page
+ * @param page the page to write to
+ * @param offset the offset of the image in the page
+ * @param image the image to copy
+ */
+void WriteImage(Page& page, int offset, std::span<const char> image) noexcept {
+  std::memcpy(page.Contents().data() + offset, image.data(), image.size());
+}
+
+/**
+ * @brief Zero the contents of a page, leaving it as freshly appended
+ * @param page the page to zero
+ */
+void ZeroPage(Page& page) noexcept {
+  std::memset(page.Contents().data(), 0, page.Contents().size());
+}
+}  // namespace
+
+LogRecordView LogRecordView::Decode(std::span<const char> bytes) noexcept {
+  LogRecordView view;
+  int pos = 0;
+  view.op = static_cast<LogType>(ReadInt(bytes, pos));
+  if (view.op == LogType::CHECKPOINT) {
+    return view;
+  }
+  view.txn_id = ReadInt(bytes, pos);
+  if (view.op == LogType::START) {
+    return view;
+  }
+  view.prev_lsn = ReadLong(bytes, pos);
+  if (view.op == LogType::SETINT || view.op == LogType::SETSTRING ||
+      IsRowOp(view.op)) {
+    view.filename = ReadString(bytes, pos);
+    view.block_num = ReadInt(bytes, pos);
+    view.offset = ReadInt(bytes, pos);
+    if (view.op == LogType::SETINT) {
+      view.old_int_val = ReadInt(bytes, pos);
+      view.new_int_val = ReadInt(bytes, pos);
+    } else if (view.op == LogType::SETSTRING) {
+      view.old_string_val = ReadString(bytes, pos);
+      view.new_string_val = ReadString(bytes, pos);
+    } else {
+      view.old_image = ReadBytes(bytes, pos);
+      view.new_image = ReadBytes(bytes, pos);
+    }
+  } else if (view.op == LogType::COMPENSATION) {
+    view.undo_next_lsn = ReadLong(bytes, pos);
+    view.undone_op = static_cast<LogType>(ReadInt(bytes, pos));
+    view.filename = ReadString(bytes, pos);
+    view.block_num = ReadInt(bytes, pos);
+    view.offset = ReadInt(bytes, pos);
+    if (view.undone_op == LogType::SETINT) {
+      view.new_int_val = ReadInt(bytes, pos);
+    } else if (view.undone_op == LogType::SETSTRING) {
+      view.new_string_val = ReadString(bytes, pos);
+    } else {
+      view.new_image = ReadBytes(bytes, pos);
+    }
+  } else if (view.op == LogType::ALLOCATE) {
+    view.filename = ReadString(bytes, pos);
+    view.block_num = ReadInt(bytes, pos);
+  }
+  return view;
+}
+
+Lsn LogRecordView::Undo(LogManager& log_manager,
+                        BufferManager& buffer_manager, int txn_id,
+                        Lsn prev_lsn) const {
+  if ((!IsUpdate() && op != LogType::ALLOCATE) ||
+      op == LogType::COMPENSATION) {
+    return prev_lsn;
+  }
+  auto buffer = buffer_manager.Pin(filename, block_num);
+  if (buffer == nullptr) {
+    throw std::runtime_error("No available buffer!");
+  }
+  Lsn lsn;
+  {
+    std::scoped_lock latch{buffer->Latch()};
+    if (op == LogType::SETINT) {
+      lsn = CompensationRecord::WriteToLog(log_manager, txn_id, prev_lsn,
+                                           this->prev_lsn, filename, block_num,
+                                           offset, old_int_val);
+      buffer->Contents().SetInt(offset, old_int_val);
+    } else if (op == LogType::SETSTRING) {
+      lsn = CompensationRecord::WriteToLog(log_manager, txn_id, prev_lsn,
+                                           this->prev_lsn, filename, block_num,
+                                           offset, old_string_val);
+      buffer->Contents().SetString(offset, old_string_val);
+    } else if (op == LogType::ALLOCATE) {
+      // The block was filled without logging, so the CLR carries no image
+      lsn = CompensationRecord::WriteToLog(log_manager, txn_id, prev_lsn,
+                                           this->prev_lsn, op, filename,
+                                           block_num, 0, {});
+      ZeroPage(buffer->Contents());
+    } else {
+      // An insert is undone by clearing the in-use flag, which is zero
+      char empty_flag[sizeof(int)]{};
+      auto image = op == LogType::INSERTROW ? std::span<const char>{empty_flag}
+                                            : old_image;
+      lsn = CompensationRecord::WriteToLog(log_manager, txn_id, prev_lsn,
+                                           this->prev_lsn, op, filename,
+                                           block_num, offset, image);
+      WriteImage(buffer->Contents(), offset, image);
+    }
+    buffer->SetModified(txn_id, lsn);
+  }
+  buffer_manager.Unpin(buffer);
+
+  return lsn;
+}
+
+void LogRecordView::Redo(BufferManager& buffer_manager, int txn_id,
+                         Lsn lsn) const {
+  if (!IsUpdate()) {
+    return;
+  }
+  auto buffer = buffer_manager.Pin(filename, block_num);
+  if (buffer == nullptr) {
+    throw std::runtime_error("No available buffer!");
+  }
+  Redo(*buffer, txn_id, lsn);
+  buffer_manager.Unpin(buffer);
+}
+
+void LogRecordView::Redo(Buffer& buffer, int txn_id, Lsn lsn) const {
+  if (!IsUpdate() || buffer.PageLsn() >= lsn) {
+    return;
+  }
+  LogType value_op = op == LogType::COMPENSATION ? undone_op : op;
+  if (value_op == LogType::SETINT) {
+    buffer.Contents().SetInt(offset, new_int_val);
+  } else if (value_op == LogType::SETSTRING) {
+    buffer.Contents().SetString(offset, new_string_val);
+  } else if (value_op == LogType::ALLOCATE) {
+    ZeroPage(buffer.Contents());
+  } else {
+    WriteImage(buffer.Contents(), offset, new_image);
+  }
+  buffer.SetModified(txn_id, lsn);
+}
+
+bool LogRecordView::IsUpdate() const noexcept {
+  return op == LogType::SETINT || op == LogType::SETSTRING ||
+         op == LogType::COMPENSATION || IsRowOp(op);
+}
+}  // namespace simpledb
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <span>  // NOLINT(build/include_order)
+#include <string_view>
+
+#include "buffer/buffer.h"
+#include "buffer/buffer_manager.h"
+#include "log/log_manager.h"
+#include "txn/recovery/log_record.h"
+#include "utils/data_type.h"
+
+namespace simpledb {
+/**
+ * A non-owning, flat view of a log record. Decoding a view reads the fields in
+ * place from the bytes returned by the log iterator: it allocates no memory,
+ * and string fields point into those bytes. The view is therefore only valid
+ * while the underlying bytes are (e.g., until the iterator moves to another
+ * log block). Fields that a record type does not have keep their defaults.
+ * Row records fill in `old_image` and `new_image`; an INSERTROW record has no
+ * old image, and undoing it clears the in-use flag of the slot. A compensation
+ * log record stores the value it restored in the `new_*` fields and the type
+ * of the undone record in `undone_op`; one that undoes an ALLOCATE record has
+ * no value and empties the whole block.
+ */
+struct LogRecordView {
+  LogType op{LogType::CHECKPOINT};
+  int txn_id{-1};
+  Lsn prev_lsn{INVALID_LSN};
+  Lsn undo_next_lsn{INVALID_LSN};
+  LogType undone_op{LogType::SETINT};
+  std::string_view filename;
+  int block_num{};
+  int offset{};
+  int old_int_val{};
+  int new_int_val{};
+  std::string_view old_string_val;
+  std::string_view new_string_val;
+  std::span<const char> old_image;
+  std::span<const char> new_image;
+
+  /**
+   * @brief Interpret the bytes returned by the log iterator
+   * @param bytes the bytes to interpret
+   * @return a view of the log record encoded by the bytes
+   */
+  static LogRecordView Decode(std::span<const char> bytes) noexcept;
+
+  /**
+   * @brief Undo the update encoded by this log record: write a compensation
+   * log record whose undo-next LSN is this record's previous LSN, then
+   * restore the old value. Only SETINT, SETSTRING, row, and ALLOCATE records
+   * have anything to undo; undoing an ALLOCATE record zeroes the block.
+   * @param log_manager log manager of the database engine
+   * @param buffer_manager buffer manager of the database engine
+   * @param txn_id id of the transaction being rolled back
+   * @param prev_lsn LSN of that transaction's latest log record
+   * @return LSN of the compensation log record, or `prev_lsn` if nothing was
+   * undone
+   */
+  Lsn Undo(LogManager& log_manager, BufferManager& buffer_manager, int txn_id,
+           Lsn prev_lsn) const;
+
+  /**
+   * @brief Reapply the update encoded by this log record, unless its block
+   * already reflects it, i.e., the block's page LSN is at least the record's
+   * LSN. Only SETINT, SETSTRING, row, and compensation log records have
+   * anything to redo.
+   * @param buffer_manager buffer manager of the database engine
+   * @param txn_id id of the recovering transaction, which becomes the
+   * modifying transaction of the block
+   * @param lsn the LSN of this log record
+   */
+  void Redo(BufferManager& buffer_manager, int txn_id, Lsn lsn) const;
+
+  /**
+   * @brief Reapply the update encoded by this log record to a buffer that
+   * already holds its block, unless the block reflects it
+   * @param buffer the buffer holding the record's block
+   * @param txn_id id of the recovering transaction, which becomes the
+   * modifying transaction of the block
+   * @param lsn the LSN of this log record
+   */
+  void Redo(Buffer& buffer, int txn_id, Lsn lsn) const;
+
+  /**
+   * @brief Return whether this log record updates a data block
+   * @return true for SETINT, SETSTRING, row, and compensation log records.
+   * ALLOCATE records are not updates: their blocks are forced before commit,
+   * so they have nothing to redo.
+   */
+  bool IsUpdate() const noexcept;
+
+  /**
+   * @brief Return whether a log record type describes a row operation
+   * @param op the log record type
+   * @return true for INSERTROW, DELETEROW, and UPDATEROW
+   */
+  static bool IsRowOp(LogType op) noexcept {
+    return op == LogType::INSERTROW || op == LogType::DELETEROW ||
+           op == LogType::UPDATEROW;
+  }
+};
+}  // namespace simpledb
@@ -0,0 +1,120 @@
+#include "txn/recovery/parallel_redo.h"
+
+#include <functional>
+#include <string_view>
+#include <utility>
+
+#include "txn/recovery/log_record_view.h"
+
+namespace simpledb {
+ParallelRedo::ParallelRedo(BufferManager& buffer_manager, int txn_id,
+                           int num_workers)
+    : buffer_manager_(buffer_manager), txn_id_(txn_id) {
+  workers_.reserve(num_workers);
+  for (int i = 0; i < num_workers; i++) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (auto& worker : workers_) {
+    worker->thread = std::thread{&ParallelRedo::Run, this, std::ref(*worker)};
+  }
+}
+
+ParallelRedo::~ParallelRedo() {
+  if (!finished_) {
+    try {
+      Finish();
+    } catch (...) {
+      // Only reached while unwinding from another error, which takes
+      // precedence
+    }
+  }
+}
+
+void ParallelRedo::Dispatch(std::span<const char> bytes, Lsn lsn) {
+  auto record = LogRecordView::Decode(bytes);
+  if (!record.IsUpdate()) {
+    return;
+  }
+  // The hash of the record's `BlockId`, without building one
+  auto hash = std::hash<std::string_view>{}(record.filename) ^
+              (std::hash<int>{}(record.block_num) << 1);
+  auto& worker = *workers_[hash % workers_.size()];
+  auto& pending = worker.pending;
+  pending.entries.push_back(Entry{lsn, pending.bytes.size(), bytes.size()});
+  pending.bytes.insert(pending.bytes.end(), bytes.begin(), bytes.end());
+  if (pending.entries.size() >= BATCH_SIZE) {
+    Submit(worker);
+  }
+}
+
+void ParallelRedo::Finish() {
+  finished_ = true;
+  for (auto& worker : workers_) {
+    Submit(*worker);
+    {
+      std::scoped_lock lock{worker->mutex};
+      worker->done = true;
+    }
+    worker->cv.notify_one();
+  }
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+}
+
+void ParallelRedo::Submit(Worker& worker) {
+  if (worker.pending.entries.empty()) {
+    return;
+  }
+  {
+    std::scoped_lock lock{worker.mutex};
+    worker.batches.push_back(std::move(worker.pending));
+    if (worker.spent.empty()) {
+      worker.pending = Batch{};
+    } else {
+      worker.pending = std::move(worker.spent.back());
+      worker.spent.pop_back();
+    }
+  }
+  worker.pending.bytes.clear();
+  worker.pending.entries.clear();
+  worker.cv.notify_one();
+}
+
+void ParallelRedo::Run(Worker& worker) {
+  while (true) {
+    Batch batch;
+    {
+      std::unique_lock lock{worker.mutex};
+      worker.cv.wait(lock, [&worker] {
+        return worker.done || !worker.batches.empty();
+      });
+      if (worker.batches.empty()) {
+        return;
+      }
+      batch = std::move(worker.batches.front());
+      worker.batches.pop_front();
+    }
+
+    std::span<const char> bytes{batch.bytes};
+    for (const auto& entry : batch.entries) {
+      try {
+        LogRecordView::Decode(bytes.subspan(entry.offset, entry.size))
+            .Redo(buffer_manager_, txn_id_, entry.lsn);
+      } catch (...) {
+        std::scoped_lock lock{error_mutex_};
+        if (!error_) {
+          error_ = std::current_exception();
+        }
+        return;
+      }
+    }
+
+    std::scoped_lock lock{worker.mutex};
+    worker.spent.push_back(std::move(batch));
+  }
+}
+}  // namespace simpledb
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <span>   // NOLINT(build/include_order)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "buffer/buffer_manager.h"
+#include "utils/data_type.h"
+
+namespace simpledb {
+/**
+ * Replays data-page log records on a pool of worker threads. The recovery
+ * manager reads the log sequentially and dispatches each update to the worker
+ * that owns its block, chosen by the hash of its `BlockId`. Every block is
+ * owned by exactly one worker, which applies the block's records in log order,
+ * so per-page order is preserved while different pages are replayed in
+ * parallel.
+ */
+class ParallelRedo {
+ public:
+  /**
+   * @brief Start the worker threads
+   * @param buffer_manager buffer manager of the database engine
+   * @param txn_id id of the recovering transaction
+   * @param num_workers number of worker threads
+   */
+  ParallelRedo(BufferManager& buffer_manager, int txn_id, int num_workers);
+
+  /**
+   * @brief Stop the worker threads, waiting for queued records to be replayed
+   */
+  ~ParallelRedo();
+
+  /**
+   * @brief Queue a log record for replay by the worker that owns its block.
+   * Records that do not update a block are ignored.
+   * @param bytes the bytes of the log record, which are copied into the
+   * worker's pending batch
+   * @param lsn the LSN of the log record
+   */
+  void Dispatch(std::span<const char> bytes, Lsn lsn);
+
+  /**
+   * @brief Wait until every dispatched record has been replayed
+   * @throw the first exception raised by a worker
+   */
+  void Finish();
+
+ private:
+  // A log record waiting to be replayed, located in its batch's bytes
+  struct Entry {
+    Lsn lsn;
+    size_t offset;
+    size_t size;
+  };
+
+  // Records queued together. Their bytes are packed into one buffer, and
+  // replayed batches are handed back to the dispatcher, so that a batch's
+  // buffers are allocated once and reused for the rest of the redo pass.
+  struct Batch {
+    std::vector<char> bytes;
+    std::vector<Entry> entries;
+  };
+
+  // A worker thread and the batches of records queued for it
+  struct Worker {
+    Batch pending;  // batch being filled by the dispatcher
+    std::deque<Batch> batches;
+    std::vector<Batch> spent;  // replayed batches, ready for reuse
+    bool done{};
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread thread;
+  };
+
+  /**
+   * @brief Hand the pending batch of a worker over to its thread
+   * @param worker the worker to hand the batch to
+   */
+  void Submit(Worker& worker);
+
+  /**
+   * @brief Body of a worker thread
+   * @param worker the worker whose batches to replay
+   */
+  void Run(Worker& worker);
+
+  // Records are handed to workers in batches to keep queue locking off the
+  // per-record path
+  static constexpr size_t BATCH_SIZE = 64;
+
+  BufferManager& buffer_manager_;
+  int txn_id_{};
+  std::vector<std::unique_ptr<Worker>> workers_;
+  bool finished_{};
+  std::mutex error_mutex_;
+  std::exception_ptr error_;
+};
+}  // namespace simpledb
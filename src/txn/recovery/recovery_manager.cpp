@@ -1,89 +1,381 @@
 #include "txn/recovery/recovery_manager.h"
 
+#include <algorithm>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <stdexcept>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "buffer/buffer_manager.h"
+#include "file/page.h"
 #include "log/log_manager.h"
+#include "txn/recovery/allocate_record.h"
 #include "txn/recovery/checkpoint_record.h"
 #include "txn/recovery/commit_record.h"
 #include "txn/recovery/log_record.h"
+#include "txn/recovery/load_table_record.h"
+#include "txn/recovery/log_record_view.h"
+#include "txn/recovery/parallel_redo.h"
 #include "txn/recovery/rollback_record.h"
+#include "txn/recovery/row_record.h"
 #include "txn/recovery/set_int_record.h"
 #include "txn/recovery/set_string_record.h"
-#include "txn/recovery/start_record.h"
 #include "txn/transaction.h"
 
 namespace simpledb {
+TransactionTable RecoveryManager::txn_table_{};
+std::atomic<int> RecoveryManager::redo_threads_{1};
+std::atomic<bool> RecoveryManager::on_demand_recovery_{false};
+
 RecoveryManager::RecoveryManager(Transaction& txn, int txn_id,
                                  LogManager& log_manager,
-                                 BufferManager& buffer_manager)
+                                 BufferManager& buffer_manager,
+                                 CommitPolicy commit_policy)
     : txn_(txn),
       txn_id_(txn_id),
       log_manager_(log_manager),
-      buffer_manager_(buffer_manager) {
-  StartRecord::WriteToLog(log_manager_, txn_id_);
+      buffer_manager_(buffer_manager),
+      commit_policy_(commit_policy) {}
+
+Lsn RecoveryManager::Commit() {
+  if (commit_policy_ == CommitPolicy::FORCE) {
+    buffer_manager_.FlushAll(txn_id_);
+  }
+  if (last_lsn_ == INVALID_LSN) {
+    return INVALID_LSN;
+  }
+  Lsn lsn = CommitRecord::WriteToLog(log_manager_, txn_id_, last_lsn_);
+  txn_table_.End(txn_id_);
+  return lsn;
 }
 
-void RecoveryManager::Commit() {
-  buffer_manager_.FlushAll(txn_id_);
-  int lsn = CommitRecord::WriteToLog(log_manager_, txn_id_);
-  log_manager_.Flush(lsn);
+void RecoveryManager::CompleteCommit(Lsn commit_lsn) {
+  if (commit_policy_ == CommitPolicy::ASYNC) {
+    log_manager_.FlushLater(commit_lsn);
+  } else {
+    log_manager_.Flush(commit_lsn);
+  }
+  MaybeCheckpoint();
 }
 
 void RecoveryManager::Rollback() {
+  if (last_lsn_ == INVALID_LSN) {
+    // Unlogged changes cannot be undone; they only fill new blocks
+    buffer_manager_.FlushAll(txn_id_);
+    return;
+  }
   DoRollback();
   buffer_manager_.FlushAll(txn_id_);
-  int lsn = RollbackRecord::WriteToLog(log_manager_, txn_id_);
+  Lsn lsn = RollbackRecord::WriteToLog(log_manager_, txn_id_, last_lsn_);
+  txn_table_.End(txn_id_);
   log_manager_.Flush(lsn);
+  MaybeCheckpoint();
 }
 
 void RecoveryManager::Recover() {
   DoRecover();
-  buffer_manager_.FlushAll(txn_id_);
-  int lsn = CheckpointRecord::WriteToLog(log_manager_);
-  log_manager_.Flush(lsn);
+  // Flushing the recovered pages keeps the next recovery short
+  buffer_manager_.FlushAll();
+  Checkpoint();
 }
 
-int RecoveryManager::SetInt(Buffer* buffer, int offset) {
+std::vector<BlockId> RecoveryManager::Analyze() {
+  losers_.clear();
+  Lsn redo_lsn = FindCheckpoint(log_manager_, losers_);
+
+  // Group the updates after the checkpoint's redo LSN by block, and remember
+  // which blocks each transaction touched
+  std::unordered_map<int, std::unordered_set<BlockId>> txn_blocks;
+  auto forward_iter = log_manager_.ForwardIterator(redo_lsn);
+  while (forward_iter.HasNext()) {
+    auto bytes = forward_iter.Next();
+    auto record = LogRecordView::Decode(bytes);
+    if (record.op == LogType::COMMIT || record.op == LogType::ROLLBACK) {
+      losers_.erase(record.txn_id);
+      txn_blocks.erase(record.txn_id);
+    } else if (record.op != LogType::CHECKPOINT) {
+      losers_[record.txn_id] = forward_iter.CurrentLsn();
+    }
+    if (record.IsUpdate() || record.op == LogType::ALLOCATE) {
+      BlockId block{record.filename, record.block_num};
+      txn_blocks[record.txn_id].insert(block);
+      if (record.IsUpdate()) {
+        auto [iter, inserted] = pending_redo_.try_emplace(block);
+        if (inserted) {
+          redo_blocks_.push_back(block);
+        }
+        iter->second.push_back(forward_iter.CurrentLsn());
+      }
+    }
+  }
+
+  std::vector<BlockId> loser_blocks;
+  for (const auto& [txn_id, last_lsn] : losers_) {
+    loser_blocks.insert(loser_blocks.end(), txn_blocks[txn_id].begin(),
+                        txn_blocks[txn_id].end());
+  }
+  // A checkpoint could truncate log records that pages still waiting to be
+  // redone need, and would miss the losers in its active transaction table
+  log_manager_.SuspendCheckpoints(true);
+  buffer_manager_.SetPageRecovery(
+      [this](Buffer& buffer) { RecoverPage(buffer); });
+
+  return loser_blocks;
+}
+
+void RecoveryManager::CompleteRecovery() {
+  // Reading a block redoes it if no transaction has read it yet
+  for (const auto& block : redo_blocks_) {
+    auto buffer = buffer_manager_.Pin(block);
+    if (buffer == nullptr) {
+      throw std::runtime_error("No available buffer!");
+    }
+    buffer_manager_.Unpin(buffer);
+  }
+  buffer_manager_.SetPageRecovery(nullptr);
+  redo_blocks_.clear();
+
+  for (const auto& [txn_id, last_lsn] : losers_) {
+    Lsn lsn = UndoChain(txn_id, last_lsn);
+    RollbackRecord::WriteToLog(log_manager_, txn_id, lsn);
+  }
+  losers_.clear();
+
+  buffer_manager_.FlushAll();
+  log_manager_.SuspendCheckpoints(false);
+  Checkpoint();
+}
+
+void RecoveryManager::Checkpoint() {
+  if (log_manager_.CheckpointsSuspended()) {
+    return;
+  }
+  // The active transactions are captured before the dirty pages. An update
+  // whose page is missing from the dirty page table either belongs to a
+  // transaction in the active transaction table or comes after the snapshot.
+  auto [snapshot_lsn, active_txns] = txn_table_.Snapshot(log_manager_);
+  auto dirty_pages = buffer_manager_.DirtyPageTable();
+  Lsn lsn = CheckpointRecord::WriteToLog(log_manager_, snapshot_lsn,
+                                         active_txns, dirty_pages);
+  log_manager_.Flush(lsn);
+  log_manager_.CheckpointWritten(lsn);
+  // Recovery never reads the log before the checkpoint's redo LSN
+  log_manager_.Truncate(
+      CheckpointRecord::RedoLsn(snapshot_lsn, active_txns, dirty_pages));
+}
+Lsn RecoveryManager::SetInt(Buffer* buffer, int offset, int new_val) {
+  Start();
   int old_val = buffer->Contents().GetInt(offset);
-  return SetIntRecord::WriteToLog(log_manager_, txn_id_,
-                                  buffer->Block().value(), offset, old_val);
+  last_lsn_ = SetIntRecord::WriteToLog(log_manager_, txn_id_, last_lsn_,
+                                       buffer->Block().value(), offset,
+                                       old_val, new_val);
+  return last_lsn_;
 }
 
-int RecoveryManager::SetString(Buffer* buffer, int offset) {
+Lsn RecoveryManager::SetString(Buffer* buffer, int offset,
+                               std::string_view new_val) {
+  Start();
   auto old_val = buffer->Contents().GetString(offset);
-  return SetStringRecord::WriteToLog(log_manager_, txn_id_,
-                                     buffer->Block().value(), offset, old_val);
+  last_lsn_ = SetStringRecord::WriteToLog(log_manager_, txn_id_, last_lsn_,
+                                          buffer->Block().value(), offset,
+                                          old_val, new_val);
+  return last_lsn_;
+}
+
+Lsn RecoveryManager::SetRow(Buffer* buffer, int offset,
+                            std::span<const char> new_image, RowOp row_op) {
+  Start();
+  BlockId block = buffer->Block().value();
+  auto contents = buffer->Contents().Contents();
+  if (row_op == RowOp::INSERT) {
+    // An insert is undone by clearing the in-use flag, so it needs no old
+    // image. If the slot is still too wide for one record, the bytes after
+    // the flag are logged as updates of the empty slot, and the flag last.
+    if (RowRecord::RecordSize(block, 0, new_image.size()) >
+        log_manager_.MaxRecordSize()) {
+      LogImage(block, contents, offset + sizeof(int),
+               new_image.subspan(sizeof(int)), RowOp::UPDATE);
+      new_image = new_image.first(sizeof(int));
+    }
+    last_lsn_ = RowRecord::WriteToLog(log_manager_, txn_id_, last_lsn_,
+                                      row_op, block, offset, {}, new_image);
+    return last_lsn_;
+  }
+  LogImage(block, contents, offset, new_image, row_op);
+  return last_lsn_;
+}
+
+void RecoveryManager::LogImage(const BlockId& block,
+                               std::span<const char> contents, int offset,
+                               std::span<const char> new_image,
+                               RowOp row_op) {
+  // Each piece holds its old and new bytes, and its record fits in a log block
+  int piece_size =
+      (log_manager_.MaxRecordSize() - RowRecord::RecordSize(block, 0, 0)) / 2;
+  for (int begin = 0; begin < static_cast<int>(new_image.size());
+       begin += piece_size) {
+    int size = std::min<int>(piece_size, new_image.size() - begin);
+    last_lsn_ = RowRecord::WriteToLog(
+        log_manager_, txn_id_, last_lsn_, row_op, block, offset + begin,
+        contents.subspan(offset + begin, size), new_image.subspan(begin, size));
+  }
+}
+
+Lsn RecoveryManager::Allocate(const BlockId& block) {
+  commit_policy_ = CommitPolicy::FORCE;
+  Start();
+  last_lsn_ = AllocateRecord::WriteToLog(log_manager_, txn_id_, last_lsn_,
+                                         block);
+  return last_lsn_;
+}
+
+Lsn RecoveryManager::LoadTable(std::string_view filename, int num_blocks,
+                               int num_rows) {
+  Start();
+  last_lsn_ = LoadTableRecord::WriteToLog(log_manager_, txn_id_, last_lsn_,
+                                          filename, num_blocks, num_rows);
+  return last_lsn_;
 }
 
 void RecoveryManager::DoRollback() {
-  auto iter = log_manager_.Iterator();
+  last_lsn_ = UndoChain(txn_id_, last_lsn_);
+}
+
+Lsn RecoveryManager::UndoChain(int txn_id, Lsn last_lsn) {
+  Lsn lsn = last_lsn;
+  std::vector<char> buffer;
+  while (lsn != INVALID_LSN) {
+    auto bytes = log_manager_.ReadAt(lsn, buffer);
+    auto record = LogRecordView::Decode(bytes);
+    if (record.op == LogType::COMPENSATION) {
+      // Everything between the CLR and its undo-next LSN is already undone
+      lsn = record.undo_next_lsn;
+    } else {
+      last_lsn = record.Undo(log_manager_, buffer_manager_, txn_id, last_lsn);
+      lsn = record.prev_lsn;
+    }
+  }
+
+  return last_lsn;
+}
+
+void RecoveryManager::MaybeCheckpoint() {
+  if (!log_manager_.ClaimCheckpoint()) {
+    return;
+  }
+  try {
+    Checkpoint();
+  } catch (...) {
+    log_manager_.ReleaseCheckpoint();
+    throw;
+  }
+  log_manager_.ReleaseCheckpoint();
+}
+
+int RecoveryManager::MaxTxnId(LogManager& log_manager) {
+  std::unordered_map<int, Lsn> active_txns;
+  Lsn redo_lsn = FindCheckpoint(log_manager, active_txns);
+  int max_txn_id = 0;
+  for (const auto& [txn_id, start_lsn] : active_txns) {
+    max_txn_id = std::max(max_txn_id, txn_id);
+  }
+  auto forward_iter = log_manager.ForwardIterator(redo_lsn);
+  while (forward_iter.HasNext()) {
+    auto bytes = forward_iter.Next();
+    max_txn_id = std::max(max_txn_id, LogRecordView::Decode(bytes).txn_id);
+  }
+
+  return max_txn_id;
+}
+
+Lsn RecoveryManager::FindCheckpoint(
+    LogManager& log_manager, std::unordered_map<int, Lsn>& unfinished_txns) {
+  // The transactions active at the checkpoint are unfinished unless the log
+  // after it says otherwise. The parts of a checkpoint are met last part
+  // first; a checkpoint whose last part is missing was cut short by a crash.
+  auto iter = log_manager.Iterator();
+  Lsn snapshot_lsn = INVALID_LSN;
+  Lsn redo_lsn = INVALID_LSN;
   while (iter.HasNext()) {
     auto bytes = iter.Next();
-    auto record = LogRecord::CreateLogRecord(bytes);
-    if (record->TxnId() == txn_id_) {
-      if (record->Op() == LogType::START) {
-        return;
+    if (LogRecordView::Decode(bytes).op != LogType::CHECKPOINT) {
+      continue;
+    }
+    CheckpointRecord checkpoint{Page{bytes.data(), bytes.size()}};
+    if (snapshot_lsn == INVALID_LSN) {
+      if (checkpoint.Part() != checkpoint.Parts() - 1) {
+        continue;
       }
-      record->Undo(txn_);
+      snapshot_lsn = checkpoint.SnapshotLsn();
+      redo_lsn = checkpoint.RedoLsn();
+    } else if (checkpoint.SnapshotLsn() != snapshot_lsn) {
+      continue;
+    }
+    redo_lsn = std::min(redo_lsn, checkpoint.RedoLsn());
+    for (const auto& [txn_id, start_lsn] : checkpoint.ActiveTxns()) {
+      unfinished_txns[txn_id] = start_lsn;
+    }
+    if (checkpoint.Part() == 0) {
+      break;
     }
   }
+
+  return redo_lsn;
+}
+
+void RecoveryManager::RecoverPage(Buffer& buffer) {
+  decltype(pending_redo_)::node_type node;
+  {
+    std::scoped_lock lock{redo_mutex_};
+    node = pending_redo_.extract(buffer.Block().value());
+  }
+  if (node.empty()) {
+    return;
+  }
+  std::vector<char> redo_buffer;
+  for (Lsn lsn : node.mapped()) {
+    auto bytes = log_manager_.ReadAt(lsn, redo_buffer);
+    LogRecordView::Decode(bytes).Redo(buffer, txn_id_, lsn);
+  }
 }
 
 void RecoveryManager::DoRecover() {
-  std::unordered_set<int> finished_txns_;
-  auto iter = log_manager_.Iterator();
-  while (iter.HasNext()) {
-    auto bytes = iter.Next();
-    auto record = LogRecord::CreateLogRecord(bytes);
-    if (record->Op() == LogType::CHECKPOINT) {
-      return;
+  // Analysis: find the last checkpoint
+  std::unordered_map<int, Lsn> unfinished_txns;
+  Lsn redo_lsn = FindCheckpoint(log_manager_, unfinished_txns);
+
+  // Redo: repeat history for every update that did not reach the disk, and
+  // track which transactions finish and the last LSN of the others
+  std::unique_ptr<ParallelRedo> parallel_redo;
+  if (redo_threads_ > 1) {
+    parallel_redo = std::make_unique<ParallelRedo>(buffer_manager_, txn_id_,
+                                                   redo_threads_);
+  }
+  auto forward_iter = log_manager_.ForwardIterator(redo_lsn);
+  while (forward_iter.HasNext()) {
+    auto bytes = forward_iter.Next();
+    auto record = LogRecordView::Decode(bytes);
+    if (record.op == LogType::COMMIT || record.op == LogType::ROLLBACK) {
+      unfinished_txns.erase(record.txn_id);
+    } else if (record.op != LogType::CHECKPOINT) {
+      unfinished_txns[record.txn_id] = forward_iter.CurrentLsn();
     }
-    if (record->Op() == LogType::COMMIT || record->Op() == LogType::ROLLBACK) {
-      finished_txns_.insert(record->TxnId());
-    } else if (!finished_txns_.contains(record->TxnId())) {
-      record->Undo(txn_);
+    if (parallel_redo != nullptr) {
+      parallel_redo->Dispatch(bytes, forward_iter.CurrentLsn());
+    } else {
+      record.Redo(buffer_manager_, txn_id_, forward_iter.CurrentLsn());
     }
   }
+  if (parallel_redo != nullptr) {
+    parallel_redo->Finish();
+  }
+
+  // Undo: roll back each unfinished transaction along its prevLSN chain
+  for (const auto& [txn_id, last_lsn] : unfinished_txns) {
+    Lsn lsn = UndoChain(txn_id, last_lsn);
+    RollbackRecord::WriteToLog(log_manager_, txn_id, lsn);
+  }
 }
 }  // namespace simpledb
@@ -1,14 +1,45 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <mutex>  // NOLINT(build/c++11)
+#include <span>  // NOLINT(build/include_order)
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
 #include "buffer/buffer.h"
 #include "buffer/buffer_manager.h"
+#include "file/block_id.h"
 #include "log/log_manager.h"
+#include "txn/recovery/transaction_table.h"
 // #include "txn/transaction.h"
 
 namespace simpledb {
 // Forward declaration to avoid cyclic dependency between `RecoveryManger` and
 // `Transaction`
 class Transaction;
+
+/**
+ * When a transaction's modified data pages are written to disk.
+ * - FORCE: commit flushes every page the transaction modified before writing
+ *   the COMMIT record.
+ * - NO_FORCE: commit only makes the log durable. Modified pages are written
+ *   back lazily when their buffers are replaced, and recovery redoes the
+ *   updates that did not reach the disk.
+ * - ASYNC: like NO_FORCE, but commit does not wait for the log either. It
+ *   returns once the COMMIT record is in the log buffer, and the log manager
+ *   writes it to disk within its flush interval (see
+ *   `LogManager::SetFlushInterval`). A crash may lose the transactions that
+ *   committed during the last interval, but never leaves one half done.
+ */
+enum class CommitPolicy { FORCE, NO_FORCE, ASYNC };
+
+/**
+ * The row operation described by a row log record
+ */
+enum class RowOp { INSERT, DELETE, UPDATE };
+
 /**
  * The recovery manager. Each transaction has its own recovery manager.
  */
@@ -20,65 +51,286 @@ class RecoveryManager {
    * @param txn_id id of the specified transaction
    * @param log_manager log manager of the database engine
    * @param buffer_manager buffer manager of the database engine
+   * @param commit_policy whether commit forces the modified data pages
    */
   RecoveryManager(Transaction& txn, int txn_id, LogManager& log_manager,
-                  BufferManager& buffer_manager);
+                  BufferManager& buffer_manager,
+                  CommitPolicy commit_policy = CommitPolicy::FORCE);
+
+  /**
+   * @brief Write the COMMIT record of the transaction to the log buffer.
+   * Under the FORCE policy, the modified data pages are flushed first. The
+   * transaction may release its locks as soon as the record is in the buffer:
+   * a transaction that sees its changes either writes a later COMMIT record,
+   * whose flush covers this one, or waits for it with `WaitForLog`. A
+   * transaction that has logged nothing has no START record, and writes no
+   * COMMIT record either.
+   * @return the LSN of the COMMIT record, or `INVALID_LSN` if nothing was
+   * logged
+   */
+  Lsn Commit();
+
+  /**
+   * @brief Finish the commit: flush the log up to the COMMIT record, or leave
+   * it to the background flusher under the ASYNC policy. If the log has grown
+   * by the checkpoint interval since the last checkpoint, a new checkpoint is
+   * written.
+   * @param commit_lsn the LSN returned by `Commit`, other than `INVALID_LSN`
+   */
+  void CompleteCommit(Lsn commit_lsn);
 
   /**
-   * @brief Commit the transaction, write a COMMIT record to the log, and flush
-   * it to disk
+   * @brief Wait until the log is on disk up to the specified LSN, such as the
+   * COMMIT record of a transaction whose changes a read-only transaction saw
+   * before they were durable
+   * @param lsn the LSN of a log record, or `INVALID_LSN` to return at once
    */
-  void Commit();
+  void WaitForLog(Lsn lsn) {
+    if (lsn != INVALID_LSN) {
+      log_manager_.Flush(lsn);
+    }
+  }
 
   /**
    * @brief Rollback the transaction, write a ROLLBACK record to the log and
-   * flush it to disk
+   * flush it to disk. There is nothing to undo or log for a transaction that
+   * has logged nothing.
    */
   void Rollback();
 
   /**
-   * @brief Recover uncompleted transactions from the log and then write a
-   * quiescent checkpoint record to the log and flush it
+   * @brief Recover uncompleted transactions from the log, flush the recovered
+   * pages, and then write a checkpoint
    */
   void Recover();
 
+  /**
+   * @brief Start an on-demand restart: analyze the log and return without
+   * redoing or undoing anything. The redo records are grouped by block, and a
+   * block is redone when it is first read into the buffer pool, so the
+   * database can serve transactions right away. `CompleteRecovery` finishes
+   * the work later. Until then no checkpoint is written.
+   * @return the blocks updated by unfinished transactions, which must stay
+   * locked until their updates are undone
+   */
+  std::vector<BlockId> Analyze();
+
+  /**
+   * @brief Finish an on-demand restart started by `Analyze`: redo the blocks
+   * that have not been read yet, roll back the unfinished transactions, flush
+   * the recovered pages, and then write a checkpoint
+   */
+  void CompleteRecovery();
+
+  /**
+   * @brief Write a fuzzy checkpoint holding the active transaction table and
+   * the dirty page table, split over several records if it does not fit in a
+   * log block, and flush it. Transactions keep running meanwhile. Log
+   * segments before the checkpoint's redo LSN are deleted.
+   */
+  void Checkpoint();
+
+  /**
+   * @brief Return whether an on-demand restart of the database is still in
+   * progress, i.e., whether some blocks may still hold the changes of
+   * unfinished transactions. Checkpoints are suspended for exactly that
+   * long.
+   * @return true if the restart has not completed; otherwise, false
+   */
+  bool Restarting() const noexcept {
+    return log_manager_.CheckpointsSuspended();
+  }
+
+  /**
+   * @brief Set how many worker threads replay data pages during the redo pass
+   * of recovery. With more than one, the log is still read sequentially, but
+   * its updates are replayed in parallel, partitioned by block. Each worker
+   * pins one buffer at a time, so there should be no more workers than
+   * buffers.
+   * @param num_threads number of redo threads; 1 replays on the recovering
+   * thread
+   */
+  static void SetRedoThreads(int num_threads) noexcept {
+    redo_threads_ = num_threads;
+  }
+
+  /**
+   * @brief Choose whether a restarting database recovers on demand: it
+   * accepts transactions once the log is analyzed, redoes pages when they
+   * are first read, and completes recovery in the background
+   * @param on_demand true to recover on demand, false to finish recovery
+   * before accepting transactions
+   */
+  static void SetOnDemandRecovery(bool on_demand) noexcept {
+    on_demand_recovery_ = on_demand;
+  }
+
+  /**
+   * @brief Return whether a restarting database recovers on demand
+   * @return true if recovery completes in the background
+   */
+  static bool OnDemandRecovery() noexcept { return on_demand_recovery_; }
+
+  /**
+   * @brief Return the largest transaction id in the part of the log that
+   * recovery reads. The recovering transaction, and those started during an
+   * on-demand restart, must get larger ids, so that they are never mistaken
+   * for an unfinished transaction of the previous run (see
+   * `Transaction::ReserveTxnIds`).
+   * @param log_manager log manager of the database engine
+   * @return the largest transaction id, or 0 if there is none
+   */
+  static int MaxTxnId(LogManager& log_manager);
+
   /**
    * @brief Write a SETINT record to the log to record the old value at the
-   * specified offset before being overwritten by a new value
+   * specified offset before being overwritten by a new value, along with the
+   * new value for redo
    * @param buffer the buffer containing the page
    * @param offset offset of the value in the page
+   * @param new_val the value about to be written
    * @return LSN of the SETINT record
    */
-  int SetInt(Buffer* buffer, int offset);
+  Lsn SetInt(Buffer* buffer, int offset, int new_val);
 
   /**
    * @brief Write a SETSTRING record to the log to record the old value at the
-   * specified offset before being overwritten by a new value
+   * specified offset before being overwritten by a new value, along with the
+   * new value for redo
    * @param buffer the buffer containing the page
    * @param offset offset of the value in the page
+   * @param new_val the value about to be written
    * @return LSN of the SETSTRING record
    */
-  int SetString(Buffer* buffer, int offset);
+  Lsn SetString(Buffer* buffer, int offset, std::string_view new_val);
+
+  /**
+   * @brief Write a row record to the log to record the bytes at the specified
+   * offset before being overwritten by a new image, along with the new image.
+   * The record of an INSERT holds only the new image. An image whose record
+   * would not fit in a log block is split over several row records.
+   * @param buffer the buffer containing the page
+   * @param offset offset of the image in the page
+   * @param new_image the bytes about to be written
+   * @param row_op the row operation
+   * @return LSN of the last row record
+   */
+  Lsn SetRow(Buffer* buffer, int offset, std::span<const char> new_image,
+             RowOp row_op);
+
+  /**
+   * @brief Write an ALLOCATE record to the log for a block that the
+   * transaction appended and will fill without logging. Because its contents
+   * cannot be redone, the transaction then commits with the FORCE policy.
+   * @param block a reference to the appended disk block
+   * @return LSN of the ALLOCATE record
+   */
+  Lsn Allocate(const BlockId& block);
+
+  /**
+   * @brief Write a LOADTABLE record to the log to mark the end of a bulk load
+   * @param filename name of the loaded file
+   * @param num_blocks number of blocks appended by the load
+   * @param num_rows number of rows written by the load
+   * @return LSN of the LOADTABLE record
+   */
+  Lsn LoadTable(std::string_view filename, int num_blocks, int num_rows);
 
  private:
   /**
-   * @brief Rollback the transaction by iterating through the log records until
-   * it finds the transaction's START record, calling `Undo()` for each of the
-   * transaction's log records.
+   * @brief Write the START record of the transaction, unless it has one
+   * already. The record is deferred until the transaction logs its first
+   * change, so that transactions that change nothing never touch the log.
+   */
+  void Start() {
+    if (last_lsn_ == INVALID_LSN) {
+      last_lsn_ = txn_table_.Begin(log_manager_, txn_id_);
+    }
+  }
+
+  /**
+   * @brief Write row records for an image, splitting it into pieces small
+   * enough for each record to fit in a log block
+   * @param block a reference to the disk block
+   * @param contents the contents of the page before the change
+   * @param offset offset of the image in the page
+   * @param new_image the bytes about to be written
+   * @param row_op the row operation of the records
+   */
+  void LogImage(const BlockId& block, std::span<const char> contents,
+                int offset, std::span<const char> new_image, RowOp row_op);
+
+  /**
+   * @brief Rollback the transaction by following its prevLSN chain from its
+   * latest log record back to its START record
    */
   void DoRollback();
 
   /**
-   * @brief Do a complete database recovery. The method iterates through the log
-   * records. Whenever it finds a log record for an unfinished transaction, it
-   * calls `Undo()` on that record. The method stops when it encounters a
-   * CHECKPOINT record or the end of the log.
+   * @brief Undo the updates of a transaction by following its prevLSN chain,
+   * writing a compensation log record for each undone update. Compensation
+   * log records already in the chain are skipped to their undo-next LSN, so no
+   * update is undone twice.
+   * @param txn_id id of the transaction to undo
+   * @param last_lsn LSN of the transaction's latest log record
+   * @return LSN of the transaction's latest log record after the undo
+   */
+  Lsn UndoChain(int txn_id, Lsn last_lsn);
+
+  /**
+   * @brief Write a checkpoint if the log has grown by the checkpoint interval
+   * (see `LogManager::SetCheckpointInterval`) since the last one. Only one of
+   * the transactions that notice it does so, and a checkpoint that is skipped
+   * is tried again at the next commit.
+   */
+  void MaybeCheckpoint();
+
+  /**
+   * @brief Read the log backward to the last checkpoint
+   * @param log_manager log manager of the database engine
+   * @param unfinished_txns filled with the transactions active at the
+   * checkpoint, mapped to their START LSNs
+   * @return the LSN where the redo pass starts
+   */
+  static Lsn FindCheckpoint(LogManager& log_manager,
+                            std::unordered_map<int, Lsn>& unfinished_txns);
+
+  /**
+   * @brief Redo a block that an on-demand restart has not recovered yet. This
+   * runs when the block is read into a buffer, on the thread that pins it, so
+   * several blocks may be recovered at once.
+   * @param buffer the buffer that holds the block
+   */
+  void RecoverPage(Buffer& buffer);
+
+  /**
+   * @brief Do a complete database recovery. The log is read backward to find
+   * the last checkpoint, whose active transaction table seeds the unfinished
+   * transactions. The redo pass reads the log forward from the checkpoint's
+   * redo LSN, finishes the analysis by tracking which transactions start and
+   * end, and reapplies every update whose LSN is newer than the page LSN of
+   * its block, repeating history. The undo pass rolls back each unfinished
+   * transaction along its prevLSN chain and writes its ROLLBACK record.
    */
   void DoRecover();
 
+  // The global active transaction table. This variable is static because all
+  // transactions share it.
+  static TransactionTable txn_table_;
+  static std::atomic<int> redo_threads_;
+  static std::atomic<bool> on_demand_recovery_;
+
   Transaction& txn_;
   int txn_id_{};
   LogManager& log_manager_;
   BufferManager& buffer_manager_;
+  CommitPolicy commit_policy_;
+  Lsn last_lsn_{INVALID_LSN};  // LSN of this transaction's latest log record
+  // State of an on-demand restart, from its analysis until it completes
+  std::unordered_map<BlockId, std::vector<Lsn>> pending_redo_;
+  std::vector<BlockId> redo_blocks_;
+  std::unordered_map<int, Lsn> losers_;
+  // Protects `pending_redo_` from the threads that recover pages on demand
+  std::mutex redo_mutex_;
 };
 }  // namespace simpledb
@@ -0,0 +1,110 @@
+#include "txn/recovery/row_record.h"
+
+#include <memory>
+#include <sstream>
+
+#include "file/block_id.h"
+#include "file/page.h"
+#include "log/log_manager.h"
+
+namespace simpledb {
+RowRecord::RowRecord(const Page& page) {
+  int txn_pos = sizeof(int);
+  int prev_lsn_pos = txn_pos + sizeof(int);
+  int file_pos = prev_lsn_pos + sizeof(Lsn);
+  int block_pos = file_pos + Page::StringLength(page.GetString(file_pos));
+  int offset_pos = block_pos + sizeof(int);
+  int old_image_pos = offset_pos + sizeof(int);
+  auto old_image = page.GetBytes(old_image_pos);
+  int new_image_pos = old_image_pos + sizeof(int) + old_image.size();
+  auto new_image = page.GetBytes(new_image_pos);
+
+  op_ = static_cast<LogType>(page.GetInt(0));
+  txn_id_ = page.GetInt(txn_pos);
+  prev_lsn_ = page.GetLong(prev_lsn_pos);
+  block_ = BlockId{page.GetString(file_pos), page.GetInt(block_pos)};
+  offset_ = page.GetInt(offset_pos);
+  old_image_.assign(old_image.begin(), old_image.end());
+  new_image_.assign(new_image.begin(), new_image.end());
+}
+
+void RowRecord::Undo(Transaction& txn) {
+  txn.Pin(block_);
+  if (op_ == LogType::INSERTROW) {
+    // The empty flag is zero
+    txn.SetInt(block_, offset_, 0, false);
+  } else {
+    txn.SetRow(block_, offset_, old_image_, RowOp::UPDATE, false);
+  }
+  txn.Unpin(block_);
+}
+
+std::string RowRecord::ToString() const {
+  std::stringstream output;
+  switch (op_) {
+    case LogType::INSERTROW:
+      output << "<INSERTROW ";
+      break;
+    case LogType::DELETEROW:
+      output << "<DELETEROW ";
+      break;
+    default:
+      output << "<UPDATEROW ";
+      break;
+  }
+  output << txn_id_ << ' ' << prev_lsn_ << ' ' << block_.ToString() << ' '
+         << offset_ << ' ' << old_image_.size() << ' ' << new_image_.size()
+         << '>';
+
+  return output.str();
+}
+
+LogType RowRecord::TypeOf(RowOp row_op) noexcept {
+  switch (row_op) {
+    case RowOp::INSERT:
+      return LogType::INSERTROW;
+    case RowOp::DELETE:
+      return LogType::DELETEROW;
+    default:
+      return LogType::UPDATEROW;
+  }
+}
+
+int RowRecord::RecordSize(const BlockId& block, int old_size,
+                          int new_size) {
+  // The type, transaction id, previous LSN, filename, block number, offset,
+  // and the two length-prefixed images
+  return 2 * sizeof(int) + sizeof(Lsn) + Page::StringLength(block.Filename()) +
+         2 * sizeof(int) + sizeof(int) + old_size + sizeof(int) + new_size;
+}
+
+Lsn RowRecord::WriteToLog(LogManager& log_manager, int txn_id, Lsn prev_lsn,
+                          RowOp row_op, const BlockId& block, int offset,
+                          std::span<const char> old_image,
+                          std::span<const char> new_image) {
+  int txn_pos = sizeof(int);
+  int prev_lsn_pos = txn_pos + sizeof(int);
+  int file_pos = prev_lsn_pos + sizeof(Lsn);
+  int block_pos = file_pos + Page::StringLength(block.Filename());
+  int offset_pos = block_pos + sizeof(int);
+  int old_image_pos = offset_pos + sizeof(int);
+  int new_image_pos = old_image_pos + sizeof(int) + old_image.size();
+
+  size_t record_size = RecordSize(block, old_image.size(), new_image.size());
+  auto record = std::make_unique<char[]>(record_size);
+  Page page{record.get(), record_size};
+  page.SetInt(0, static_cast<int>(TypeOf(row_op)));
+  page.SetInt(txn_pos, txn_id);
+  page.SetLong(prev_lsn_pos, prev_lsn);
+  page.SetString(file_pos, block.Filename());
+  page.SetInt(block_pos, block.BlockNumber());
+  page.SetInt(offset_pos, offset);
+  // `SetBytes` does not modify the bytes, so casting away const is safe
+  page.SetBytes(old_image_pos, std::span{const_cast<char*>(old_image.data()),
+                                         old_image.size()});
+  page.SetBytes(new_image_pos, std::span{const_cast<char*>(new_image.data()),
+                                         new_image.size()});
+
+  return log_manager.Append(std::span{record.get(), record_size});
+}
+}  // namespace simpledb
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <span>  // NOLINT(build/include_order)
+#include <string>
+#include <vector>
+
+#include "file/block_id.h"
+#include "file/page.h"
+#include "log/log_manager.h"
+#include "txn/recovery/log_record.h"
+#include "txn/recovery/recovery_manager.h"
+#include "txn/transaction.h"
+
+namespace simpledb {
+/**
+ * The INSERTROW, DELETEROW, and UPDATEROW log records. A row record describes
+ * one row operation on a record page with a single log record: it holds the
+ * byte images of the affected part of the slot before and after the operation,
+ * instead of one SETINT or SETSTRING record per field. An INSERTROW record
+ * holds only the new image, since an insert is undone by clearing the in-use
+ * flag at the start of the slot.
+ */
+class RowRecord : public LogRecord {
+ public:
+  /**
+   * @brief Construct a new row log record that uses the given `page` as the
+   * underlying storage
+   * @param page the page containing the log values
+   */
+  explicit RowRecord(const Page& page);
+
+  /**
+   * @brief Return the log record's type
+   * @return the log record's type
+   */
+  LogType Op() const noexcept override { return op_; }
+
+  /**
+   * @brief Return the transaction id stored with the log record
+   * @return the log record's transaction id
+   */
+  int TxnId() const noexcept override { return txn_id_; }
+
+  /**
+   * @brief Restore the old image saved in the log record, or clear the in-use
+   * flag of the slot if the record is an INSERTROW record
+   * @param txn the transaction to undo
+   */
+  void Undo(Transaction& txn) override;
+
+  /**
+   * @brief Return the string representation of this row log record
+   * @return the string representation of this record
+   */
+  std::string ToString() const;
+
+  /**
+   * @brief Return the log record type that describes a row operation
+   * @param row_op the row operation
+   * @return the matching log record type
+   */
+  static LogType TypeOf(RowOp row_op) noexcept;
+
+  /**
+   * @brief Return the size of a row record
+   * @param block a reference to the disk block
+   * @param old_size size of the old image in bytes
+   * @param new_size size of the new image in bytes
+   * @return the number of bytes that the row record occupies in the log
+   */
+  static int RecordSize(const BlockId& block, int old_size, int new_size);
+
+  /**
+   * @brief Write a row record to the log. This log record contains the row
+   * operator, followed by the transaction id, the LSN of the transaction's
+   * previous log record, filename, block number, offset within the block, the
+   * old image, and the new image.
+   * @param log_manager log manager of the database engine
+   * @param txn_id transaction id
+   * @param prev_lsn LSN of the transaction's previous log record
+   * @param row_op the row operation
+   * @param block a reference to the disk block
+   * @param offset offset of the image in the block
+   * @param old_image bytes at the offset before the operation; empty for an
+   * INSERT
+   * @param new_image bytes at the offset after the operation
+   * @return LSN of the last log value
+   */
+  static Lsn WriteToLog(LogManager& log_manager, int txn_id, Lsn prev_lsn,
+                        RowOp row_op, const BlockId& block, int offset,
+                        std::span<const char> old_image,
+                        std::span<const char> new_image);
+
+ private:
+  LogType op_{};
+  int txn_id_{};
+  Lsn prev_lsn_{INVALID_LSN};
+  BlockId block_;
+  int offset_{};
+  std::vector<char> old_image_;
+  std::vector<char> new_image_;
+};
+}  // namespace simpledb
@@ -9,21 +9,25 @@
 namespace simpledb {
 SetIntRecord::SetIntRecord(const Page& page) {
   int txn_pos = sizeof(int);
-  int file_pos = txn_pos + sizeof(int);
+  int prev_lsn_pos = txn_pos + sizeof(int);
+  int file_pos = prev_lsn_pos + sizeof(Lsn);
   int block_pos = file_pos + Page::StringLength(page.GetString(file_pos));
   int offset_pos = block_pos + sizeof(int);
   int val_pos = offset_pos + sizeof(int);
+  int new_val_pos = val_pos + sizeof(int);
 
   txn_id_ = page.GetInt(txn_pos);
+  prev_lsn_ = page.GetLong(prev_lsn_pos);
   block_ = BlockId{page.GetString(file_pos), page.GetInt(block_pos)};
   offset_ = page.GetInt(offset_pos);
   val_ = page.GetInt(val_pos);
+  new_val_ = page.GetInt(new_val_pos);
 }
 
 std::string SetIntRecord::ToString() const {
   std::stringstream output;
-  output << "<SETINT> " << txn_id_ << ' ' << block_.ToString() << ' ' << offset_
-         << ' ' << val_ << '>';
+  output << "<SETINT> " << txn_id_ << ' ' << prev_lsn_ << ' ' << block_.ToString() << ' ' << offset_
+         << ' ' << val_ << ' ' << new_val_ << '>';
 
   return output.str();
 }
@@ -34,23 +38,28 @@ void SetIntRecord::Undo(Transaction& txn) {
   txn.Unpin(block_);
 }
 
-int SetIntRecord::WriteToLog(LogManager& log_manager, int txn_id,
-                             const BlockId& block, int offset, int val) {
+Lsn SetIntRecord::WriteToLog(LogManager& log_manager, int txn_id,
+                             Lsn prev_lsn, const BlockId& block, int offset,
+                             int val, int new_val) {
   int txn_pos = sizeof(int);
-  int file_pos = txn_pos + sizeof(int);
+  int prev_lsn_pos = txn_pos + sizeof(int);
+  int file_pos = prev_lsn_pos + sizeof(Lsn);
   int block_pos = file_pos + Page::StringLength(block.Filename());
   int offset_pos = block_pos + sizeof(int);
   int val_pos = offset_pos + sizeof(int);
+  int new_val_pos = val_pos + sizeof(int);
 
-  size_t record_size = val_pos + sizeof(int);
+  size_t record_size = new_val_pos + sizeof(int);
   auto record = std::make_unique<char[]>(record_size);
   Page page{record.get(), record_size};
   page.SetInt(0, static_cast<int>(LogType::SETINT));
   page.SetInt(txn_pos, txn_id);
+  page.SetLong(prev_lsn_pos, prev_lsn);
   page.SetString(file_pos, block.Filename());
   page.SetInt(block_pos, block.BlockNumber());
   page.SetInt(offset_pos, offset);
   page.SetInt(val_pos, val);
+  page.SetInt(new_val_pos, new_val);
 
   return log_manager.Append(std::span{record.get(), record_size});
 }
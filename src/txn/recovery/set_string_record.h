@@ -46,22 +46,29 @@ class SetStringRecord : public LogRecord {
 
   /**
    * @brief Write this SETSTRING record to the log. This log record contains the
-   * SETSTRING operator, followed by the transaction id, filename, block number,
-   * offset within the block, and the previous string value at that offset.
+   * SETSTRING operator, followed by the transaction id, the LSN of the
+   * transaction's previous log record, filename, block number,
+   * offset within the block, the previous string value at that offset, and the
+   * new string value.
    * @param log_manager log manager of the database engine
    * @param txn_id transaction id
+   * @param prev_lsn LSN of the transaction's previous log record
    * @param block a reference to the disk block
    * @param offset offset in the block
    * @param val old value at the specified offset
+   * @param new_val new value at the specified offset
    * @return LSN of the last log value
    */
-  static int WriteToLog(LogManager& log_manager, int txn_id,
-                        const BlockId& block, int offset, std::string_view val);
+  static Lsn WriteToLog(LogManager& log_manager, int txn_id, Lsn prev_lsn,
+                        const BlockId& block, int offset, std::string_view val,
+                        std::string_view new_val);
 
  private:
   int txn_id_{};
+  Lsn prev_lsn_{INVALID_LSN};
   BlockId block_;
   int offset_{};
   std::string val_;
+  std::string new_val_;
 };
 }  // namespace simpledb
@@ -12,7 +12,7 @@ StartRecord::StartRecord(const Page& page) {
   txn_id_ = page.GetInt(txn_pos);
 }
 
-int StartRecord::WriteToLog(LogManager& log_manager, int txn_id) {
+Lsn StartRecord::WriteToLog(LogManager& log_manager, int txn_id) {
   size_t record_size = 2 * sizeof(int);
   auto record = std::make_unique<char[]>(record_size);
   Page page{record.get(), record_size};
@@ -49,7 +49,7 @@ class StartRecord : public LogRecord {
    * operator, followed by the transaction id.
    * @return LSN of the last log value
    */
-  static int WriteToLog(LogManager& log_manager, int txn_id);
+  static Lsn WriteToLog(LogManager& log_manager, int txn_id);
 
  private:
   int txn_id_{};
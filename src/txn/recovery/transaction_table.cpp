@@ -0,0 +1,30 @@
+#include "txn/recovery/transaction_table.h"
+
+#include "txn/recovery/start_record.h"
+
+namespace simpledb {
+Lsn TransactionTable::Begin(LogManager& log_manager, int txn_id) {
+  std::scoped_lock lock{mutex_};
+  Lsn lsn = StartRecord::WriteToLog(log_manager, txn_id);
+  active_txns_[txn_id] = Entry{&log_manager, lsn};
+
+  return lsn;
+}
+
+void TransactionTable::End(int txn_id) {
+  std::scoped_lock lock{mutex_};
+  active_txns_.erase(txn_id);
+}
+
+std::pair<Lsn, std::vector<std::pair<int, Lsn>>> TransactionTable::Snapshot(
+    LogManager& log_manager) const {
+  std::scoped_lock lock{mutex_};
+  std::vector<std::pair<int, Lsn>> active_txns;
+  for (const auto& [txn_id, entry] : active_txns_) {
+    if (entry.log_manager == &log_manager) {
+      active_txns.emplace_back(txn_id, entry.start_lsn);
+    }
+  }
+  return {log_manager.LatestLsn(), std::move(active_txns)};
+}
+}  // namespace simpledb
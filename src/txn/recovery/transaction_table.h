@@ -0,0 +1,57 @@
+#pragma once
+
+#include <map>
+#include <mutex>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "log/log_manager.h"
+#include "utils/data_type.h"
+
+namespace simpledb {
+/**
+ * The active transaction table: the transactions that have written a START
+ * record but no COMMIT or ROLLBACK record yet, along with the LSN of their
+ * START record. Fuzzy checkpoints save a snapshot of the table, so recovery
+ * learns which transactions were running without reading the log before the
+ * checkpoint. The table is shared by every database that the process opens,
+ * so each entry also records the log that its START record went to.
+ */
+class TransactionTable {
+ public:
+  /**
+   * @brief Write a START record for the specified transaction and add the
+   * transaction to the table. Both happen under the table's lock, so a
+   * transaction missing from a snapshot starts after the snapshot's LSN.
+   * @param log_manager log manager of the database engine
+   * @param txn_id id of the starting transaction
+   * @return LSN of the START record
+   */
+  Lsn Begin(LogManager& log_manager, int txn_id);
+
+  /**
+   * @brief Remove a committed or rolled back transaction from the table
+   * @param txn_id id of the finished transaction
+   */
+  void End(int txn_id);
+
+  /**
+   * @brief Take a consistent snapshot of the table, covering the transactions
+   * that write to the specified log
+   * @param log_manager log manager of the database engine
+   * @return the latest LSN at the time of the snapshot, and the active
+   * transactions with the LSNs of their START records
+   */
+  std::pair<Lsn, std::vector<std::pair<int, Lsn>>> Snapshot(
+      LogManager& log_manager) const;
+
+ private:
+  struct Entry {
+    const LogManager* log_manager;
+    Lsn start_lsn;
+  };
+
+  mutable std::mutex mutex_;
+  std::map<int, Entry> active_txns_;
+};
+}  // namespace simpledb
@@ -1,93 +1,340 @@
 #include "txn/transaction.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <mutex>  // NOLINT(build/c++11)
+#include <shared_mutex>
+#include <string>
 
 #include "buffer/buffer.h"
 #include "file/block_id.h"
 
 namespace simpledb {
 int Transaction::next_txn_id_ = 0;
+VersionStore Transaction::version_store_{};
 
 void Transaction::Commit() {
-  recovery_manager_.Commit();
+  // The claimed items stay claimed while the commit record is written
+  if (mode_ == TxnMode::OPTIMISTIC && !optimistic_manager_.Validate()) {
+    throw LockAbortException();
+  }
+  if (read_only_) {
+    EndReadOnly();
+    return;
+  }
+  Lsn commit_lsn = recovery_manager_.Commit();
+  version_store_.Commit(txn_id_, commit_lsn);
+  if (commit_lsn == INVALID_LSN) {
+    // Nothing was logged, so there is no COMMIT record to flush; as in a
+    // read-only transaction, only what it saw must be durable
+    Lsn dependency_lsn = concurrency_manager_.DependencyLsn();
+    ReleaseLocks();
+    recovery_manager_.WaitForLog(dependency_lsn);
+  } else if (mode_ == TxnMode::OPTIMISTIC) {
+    // The version table does not track who read what, so optimistic
+    // transactions keep their items claimed until the commit is durable
+    recovery_manager_.CompleteCommit(commit_lsn);
+    ReleaseLocks();
+  } else {
+    concurrency_manager_.Release(commit_lsn);
+    recovery_manager_.CompleteCommit(commit_lsn);
+  }
   std::cout << "Transaction " << txn_id_ << " committed\n";
-  concurrency_manager_.Release();
   my_buffers_.UnpinAll();
 }
 
 void Transaction::Rollback() {
+  if (read_only_) {
+    EndReadOnly();
+    return;
+  }
   recovery_manager_.Rollback();
+  // The versions are dropped only once the pages are restored
+  version_store_.Rollback(txn_id_);
   std::cout << "Transaction " << txn_id_ << " rolled back\n";
-  concurrency_manager_.Release();
+  ReleaseLocks();
   my_buffers_.UnpinAll();
 }
 
+void Transaction::Pin(const BlockId& block) {
+  if (mode_ == TxnMode::SNAPSHOT && recovery_manager_.Restarting()) {
+    concurrency_manager_.AwaitExclusiveLock(block);
+  }
+  my_buffers_.Pin(block);
+}
+
 void Transaction::Recover() {
   buffer_manager_.FlushAll(txn_id_);
   recovery_manager_.Recover();
 }
 
-int Transaction::GetInt(const BlockId& block, int offset) {
-  concurrency_manager_.SharedLock(block);
+void Transaction::RecoverOnDemand() {
+  buffer_manager_.FlushAll(txn_id_);
+  for (const auto& block : recovery_manager_.Analyze()) {
+    concurrency_manager_.ExclusiveLock(block);
+  }
+}
+
+PageHandle Transaction::GetHandle(const BlockId& block) const {
+  auto buffer = my_buffers_.GetBuffer(block);
+  if (buffer == nullptr) {
+    throw std::runtime_error(
+        "GetHandle: The transaction has not pinned the block");
+  }
+  return PageHandle{buffer};
+}
+
+int Transaction::GetInt(const BlockId& block, int offset, bool lock_block) {
+  if (lock_block) {
+    SharedLockBlock(block);
+  }
   auto buffer = my_buffers_.GetBuffer(block);
   if (buffer == nullptr) {
     throw std::runtime_error(
         "GetInt: The transaction has not pinned the block");
   }
-  return buffer->Contents().GetInt(offset);
+  return GetInt(PageHandle{buffer}, offset);
 }
 
-std::string_view Transaction::GetString(const BlockId& block, int offset) {
-  concurrency_manager_.SharedLock(block);
+std::string_view Transaction::GetString(const BlockId& block, int offset,
+                                        bool lock_block) {
+  if (lock_block) {
+    SharedLockBlock(block);
+  }
   auto buffer = my_buffers_.GetBuffer(block);
   if (buffer == nullptr) {
     throw std::runtime_error(
         "GetString: The transaction has not pinned the block");
   }
-  return buffer->Contents().GetString(offset);
+  return GetString(PageHandle{buffer}, offset);
 }
 
 void Transaction::SetInt(const BlockId& block, int offset, int val,
-                         bool OkToLog) {
-  concurrency_manager_.ExclusiveLock(block);
+                         bool OkToLog, bool lock_block) {
+  CheckWritable("SetInt");
+  if (lock_block) {
+    ExclusiveLockBlock(block);
+  }
   auto buffer = my_buffers_.GetBuffer(block);
   if (buffer == nullptr) {
     throw std::runtime_error(
         "SetInt: The transaction has not pinned the block");
   }
-  int lsn = -1;
-  if (OkToLog) {
-    lsn = recovery_manager_.SetInt(buffer, offset);
-  }
-  buffer->Contents().SetInt(offset, val);
-  buffer->SetModified(txn_id_, lsn);
+  SetInt(PageHandle{buffer}, offset, val, OkToLog);
 }
 
 void Transaction::SetString(const BlockId& block, int offset,
-                            std::string_view val, bool OkToLog) {
-  concurrency_manager_.ExclusiveLock(block);
+                            std::string_view val, bool OkToLog,
+                            bool lock_block) {
+  CheckWritable("SetString");
+  if (lock_block) {
+    ExclusiveLockBlock(block);
+  }
   auto buffer = my_buffers_.GetBuffer(block);
   if (buffer == nullptr) {
     throw std::runtime_error(
         "SetString: The transaction has not pinned the block");
   }
-  int lsn = -1;
+  SetString(PageHandle{buffer}, offset, val, OkToLog);
+}
+
+void Transaction::SetRow(const BlockId& block, int offset,
+                         std::span<const char> image, RowOp row_op,
+                         bool OkToLog, bool lock_block) {
+  CheckWritable("SetRow");
+  if (lock_block) {
+    ExclusiveLockBlock(block);
+  }
+  auto buffer = my_buffers_.GetBuffer(block);
+  if (buffer == nullptr) {
+    throw std::runtime_error(
+        "SetRow: The transaction has not pinned the block");
+  }
+  SetRow(PageHandle{buffer}, offset, image, row_op, OkToLog);
+}
+
+int Transaction::GetInt(const PageHandle& page, int offset) {
+  auto buffer = page.GetBuffer();
+  std::shared_lock latch{buffer->Latch()};
+  return buffer->Contents().GetInt(offset);
+}
+
+std::string_view Transaction::GetString(const PageHandle& page, int offset) {
+  auto buffer = page.GetBuffer();
+  // The bytes stay put after the latch is released, as long as the lock held
+  // on the block or record keeps other transactions from changing them. An
+  // optimistic transaction that reads bytes being changed fails validation.
+  std::shared_lock latch{buffer->Latch()};
+  return buffer->Contents().GetString(offset);
+}
+
+void Transaction::SetInt(const PageHandle& page, int offset, int val,
+                         bool OkToLog) {
+  CheckWritable("SetInt");
+  auto buffer = page.GetBuffer();
+  std::scoped_lock latch{buffer->Latch()};
+  Lsn lsn = INVALID_LSN;
   if (OkToLog) {
-    lsn = recovery_manager_.SetString(buffer, offset);
+    lsn = recovery_manager_.SetInt(buffer, offset, val);
+  }
+  buffer->Contents().SetInt(offset, val);
+  buffer->SetModified(txn_id_, lsn);
+}
+
+void Transaction::SetString(const PageHandle& page, int offset,
+                            std::string_view val, bool OkToLog) {
+  CheckWritable("SetString");
+  auto buffer = page.GetBuffer();
+  std::scoped_lock latch{buffer->Latch()};
+  Lsn lsn = INVALID_LSN;
+  if (OkToLog) {
+    lsn = recovery_manager_.SetString(buffer, offset, val);
   }
   buffer->Contents().SetString(offset, val);
   buffer->SetModified(txn_id_, lsn);
 }
 
+void Transaction::SetRow(const PageHandle& page, int offset,
+                         std::span<const char> image, RowOp row_op,
+                         bool OkToLog) {
+  CheckWritable("SetRow");
+  auto buffer = page.GetBuffer();
+  std::scoped_lock latch{buffer->Latch()};
+  Lsn lsn = INVALID_LSN;
+  if (OkToLog) {
+    lsn = recovery_manager_.SetRow(buffer, offset, image, row_op);
+  }
+  std::memcpy(buffer->Contents().Contents().data() + offset, image.data(),
+              image.size());
+  buffer->SetModified(txn_id_, lsn);
+}
+
 int Transaction::Size(std::string_view filename) {
   BlockId dummy_block{filename, END_OF_FILE};
-  concurrency_manager_.SharedLock(dummy_block);
+  SharedLockBlock(dummy_block);
   return file_manager_.Length(filename);
 }
 
 BlockId Transaction::Append(std::string_view filename) {
+  CheckWritable("Append");
   BlockId dummy_block{filename, END_OF_FILE};
-  concurrency_manager_.ExclusiveLock(dummy_block);
+  ExclusiveLockBlock(dummy_block);
   return file_manager_.Append(filename);
 }
+
+BlockId Transaction::AppendUnlogged(std::string_view filename) {
+  auto block = Append(filename);
+  ExclusiveLockBlock(block);
+  Pin(block);
+  Lsn lsn = recovery_manager_.Allocate(block);
+  {
+    auto buffer = my_buffers_.GetBuffer(block);
+    std::scoped_lock latch{buffer->Latch()};
+    buffer->SetModified(txn_id_, lsn);
+  }
+  Unpin(block);
+  return block;
+}
+
+void Transaction::SaveVersion(const BlockId& block, int slot, int offset,
+                              int size) {
+  if (!version_store_.Enabled()) {
+    return;
+  }
+  auto buffer = my_buffers_.GetBuffer(block);
+  if (buffer == nullptr) {
+    throw std::runtime_error(
+        "SaveVersion: The transaction has not pinned the block");
+  }
+  std::shared_lock latch{buffer->Latch()};
+  version_store_.Save(txn_id_, LockId{block, slot},
+                      buffer->Contents().Contents().subspan(offset, size));
+}
+
+void Transaction::ReadVersion(const BlockId& block, int slot, int offset,
+                              std::span<char> image) {
+  auto buffer = my_buffers_.GetBuffer(block);
+  if (buffer == nullptr) {
+    throw std::runtime_error(
+        "ReadVersion: The transaction has not pinned the block");
+  }
+  // Writers save a version before they change the page, so the page and the
+  // versions agree as long as both are read under the latch
+  std::shared_lock latch{buffer->Latch()};
+  auto bytes = buffer->Contents().Contents().subspan(offset, image.size());
+  std::copy(bytes.begin(), bytes.end(), image.begin());
+  version_store_.Read(LockId{block, slot}, snapshot_ts_, image);
+}
+
+void Transaction::SharedLockBlock(const BlockId& block) {
+  if (mode_ == TxnMode::LOCKING) {
+    concurrency_manager_.SharedLock(block);
+  } else if (mode_ == TxnMode::OPTIMISTIC) {
+    OptimisticRead(block);
+  }
+}
+
+void Transaction::ExclusiveLockBlock(const BlockId& block) {
+  if (mode_ == TxnMode::OPTIMISTIC) {
+    if (!TryOptimisticWrite(block)) {
+      throw LockAbortException();
+    }
+  } else {
+    concurrency_manager_.ExclusiveLock(block);
+  }
+}
+
+void Transaction::ReleaseLocks(Lsn commit_lsn) {
+  if (mode_ == TxnMode::OPTIMISTIC) {
+    optimistic_manager_.Release();
+  }
+  concurrency_manager_.Release(commit_lsn);
+}
+
+void Transaction::OptimisticRead(const BlockId& block, int slot) {
+  LockId id = slot < 0 ? LockId{block} : LockId{block, slot};
+  if (optimistic_manager_.Accessed(id)) {
+    return;
+  }
+  bool write_locked =
+      slot < 0 ? concurrency_manager_.IsWriteLocked(block)
+               : concurrency_manager_.IsWriteLocked(block, slot);
+  if (write_locked) {
+    throw LockAbortException();
+  }
+  optimistic_manager_.Read(id);
+}
+
+bool Transaction::TryOptimisticWrite(const BlockId& block, int slot) {
+  LockId id = slot < 0 ? LockId{block} : LockId{block, slot};
+  if (!optimistic_manager_.TryWrite(id)) {
+    return false;
+  }
+  return slot < 0 ? concurrency_manager_.TryExclusiveLockNoWait(block)
+                  : concurrency_manager_.TryExclusiveLockNoWait(block, slot);
+}
+
+void Transaction::EndReadOnly() {
+  // A snapshot transaction never touched the lock table
+  Lsn dependency_lsn = INVALID_LSN;
+  if (mode_ == TxnMode::SNAPSHOT) {
+    version_store_.EndSnapshot(snapshot_ts_);
+    dependency_lsn = snapshot_lsn_;
+  } else {
+    dependency_lsn = concurrency_manager_.DependencyLsn();
+    ReleaseLocks();
+  }
+  // A read-only transaction writes no COMMIT record whose flush would make
+  // what it read durable
+  recovery_manager_.WaitForLog(dependency_lsn);
+  my_buffers_.UnpinAll();
+}
+
+void Transaction::CheckWritable(std::string_view operation) const {
+  if (read_only_) {
+    throw std::runtime_error(std::string(operation) +
+                             ": The transaction is read-only");
+  }
+}
 }  // namespace simpledb
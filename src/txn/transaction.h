@@ -1,5 +1,7 @@
 #pragma once
 
+#include <span>  // NOLINT(build/include_order)
+#include <stdexcept>
 #include <string_view>
 
 #include "buffer/buffer_manager.h"
@@ -8,9 +10,34 @@
 #include "log/log_manager.h"
 #include "txn/buffer_list.h"
 #include "txn/concurrency/concurrency_manager.h"
+#include "txn/concurrency/optimistic_manager.h"
+#include "txn/concurrency/version_store.h"
+#include "txn/page_handle.h"
 #include "txn/recovery/recovery_manager.h"
 
 namespace simpledb {
+/**
+ * How a transaction is isolated from the others
+ * - LOCKING: strict two-phase locking; reads and writes lock what they touch
+ *   until the transaction ends.
+ * - SNAPSHOT: a read-only transaction that sees the database as committed
+ *   when it started, reading prior record versions from the version store
+ *   instead of taking shared locks. It requires the multi-version mode.
+ * - OPTIMISTIC: optimistic concurrency control; the transaction never waits
+ *   for a lock, notes the version of what it reads, and is validated at
+ *   commit (see `OptimisticManager`). What it changes is also locked
+ *   exclusively in the lock table, without waiting, so that locking
+ *   transactions and recovery do not read or overwrite it before it
+ *   commits. It aborts instead of reading what another transaction locks
+ *   exclusively. Validation only sees the changes of other optimistic
+ *   transactions, though, so a locking transaction must not change what a
+ *   concurrent optimistic one has read.
+ *
+ * Read-only transactions, including snapshot ones, write nothing to the log
+ * and flush nothing when they end.
+ */
+enum class TxnMode { LOCKING, SNAPSHOT, OPTIMISTIC };
+
 /**
  * Provide transaction management for clients, ensuring that all transactions
  * are serializable, recoverable, and in general satisfy the ACID properties
@@ -24,19 +51,51 @@ class Transaction {
    * @param file_manager file manager of the database engine
    * @param log_manager log manager of the database engine
    * @param buffer_manager buffer manager of the database engine
+   * @param commit_policy whether commit forces the modified data pages
+   * @param mode how the transaction is isolated from the others
+   * @param read_only whether the transaction only reads; snapshot
+   * transactions always do
+   * @param start_ts the start timestamp of an aborted transaction that this
+   * one retries (see `StartTimestamp`), or -1 for a new transaction
    */
   Transaction(FileManager& file_manager, LogManager& log_manager,
-              BufferManager& buffer_manager)
+              BufferManager& buffer_manager,
+              CommitPolicy commit_policy = CommitPolicy::FORCE,
+              TxnMode mode = TxnMode::LOCKING, bool read_only = false,
+              int start_ts = -1)
       : file_manager_(file_manager),
         buffer_manager_(buffer_manager),
         txn_id_(NextTxnId()),
+        start_ts_(start_ts < 0 ? txn_id_ : start_ts),
+        mode_(mode),
+        read_only_(read_only || mode == TxnMode::SNAPSHOT),
         my_buffers_(buffer_manager),
-        recovery_manager_(*this, txn_id_, log_manager, buffer_manager) {}
+        recovery_manager_(*this, txn_id_, log_manager, buffer_manager,
+                          commit_policy) {
+    if (mode_ == TxnMode::SNAPSHOT) {
+      if (!version_store_.Enabled()) {
+        throw std::runtime_error(
+            "Snapshot transactions require the multi-version mode");
+      }
+      snapshot_ts_ = version_store_.BeginSnapshot();
+      snapshot_lsn_ = version_store_.CommitLsn();
+    } else if (mode_ == TxnMode::OPTIMISTIC) {
+      optimistic_manager_.Begin();
+    }
+  }
 
   /**
    * Commit the current transaction. Flush all modified buffers (and their log
-   * records), write and flush a commit record to the log, release all locks,
-   * and unpin any pinned buffers.
+   * records) if the transaction uses the FORCE commit policy, write a commit
+   * record to the log, release all locks, flush the commit record, and unpin
+   * any pinned buffers. The locks are released before the flush, so other
+   * transactions wait for the commit record only if they need to. A read-only
+   * transaction only releases its locks and buffers, once the transactions
+   * whose changes it saw are durable, and so does a transaction that has
+   * logged no change: its START record is written with its first logged
+   * change, so it has none, and needs no COMMIT record either.
+   * An optimistic transaction is validated first; if that fails, a
+   * `LockAbortException` is thrown and the transaction must be rolled back.
    */
   void Commit();
 
@@ -55,11 +114,30 @@ class Transaction {
    */
   void Recover();
 
+  /**
+   * @brief Start recovering on demand: analyze the log, lock the blocks
+   * touched by unfinished transactions, and return. Blocks are redone as they
+   * are read, so other transactions can run meanwhile; those that access a
+   * locked block wait until it has been rolled back. `CompleteRecovery` must
+   * be called afterwards, typically on a background thread.
+   */
+  void RecoverOnDemand();
+
+  /**
+   * @brief Finish a recovery started by `RecoverOnDemand`. The locks on the
+   * rolled back blocks are released when the transaction commits.
+   */
+  void CompleteRecovery() { recovery_manager_.CompleteRecovery(); }
+
   /**
    * Pin the specified block. The transaction manages the buffer for the client.
+   * During an on-demand restart, a snapshot transaction first waits until
+   * recovery has rolled the block back (see `RecoverOnDemand`): it takes no
+   * locks, and the version store holds no versions of the changes of the
+   * crashed run.
    * @param block a reference to the disk block
    */
-  void Pin(const BlockId& block) { my_buffers_.Pin(block); }
+  void Pin(const BlockId& block);
 
   /**
    * Unpin the specified block. The transaction looks up the buffer pinned to
@@ -68,53 +146,221 @@ class Transaction {
    */
   void Unpin(const BlockId& block) { my_buffers_.Unpin(block); }
 
+  /**
+   * @brief Return a handle to the buffer pinned to the specified block, so
+   * that the fields of the block can be accessed without looking the buffer
+   * up each time. The handle is valid until the block is unpinned.
+   * @param block a reference to the disk block
+   * @return the handle to the pinned buffer
+   */
+  PageHandle GetHandle(const BlockId& block) const;
+
   /**
    * Return the integer value stored at the specified offset of the specified
-   * block. The method first obtains a SharedLock on the block, then it calls
-   * the buffer to retrieve the value.
+   * block. The method first obtains a SharedLock on the block, unless the
+   * caller locks the record it reads instead, then it calls the buffer to
+   * retrieve the value while holding the buffer's latch.
    * @param block a reference to a disk block
    * @param offset the byte offset within the block
+   * @param lock_block whether to lock the block
    * @return the integer stored at that offset
    */
-  int GetInt(const BlockId& block, int offset);
+  int GetInt(const BlockId& block, int offset, bool lock_block = true);
 
   /**
    * Return the string value stored at the specified offset of the specified
-   * block. The method first obtains a SharedLock on the block, then it calls
-   * the buffer to retrieve the value.
+   * block. The method first obtains a SharedLock on the block, unless the
+   * caller locks the record it reads instead, then it calls the buffer to
+   * retrieve the value while holding the buffer's latch.
    * @param block a reference to a disk block
    * @param offset the byte offset within the block
+   * @param lock_block whether to lock the block
    * @return the string stored at that offset
    */
-  std::string_view GetString(const BlockId& block, int offset);
+  std::string_view GetString(const BlockId& block, int offset,
+                             bool lock_block = true);
 
   /**
    * @brief Store an integer at the specified offset of the specified block. The
-   * method first obtains an ExclusiveLock on the block. It then logs this
-   * update operation by calling `SetInt` method of recovery manager. Finally,
-   * it calls the buffer to store the value, passing in the LSN of the log
-   * record and the transaction's id.
+   * method first obtains an ExclusiveLock on the block, unless the caller
+   * locks the record it changes instead. It then logs this update operation by
+   * calling `SetInt` method of recovery manager. Finally, it calls the buffer
+   * to store the value, passing in the LSN of the log record and the
+   * transaction's id. The buffer's latch is held exclusively meanwhile.
    * @param block a reference to the disk block
    * @param offset the byte offset within the disk block
    * @param val the new value to store
    * @param OkToLog whether to log this operation
+   * @param lock_block whether to lock the block
    */
-  void SetInt(const BlockId& block, int offset, int val, bool OkToLog);
+  void SetInt(const BlockId& block, int offset, int val, bool OkToLog,
+              bool lock_block = true);
 
   /**
    * @brief Store a string at the specified offset of the specified block. The
-   * method first obtains an ExclusiveLock on the block. It then logs this
-   * update operation by calling `SetString` method of recovery manager.
-   * Finally, it calls the buffer to store the value, passing in the LSN of the
-   * log record and the transaction's id.
+   * method first obtains an ExclusiveLock on the block, unless the caller
+   * locks the record it changes instead. It then logs this update operation by
+   * calling `SetString` method of recovery manager. Finally, it calls the
+   * buffer to store the value, passing in the LSN of the log record and the
+   * transaction's id. The buffer's latch is held exclusively meanwhile.
    * @param block a reference to the disk block
    * @param offset the byte offset within the disk block
    * @param val the new value to store
    * @param OkToLog whether to log this operation
+   * @param lock_block whether to lock the block
    */
   void SetString(const BlockId& block, int offset, std::string_view val,
+                 bool OkToLog, bool lock_block = true);
+
+  /**
+   * @brief Overwrite the bytes at the specified offset of the specified block
+   * with the image of a row. The whole row operation is logged as a single
+   * row record holding the old and new images.
+   * @param block a reference to the disk block
+   * @param offset the byte offset within the disk block
+   * @param image the new bytes to store
+   * @param row_op the row operation that the image describes
+   * @param OkToLog whether to log this operation
+   * @param lock_block whether to lock the block
+   */
+  void SetRow(const BlockId& block, int offset, std::span<const char> image,
+              RowOp row_op, bool OkToLog, bool lock_block = true);
+
+  /**
+   * @brief Return the integer value stored at the specified offset of a
+   * pinned page, while holding the buffer's latch. Nothing is locked: the
+   * caller has locked the block or the record it reads.
+   * @param page the handle to the pinned buffer
+   * @param offset the byte offset within the block
+   * @return the integer stored at that offset
+   */
+  int GetInt(const PageHandle& page, int offset);
+
+  /**
+   * @brief Return the string value stored at the specified offset of a
+   * pinned page, while holding the buffer's latch. Nothing is locked: the
+   * caller has locked the block or the record it reads.
+   * @param page the handle to the pinned buffer
+   * @param offset the byte offset within the block
+   * @return the string stored at that offset
+   */
+  std::string_view GetString(const PageHandle& page, int offset);
+
+  /**
+   * @brief Store an integer at the specified offset of a pinned page, logging
+   * the update as `SetInt` with a block does. Nothing is locked: the caller
+   * has locked the block or the record it changes.
+   * @param page the handle to the pinned buffer
+   * @param offset the byte offset within the block
+   * @param val the new value to store
+   * @param OkToLog whether to log this operation
+   */
+  void SetInt(const PageHandle& page, int offset, int val, bool OkToLog);
+
+  /**
+   * @brief Store a string at the specified offset of a pinned page, logging
+   * the update as `SetString` with a block does. Nothing is locked: the
+   * caller has locked the block or the record it changes.
+   * @param page the handle to the pinned buffer
+   * @param offset the byte offset within the block
+   * @param val the new value to store
+   * @param OkToLog whether to log this operation
+   */
+  void SetString(const PageHandle& page, int offset, std::string_view val,
                  bool OkToLog);
 
+  /**
+   * @brief Overwrite the bytes at the specified offset of a pinned page with
+   * the image of a row, logging it as `SetRow` with a block does. Nothing is
+   * locked: the caller has locked the record it changes.
+   * @param page the handle to the pinned buffer
+   * @param offset the byte offset within the block
+   * @param image the new bytes to store
+   * @param row_op the row operation that the image describes
+   * @param OkToLog whether to log this operation
+   */
+  void SetRow(const PageHandle& page, int offset, std::span<const char> image,
+              RowOp row_op, bool OkToLog);
+
+  /**
+   * @brief Lock a block for reading, as the mode of the transaction requires
+   * @param block a reference to the disk block
+   */
+  void SharedLockBlock(const BlockId& block);
+
+  /**
+   * @brief Lock a block for writing, as the mode of the transaction requires
+   * @param block a reference to the disk block
+   */
+  void ExclusiveLockBlock(const BlockId& block);
+
+  /**
+   * @brief Obtain a SharedLock on a whole file, so that the transaction can
+   * read all of it without locking its blocks or records one by one
+   * @param filename name of the file
+   */
+  void SharedLockFile(std::string_view filename) {
+    if (mode_ == TxnMode::LOCKING) {
+      concurrency_manager_.SharedLockFile(filename);
+    }
+  }
+
+  /**
+   * @brief Obtain a SharedLock on the record in the specified slot of the
+   * specified block
+   * @param block a reference to the disk block
+   * @param slot the slot of the record
+   */
+  void SharedLockRecord(const BlockId& block, int slot) {
+    if (mode_ == TxnMode::LOCKING) {
+      concurrency_manager_.SharedLock(block, slot);
+    } else if (mode_ == TxnMode::OPTIMISTIC) {
+      OptimisticRead(block, slot);
+    }
+  }
+
+  /**
+   * @brief Obtain an ExclusiveLock on the record in the specified slot of the
+   * specified block
+   * @param block a reference to the disk block
+   * @param slot the slot of the record
+   */
+  void ExclusiveLockRecord(const BlockId& block, int slot) {
+    if (mode_ == TxnMode::OPTIMISTIC) {
+      if (!TryOptimisticWrite(block, slot)) {
+        throw LockAbortException();
+      }
+    } else {
+      concurrency_manager_.ExclusiveLock(block, slot);
+    }
+  }
+
+  /**
+   * @brief Obtain an ExclusiveLock on a record only if no other transaction
+   * holds a lock on it
+   * @param block a reference to the disk block
+   * @param slot the slot of the record
+   * @return true if the lock was obtained; otherwise, false
+   */
+  bool TryExclusiveLockRecord(const BlockId& block, int slot) {
+    if (mode_ == TxnMode::OPTIMISTIC) {
+      return TryOptimisticWrite(block, slot);
+    }
+    return concurrency_manager_.TryExclusiveLock(block, slot);
+  }
+
+  /**
+   * @brief Return whether another transaction may be changing a record, i.e.,
+   * whether it holds an ExclusiveLock on it
+   * @param block a reference to the disk block
+   * @param slot the slot of the record
+   * @return true if another transaction locks the record exclusively;
+   * otherwise, false
+   */
+  bool IsRecordExclusivelyLocked(const BlockId& block, int slot) {
+    return concurrency_manager_.IsExclusivelyLocked(block, slot);
+  }
+
   /**
    * @brief Return the number of blocks in the specified file. This method first
    * obtains a SharedLock on the "end of file" block before asking the file
@@ -134,10 +380,104 @@ class Transaction {
   BlockId Append(std::string_view filename);
 
   /**
-   * @brief Get the size of a disk block
-   * @return size of a disk block
+   * @brief Append a new block that the transaction will fill without logging,
+   * as a bulk load does. Only the allocation is logged, so a rollback or
+   * recovery can empty the block again, and the block's page LSN is set to it
+   * so that the log record reaches the disk before the block does. The
+   * transaction then forces its modified pages at commit, whatever its commit
+   * policy.
+   * @param filename name of the file
+   * @return a reference to the newly-created disk block
    */
-  int BlockSize() const noexcept { return file_manager_.BlockSize(); }
+  BlockId AppendUnlogged(std::string_view filename);
+
+  /**
+   * @brief Log the end of a bulk load into the specified file
+   * @param filename name of the loaded file
+   * @param num_blocks number of blocks appended by the load
+   * @param num_rows number of rows written by the load
+   */
+  void LogBulkLoad(std::string_view filename, int num_blocks, int num_rows) {
+    recovery_manager_.LoadTable(filename, num_blocks, num_rows);
+  }
+
+  /**
+   * @brief Return whether the transaction reads a snapshot instead of locking
+   * @return true if the transaction is a snapshot transaction; otherwise,
+   * false
+   */
+  bool IsSnapshot() const noexcept { return mode_ == TxnMode::SNAPSHOT; }
+
+  /**
+   * @brief Return whether the transaction is validated at commit instead of
+   * locking
+   * @return true if the transaction is an optimistic transaction; otherwise,
+   * false
+   */
+  bool IsOptimistic() const noexcept { return mode_ == TxnMode::OPTIMISTIC; }
+
+  /**
+   * @brief Return whether the transaction only reads the database
+   * @return true if the transaction is read-only; otherwise, false
+   */
+  bool IsReadOnly() const noexcept { return read_only_; }
+
+  /**
+   * @brief Return the start timestamp of the transaction, which orders it
+   * against the others when the deadlock policy is WAIT_DIE or WOUND_WAIT.
+   * It is the transaction id, unless the transaction retries an aborted one
+   * and took over its timestamp, so that retries do not get younger.
+   * @return the start timestamp
+   */
+  int StartTimestamp() const noexcept { return start_ts_; }
+
+  /**
+   * @brief Save the current image of a record before the transaction first
+   * changes it, so that snapshot transactions can still read it. The
+   * transaction holds an ExclusiveLock on the record. Nothing is saved unless
+   * the multi-version mode is on.
+   * @param block a reference to the disk block
+   * @param slot the slot of the record
+   * @param offset the byte offset of the record slot within the block
+   * @param size the size of the record slot
+   */
+  void SaveVersion(const BlockId& block, int slot, int offset, int size);
+
+  /**
+   * @brief Read the version of a record that the snapshot of the transaction
+   * sees
+   * @param block a reference to the disk block
+   * @param slot the slot of the record
+   * @param offset the byte offset of the record slot within the block
+   * @param image receives the bytes of the record slot
+   */
+  void ReadVersion(const BlockId& block, int slot, int offset,
+                   std::span<char> image);
+
+  /**
+   * @brief Turn the multi-version mode on or off. In this mode, transactions
+   * keep the prior versions of the records they change, so that snapshot
+   * transactions can be started. Choose the mode before transactions start.
+   * @param enabled whether to keep record versions
+   */
+  static void SetMultiVersion(bool enabled) noexcept {
+    version_store_.SetEnabled(enabled);
+  }
+
+  /**
+   * @brief Return whether the multi-version mode is on
+   * @return true if record versions are kept; otherwise, false
+   */
+  static bool MultiVersion() noexcept { return version_store_.Enabled(); }
+
+  /**
+   * @brief Get the number of bytes of a disk block available to clients, i.e.,
+   * the block size minus the block header
+   * @return usable size of a disk block
+   */
+  int BlockSize() const noexcept {
+    return file_manager_.BlockSize() - Buffer::HEADER_SIZE;
+  }
 
   /**
    * @brief Return the number of available (i.e. unpinned) buffers
@@ -145,6 +485,20 @@ class Transaction {
    */
   int AvailableBuffers() const noexcept { return buffer_manager_.Available(); }
 
+  /**
+   * @brief Make sure that transactions created from now on get ids greater
+   * than the specified one
+   * @param txn_id the largest transaction id in use
+   */
+  static void ReserveTxnIds(int txn_id) noexcept {
+    int next_txn_id = __atomic_load_n(&next_txn_id_, __ATOMIC_SEQ_CST);
+    while (next_txn_id < txn_id &&
+           !__atomic_compare_exchange_n(&next_txn_id_, &next_txn_id, txn_id,
+                                        false, __ATOMIC_SEQ_CST,
+                                        __ATOMIC_SEQ_CST)) {
+    }
+  }
+
  private:
   /**
    * @brief Return the next transaction id for use
@@ -154,14 +508,66 @@ class Transaction {
     return __atomic_add_fetch(&next_txn_id_, 1, __ATOMIC_SEQ_CST);
   }
 
+  /**
+   * @brief Release the locks of the transaction, and the items claimed by an
+   * optimistic transaction
+   * @param commit_lsn the LSN of the transaction's COMMIT record if it may
+   * not be durable yet; otherwise, `INVALID_LSN`
+   */
+  void ReleaseLocks(Lsn commit_lsn = INVALID_LSN);
+
+  /**
+   * @brief Note that an optimistic transaction reads a block, or a record if
+   * a slot is given. A `LockAbortException` is thrown if another transaction
+   * locks it exclusively, such as a locking transaction changing it or a
+   * restart that has yet to roll it back.
+   * @param block a reference to the disk block
+   * @param slot the slot of the record, or -1 for the whole block
+   */
+  void OptimisticRead(const BlockId& block, int slot = -1);
+
+  /**
+   * @brief Claim a block, or a record if a slot is given, before an
+   * optimistic transaction changes it, and lock it exclusively without
+   * waiting. A `LockAbortException` is thrown if the transaction read it and
+   * another transaction has changed it since.
+   * @param block a reference to the disk block
+   * @param slot the slot of the record, or -1 for the whole block
+   * @return true if the item is claimed and locked; otherwise, false
+   */
+  bool TryOptimisticWrite(const BlockId& block, int slot = -1);
+
+  /**
+   * @brief End a read-only transaction: end its snapshot, if any, release
+   * its locks, wait until the changes it saw are durable, and release its
+   * buffers. There is nothing to log.
+   */
+  void EndReadOnly();
+
+  /**
+   * @brief Reject a change made by a read-only transaction
+   * @param operation name of the rejected operation
+   */
+  void CheckWritable(std::string_view operation) const;
+
   static int next_txn_id_;
   static constexpr int END_OF_FILE = -1;
+  // The prior versions of records. This variable is static because all
+  // transactions share the same store.
+  static VersionStore version_store_;
 
   FileManager& file_manager_;
   BufferManager& buffer_manager_;
   int txn_id_{};
+  int start_ts_{};
+  TxnMode mode_{};
+  bool read_only_{};
+  VersionStore::Timestamp snapshot_ts_{};
+  // how far the log must be durable for the changes the snapshot sees
+  Lsn snapshot_lsn_{INVALID_LSN};
   BufferList my_buffers_;
-  ConcurrencyManager concurrency_manager_{};
+  ConcurrencyManager concurrency_manager_{txn_id_, start_ts_};
+  OptimisticManager optimistic_manager_{txn_id_};
   RecoveryManager recovery_manager_;
 };
 }  // namespace simpledb
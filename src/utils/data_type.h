@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <unordered_map>
@@ -16,4 +17,13 @@ using StringHashMap =
 
 using StringSet = std::unordered_set<std::string, string_hash, std::equal_to<>>;
 
+/**
+ * A log sequence number. An LSN is the byte offset of a log record within the
+ * log stream, so LSNs grow monotonically and locate their records directly.
+ */
+using Lsn = int64_t;
+
+// An LSN that refers to no log record
+static constexpr Lsn INVALID_LSN = -1;
+
 }  // namespace simpledb
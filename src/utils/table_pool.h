@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace simpledb {
+/**
+ * A per-thread pool of empty hash tables, such as the tables that every
+ * transaction fills while it runs and empties when it ends. A cleared
+ * `std::unordered_map` keeps its bucket array, so a table taken from the pool
+ * can be filled again without growing it. Each thread has its own pool, so
+ * taking and returning a table needs no latch.
+ * @tparam Table an unordered associative container, or a table such as
+ * `LockCache` with the same `clear` and `bucket_count`
+ */
+template <typename Table>
+class TablePool {
+ public:
+  /**
+   * @brief Take an empty table from the pool of the calling thread, or create
+   * one if the pool is empty
+   * @return an empty table
+   */
+  static Table Acquire() {
+    auto& tables = Tables();
+    if (tables.empty()) {
+      return Table{};
+    }
+    Table table = std::move(tables.back());
+    tables.pop_back();
+    return table;
+  }
+
+  /**
+   * @brief Clear a table and return it to the pool of the calling thread. A
+   * table that has grown very large is dropped instead, so that the pool does
+   * not keep the memory of the largest transactions.
+   * @param table the table to return
+   */
+  static void Release(Table&& table) {
+    auto& tables = Tables();
+    if (tables.size() >= MAX_TABLES || table.bucket_count() > MAX_BUCKETS) {
+      return;
+    }
+    table.clear();
+    tables.push_back(std::move(table));
+  }
+
+ private:
+  /**
+   * @brief Return the pool of the calling thread
+   * @return a reference to the pooled tables
+   */
+  static std::vector<Table>& Tables() {
+    thread_local std::vector<Table> tables;
+    return tables;
+  }
+
+  static constexpr size_t MAX_TABLES = 16;
+  static constexpr size_t MAX_BUCKETS = 1024;
+};
+}  // namespace simpledb
@@ -0,0 +1,115 @@
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "buffer/buffer.h"
+#include "crash_util.h"
+#include "file/block_id.h"
+#include "file/page.h"
+#include "log/log_manager.h"
+#include "record/bulk_loader.h"
+#include "record/layout.h"
+#include "record/record_page.h"
+#include "record/schema.h"
+#include "server/simpledb.h"
+#include "txn/transaction.h"
+
+namespace simpledb {
+constexpr int NUM_ROWS = 30;
+
+// Load rows {i, "row<i>"} into a table without closing the loader
+void Load(BulkLoader& loader) {
+  for (int i = 0; i < NUM_ROWS; i++) {
+    loader.Insert({"A", "B"},
+                  {Constant{i}, Constant{"row" + std::to_string(i)}});
+  }
+}
+
+// Print the number of rows in a table and the sum of their A-values
+void PrintRows(SimpleDB& db, std::string_view filename, Layout& layout,
+               std::string_view msg) {
+  auto txn = db.NewTxn();
+  int rows = 0;
+  int sum = 0;
+  int size = txn.Size(filename);
+  for (int block_num = 0; block_num < size; block_num++) {
+    BlockId block{filename, block_num};
+    txn.Pin(block);
+    RecordPage record_page{txn, block, layout};
+    for (int slot = record_page.NextAfter(-1); slot >= 0;
+         slot = record_page.NextAfter(slot)) {
+      rows++;
+      sum += record_page.GetInt(slot, "A");
+    }
+    txn.Unpin(block);
+  }
+  txn.Commit();
+  std::cout << msg << ' ' << rows << " rows, sum " << sum << '\n';
+}
+
+// Print whether every block of a file is zeroed on disk. Transactions address
+// a block's bytes after its header.
+void PrintZeroed(SimpleDB& db, std::string_view filename) {
+  auto& file_manager = db.GetFileManager();
+  int size = file_manager.Length(filename);
+  bool zeroed = true;
+  Page page{file_manager.BlockSize()};
+  for (int block_num = 0; block_num < size; block_num++) {
+    file_manager.Read(BlockId{filename, block_num}, page);
+    auto contents = page.Contents();
+    for (size_t i = Buffer::HEADER_SIZE; i < contents.size(); i++) {
+      zeroed = zeroed && contents[i] == 0;
+    }
+  }
+  std::cout << size << " blocks of " << filename
+            << (zeroed ? " are zeroed\n" : " are not zeroed\n");
+}
+
+// Three tables are loaded: one load commits, one rolls back, and one is cut
+// short by a crash. The restart recovers and checks that only the committed
+// load survives, and that the crashed load left zeroed blocks.
+void BulkLoaderTest() {
+  std::string_view dirname = "bulk_loader_test";
+  Schema schema;
+  schema.AddIntField("A");
+  schema.AddStringField("B", 9);
+  Layout layout{std::move(schema)};
+  std::filesystem::remove_all(dirname);
+  RunUntilCrash([&] {
+    SimpleDB db{dirname, 400, 8};
+    auto txn1 = db.NewTxn();
+    BulkLoader committed{txn1, "committed", layout};
+    Load(committed);
+    std::cout << "Loaded " << committed.Close() << " rows\n";
+    txn1.Commit();
+    PrintRows(db, "committed.tbl", layout, "After commit:");
+
+    auto txn2 = db.NewTxn();
+    BulkLoader rolled_back{txn2, "rolled_back", layout};
+    Load(rolled_back);
+    rolled_back.Close();
+    txn2.Rollback();
+    PrintRows(db, "rolled_back.tbl", layout, "After rollback:");
+    PrintZeroed(db, "rolled_back.tbl");
+
+    // The load is neither closed nor committed, but its blocks reach disk
+    auto txn3 = db.NewTxn();
+    BulkLoader crashed_loader{txn3, "crashed", layout};
+    Load(crashed_loader);
+    db.GetBufferManager().FlushAll();
+    std::cout << "Crash in the middle of a load\n";
+  });
+  SimpleDB db{dirname, 400, 8};
+  Restart(db);
+  PrintRows(db, "committed.tbl", layout, "After restart:");
+  PrintRows(db, "crashed.tbl", layout, "After recovery:");
+  PrintZeroed(db, "crashed.tbl");
+}
+}  // namespace simpledb
+
+int main() {
+  simpledb::BulkLoaderTest();
+
+  return 0;
+}
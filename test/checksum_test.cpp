@@ -0,0 +1,88 @@
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "buffer/buffer.h"
+#include "buffer/buffer_manager.h"
+#include "file/block_id.h"
+#include "file/crc32c.h"
+#include "file/page.h"
+#include "server/simpledb.h"
+
+namespace simpledb {
+constexpr int NUM_BLOCKS = 64;
+constexpr int ROUNDS = 20;
+
+// Cycle a buffer through the blocks of a file, dirtying each one so that
+// moving the buffer to the next block writes it back. Return the time taken
+// by all but the first round, which creates the blocks.
+std::chrono::microseconds TimeBufferIo(SimpleDB& db,
+                                       std::string_view filename) {
+  Buffer buffer{db.GetFileManager(), db.GetLogManager()};
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round <= ROUNDS; round++) {
+    if (round == 1) {
+      start = std::chrono::steady_clock::now();
+    }
+    for (int i = 0; i < NUM_BLOCKS; i++) {
+      buffer.AssignToBlock(BlockId{filename, i});
+      buffer.Contents().SetInt(0, i);
+      buffer.SetModified(1, INVALID_LSN);
+    }
+  }
+  buffer.Flush();
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+}
+
+void ChecksumTest() {
+  std::string_view check{"123456789"};
+  std::cout << "CRC32C of \"123456789\" is " << std::hex << Crc32c(check)
+            << " (expected e3069283)" << std::dec << '\n';
+
+  SimpleDB db{"checksum_test", 4096, 8};
+  auto& file_manager = db.GetFileManager();
+  auto& buffer_manager = db.GetBufferManager();
+
+  // Compare reading and writing blocks with and without checksums. Each
+  // file is written with checksums either always on or always off, so that
+  // its blocks stay verifiable.
+  auto verified_time = TimeBufferIo(db, "bench_file");
+  Buffer::SetChecksums(false);
+  auto unverified_time = TimeBufferIo(db, "unverified_file");
+  Buffer::SetChecksums(true);
+  std::cout << "reading and writing " << NUM_BLOCKS * ROUNDS
+            << " blocks took " << verified_time.count()
+            << "us with checksums and " << unverified_time.count()
+            << "us without\n";
+
+  Page page{file_manager.BlockSize()};
+  // Corrupt a flushed block behind the buffer manager's back
+  BlockId block{"bench_file", 3};
+  file_manager.Read(block, page);
+  page.SetInt(100, page.GetInt(100) + 1);
+  file_manager.Write(block, page);
+  // Make the buffer manager read the blocks from disk again
+  for (int i = NUM_BLOCKS; i < NUM_BLOCKS + 8; i++) {
+    buffer_manager.Unpin(buffer_manager.Pin(BlockId{"bench_file", i}));
+  }
+  for (int i = 0; i < NUM_BLOCKS; i++) {
+    try {
+      buffer_manager.Unpin(buffer_manager.Pin(BlockId{"bench_file", i}));
+    } catch (const std::runtime_error& e) {
+      std::cout << e.what() << '\n';
+    }
+  }
+  std::cout << Buffer::ChecksumFailures()
+            << " checksum failure(s) detected (expected 1)\n";
+}
+}  // namespace simpledb
+
+int main() {
+  simpledb::ChecksumTest();
+
+  return 0;
+}
@@ -1,10 +1,16 @@
+#include <chrono>  // NOLINT(build/c++11)
 #include <iostream>
+#include <string_view>
 #include <thread>  // NOLINT(build/c++11)
 
 #include "buffer/buffer_manager.h"
 #include "file/file_manager.h"
 #include "log/log_manager.h"
+#include "record/layout.h"
+#include "record/schema.h"
+#include "record/table_scan.h"
 #include "server/simpledb.h"
+#include "txn/concurrency/concurrency_manager.h"
 #include "txn/transaction.h"
 
 using namespace std::chrono_literals;  // NOLINT(build/namespaces)
@@ -18,18 +24,25 @@ void RunA(FileManager& file_manager, LogManager& log_manager,
   txnA.Pin(block1);
   txnA.Pin(block2);
 
-  std::cout << "Transaction A: request SharedLock 1\n";
-  txnA.GetInt(block1, 0);
-  std::cout << "Transaction A: receive SharedLock 1\n";
+  try {
+    std::cout << "Transaction A: request SharedLock 1\n";
+    txnA.GetInt(block1, 0);
+    std::cout << "Transaction A: receive SharedLock 1\n";
 
-  std::this_thread::sleep_for(1000ms);
+    std::this_thread::sleep_for(1000ms);
 
-  std::cout << "Transaction A: request SharedLock 2\n";
-  txnA.GetInt(block2, 0);
-  std::cout << "Transaction A: receive SharedLock 2\n";
+    std::cout << "Transaction A: request SharedLock 2\n";
+    txnA.GetInt(block2, 0);
+    std::cout << "Transaction A: receive SharedLock 2\n";
 
-  txnA.Commit();
-  std::cout << "Transaction A: commit\n";
+    txnA.Commit();
+    std::cout << "Transaction A: commit\n";
+  } catch (const LockAbortException&) {
+    // The deadlock policy may abort a transaction, depending on the order in
+    // which the threads run
+    std::cout << "Transaction A: aborted\n";
+    txnA.Rollback();
+  }
 }
 
 void RunB(FileManager& file_manager, LogManager& log_manager,
@@ -40,18 +53,23 @@ void RunB(FileManager& file_manager, LogManager& log_manager,
   txnB.Pin(block1);
   txnB.Pin(block2);
 
-  std::cout << "Transaction B: request ExclusiveLock 2\n";
-  txnB.SetInt(block2, 0, 0, false);
-  std::cout << "Transaction B: receive ExclusiveLock 2\n";
+  try {
+    std::cout << "Transaction B: request ExclusiveLock 2\n";
+    txnB.SetInt(block2, 0, 0, false);
+    std::cout << "Transaction B: receive ExclusiveLock 2\n";
 
-  std::this_thread::sleep_for(1000ms);
+    std::this_thread::sleep_for(1000ms);
 
-  std::cout << "Transaction B: request SharedLock 1\n";
-  txnB.GetInt(block1, 0);
-  std::cout << "Transaction B: receive SharedLock 1\n";
+    std::cout << "Transaction B: request SharedLock 1\n";
+    txnB.GetInt(block1, 0);
+    std::cout << "Transaction B: receive SharedLock 1\n";
 
-  txnB.Commit();
-  std::cout << "Transaction B: commit\n";
+    txnB.Commit();
+    std::cout << "Transaction B: commit\n";
+  } catch (const LockAbortException&) {
+    std::cout << "Transaction B: aborted\n";
+    txnB.Rollback();
+  }
 }
 
 void RunC(FileManager& file_manager, LogManager& log_manager,
@@ -62,18 +80,23 @@ void RunC(FileManager& file_manager, LogManager& log_manager,
   txnC.Pin(block1);
   txnC.Pin(block2);
 
-  std::cout << "Transaction C: request ExclusiveLock 1\n";
-  txnC.SetInt(block1, 0, 0, false);
-  std::cout << "Transaction C: receive ExclusiveLock 1\n";
+  try {
+    std::cout << "Transaction C: request ExclusiveLock 1\n";
+    txnC.SetInt(block1, 0, 0, false);
+    std::cout << "Transaction C: receive ExclusiveLock 1\n";
 
-  std::this_thread::sleep_for(1000ms);
+    std::this_thread::sleep_for(1000ms);
 
-  std::cout << "Transaction C: request SharedLock 2\n";
-  txnC.GetInt(block2, 0);
-  std::cout << "Transaction C: receive SharedLock 2\n";
+    std::cout << "Transaction C: request SharedLock 2\n";
+    txnC.GetInt(block2, 0);
+    std::cout << "Transaction C: receive SharedLock 2\n";
 
-  txnC.Commit();
-  std::cout << "Transaction C: commit\n";
+    txnC.Commit();
+    std::cout << "Transaction C: commit\n";
+  } catch (const LockAbortException&) {
+    std::cout << "Transaction C: aborted\n";
+    txnC.Rollback();
+  }
 }
 
 void ConcurrencyTest() {
@@ -93,10 +116,281 @@ void ConcurrencyTest() {
   t2.join();
   t3.join();
 }
+
+void RunDeadlock(Transaction& txn, std::string_view name, const BlockId& first,
+                 const BlockId& second) {
+  txn.Pin(first);
+  txn.Pin(second);
+  try {
+    txn.SetInt(first, 0, 1, false);
+    std::this_thread::sleep_for(200ms);
+    txn.SetInt(second, 0, 1, false);
+    txn.Commit();
+    std::cout << "Transaction " << name << ": commit\n";
+  } catch (const LockAbortException&) {
+    std::cout << "Transaction " << name << ": aborted\n";
+    txn.Rollback();
+  }
+}
+
+void DeadlockTest(DeadlockPolicy policy, std::string_view policy_name) {
+  SimpleDB db{"concurrency_test", 400, 8};
+  ConcurrencyManager::SetDeadlockPolicy(policy);
+  std::cout << "Deadlock with policy " << policy_name << '\n';
+  BlockId block1{"test_file", 1};
+  BlockId block2{"test_file", 2};
+  // The older transaction survives under every policy
+  auto older = db.NewTxn();
+  auto younger = db.NewTxn();
+  std::thread t1(RunDeadlock, std::ref(older), "older", block1, block2);
+  std::thread t2(RunDeadlock, std::ref(younger), "younger", block2, block1);
+  t1.join();
+  t2.join();
+}
+
+void RetryTest() {
+  SimpleDB db{"concurrency_test", 400, 8};
+  ConcurrencyManager::SetDeadlockPolicy(DeadlockPolicy::WAIT_DIE);
+  std::cout << "Retry with policy WAIT_DIE\n";
+  BlockId block{"test_file", 6};
+  auto holder = db.NewTxn();
+  auto first_try = db.NewTxn();
+  holder.ExclusiveLockRecord(block, 0);
+  try {
+    first_try.ExclusiveLockRecord(block, 0);
+  } catch (const LockAbortException&) {
+    std::cout << "First try: aborted\n";
+    first_try.Rollback();
+  }
+  // A transaction started after the abort holds the lock when the retry
+  // requests it. The retry keeps its original start timestamp, so it is the
+  // older of the two and waits instead of dying again.
+  auto later = db.NewTxn();
+  holder.Commit();
+  later.ExclusiveLockRecord(block, 0);
+  auto retry = db.NewTxn(first_try.StartTimestamp());
+  std::thread t([&retry, &block] {
+    try {
+      std::cout << "Retry: request ExclusiveLock\n";
+      retry.ExclusiveLockRecord(block, 0);
+      std::cout << "Retry: receive ExclusiveLock\n";
+      retry.Commit();
+    } catch (const LockAbortException&) {
+      std::cout << "Retry: aborted\n";
+      retry.Rollback();
+    }
+  });
+  std::this_thread::sleep_for(200ms);
+  std::cout << "Later transaction: commit\n";
+  later.Commit();
+  t.join();
+}
+
+void RecordLockTest() {
+  SimpleDB db{"concurrency_test", 400, 8};
+  ConcurrencyManager::SetDeadlockPolicy(DeadlockPolicy::DETECT);
+  std::cout << "Record locks\n";
+  BlockId block{"test_file", 3};
+  auto txn1 = db.NewTxn();
+  auto txn2 = db.NewTxn();
+  txn1.Pin(block);
+  txn2.Pin(block);
+  // Two records of the same block can be changed concurrently
+  txn1.ExclusiveLockRecord(block, 0);
+  txn1.SetInt(block, 0, 1, false, false);
+  std::cout << "Transaction 1: receive ExclusiveLock on record 0\n";
+  txn2.ExclusiveLockRecord(block, 1);
+  txn2.SetInt(block, 4, 2, false, false);
+  std::cout << "Transaction 2: receive ExclusiveLock on record 1\n";
+  // The whole block conflicts with the locked records
+  std::thread t([&txn2, &block] {
+    std::cout << "Transaction 2: request SharedLock on the block\n";
+    txn2.GetInt(block, 0);
+    std::cout << "Transaction 2: receive SharedLock on the block\n";
+    txn2.Commit();
+  });
+  std::this_thread::sleep_for(200ms);
+  std::cout << "Transaction 1: commit\n";
+  txn1.Commit();
+  t.join();
+}
+
+void FairnessTest() {
+  SimpleDB db{"concurrency_test", 400, 8};
+  std::cout << "Lock fairness\n";
+  BlockId block{"test_file", 5};
+  auto reader1 = db.NewTxn();
+  auto writer = db.NewTxn();
+  auto reader2 = db.NewTxn();
+  reader1.SharedLockRecord(block, 0);
+  std::cout << "Reader 1: receive SharedLock\n";
+  std::thread t1([&writer, &block] {
+    std::cout << "Writer: request ExclusiveLock\n";
+    writer.ExclusiveLockRecord(block, 0);
+    std::cout << "Writer: receive ExclusiveLock\n";
+    std::this_thread::sleep_for(200ms);
+    std::cout << "Writer: commit\n";
+    writer.Commit();
+  });
+  std::this_thread::sleep_for(200ms);
+  // The second reader is compatible with the first, but must not overtake
+  // the writer queued before it
+  std::thread t2([&reader2, &block] {
+    std::cout << "Reader 2: request SharedLock\n";
+    reader2.SharedLockRecord(block, 0);
+    std::cout << "Reader 2: receive SharedLock\n";
+    reader2.Commit();
+  });
+  std::this_thread::sleep_for(200ms);
+  std::cout << "Reader 1: commit\n";
+  reader1.Commit();
+  t1.join();
+  t2.join();
+}
+
+void EscalationTest() {
+  SimpleDB db{"concurrency_test", 400, 8};
+  ConcurrencyManager::SetEscalationThreshold(2);
+  std::cout << "Lock escalation\n";
+  BlockId block1{"test_file", 1};
+  BlockId block2{"test_file", 2};
+  auto txn1 = db.NewTxn();
+  auto txn2 = db.NewTxn();
+  // The third record lock turns into an ExclusiveLock on the file
+  for (int slot = 0; slot < 3; slot++) {
+    txn1.ExclusiveLockRecord(block1, slot);
+  }
+  std::cout << "Transaction 1: receive ExclusiveLocks on 3 records\n";
+  std::thread t([&txn2, &block2] {
+    std::cout << "Transaction 2: request SharedLock on a record of block 2\n";
+    txn2.SharedLockRecord(block2, 0);
+    std::cout << "Transaction 2: receive SharedLock on a record of block 2\n";
+    txn2.Commit();
+  });
+  std::this_thread::sleep_for(200ms);
+  std::cout << "Transaction 1: commit\n";
+  txn1.Commit();
+  t.join();
+  ConcurrencyManager::SetEscalationThreshold(5000);
+}
+
+int ReadA(Transaction& txn, Layout& layout) {
+  TableScan scan{txn, "snapshot_table", layout};
+  scan.Next();
+  int val = scan.GetInt("a");
+  scan.Close();
+  return val;
+}
+
+void SnapshotTest() {
+  SimpleDB db{"concurrency_test", 400, 8};
+  Transaction::SetMultiVersion(true);
+  std::cout << "Snapshot reads\n";
+  Schema schema;
+  schema.AddIntField("a");
+  Layout layout{schema};
+  auto setup = db.NewTxn();
+  TableScan scan{setup, "snapshot_table", layout};
+  // The table may be left over from an earlier run
+  if (!scan.Next()) {
+    scan.Insert();
+  }
+  scan.SetInt("a", 1);
+  scan.Close();
+  setup.Commit();
+
+  auto snapshot1 = db.NewSnapshotTxn();
+  auto writer = db.NewTxn();
+  TableScan writer_scan{writer, "snapshot_table", layout};
+  writer_scan.Next();
+  writer_scan.SetInt("a", 2);
+  writer_scan.Close();
+  // The writer's locks do not block snapshot readers
+  std::cout << "Snapshot 1 reads " << ReadA(snapshot1, layout)
+            << " while the writer is active\n";
+  writer.Commit();
+  std::cout << "Snapshot 1 reads " << ReadA(snapshot1, layout)
+            << " after the writer committed\n";
+  auto snapshot2 = db.NewSnapshotTxn();
+  std::cout << "Snapshot 2 reads " << ReadA(snapshot2, layout) << '\n';
+  snapshot1.Commit();
+  snapshot2.Commit();
+  Transaction::SetMultiVersion(false);
+}
+
+void BatchReleaseTest() {
+  SimpleDB db{"concurrency_test", 400, 8};
+  std::cout << "Batched release\n";
+  constexpr int num_blocks = 100;
+  constexpr int slots_per_block = 40;
+  auto txn1 = db.NewTxn();
+  auto txn2 = db.NewTxn();
+  for (int i = 0; i < num_blocks; i++) {
+    BlockId block{"test_file", 10 + i};
+    for (int slot = 0; slot < slots_per_block; slot++) {
+      txn1.ExclusiveLockRecord(block, slot);
+    }
+  }
+  std::cout << "Transaction 1: receive ExclusiveLocks on "
+            << num_blocks * slots_per_block << " records\n";
+  BlockId last{"test_file", 10 + num_blocks - 1};
+  std::thread t([&txn2, &last] {
+    std::cout << "Transaction 2: request SharedLock on the last record\n";
+    txn2.SharedLockRecord(last, slots_per_block - 1);
+    std::cout << "Transaction 2: receive SharedLock on the last record\n";
+    txn2.Commit();
+  });
+  std::this_thread::sleep_for(200ms);
+  auto start = std::chrono::steady_clock::now();
+  txn1.Commit();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  t.join();
+  std::cout << "Transaction 1: commit and release its locks in "
+            << std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+                   .count()
+            << "us\n";
+}
+
+void EarlyReleaseTest() {
+  SimpleDB db{"concurrency_test", 400, 8};
+  auto& log_manager = db.GetLogManager();
+  // Leave the asynchronous commit to the flusher for a long time
+  log_manager.SetFlushInterval(10s);
+  std::cout << "Early lock release\n";
+  BlockId block{"test_file", 4};
+  Transaction writer{db.GetFileManager(), log_manager, db.GetBufferManager(),
+                     CommitPolicy::ASYNC};
+  writer.Pin(block);
+  writer.SetInt(block, 0, 1, true);
+  writer.Commit();
+  Lsn commit_lsn = log_manager.LatestLsn();
+  std::cout << "Writer: commit record durable after commit: "
+            << (log_manager.DurableLsn() >= commit_lsn ? "yes" : "no")
+            << '\n';
+  // The reader gets the released lock, and waits for the commit record
+  auto reader = db.NewReadOnlyTxn();
+  reader.Pin(block);
+  reader.GetInt(block, 0);
+  reader.Commit();
+  std::cout << "Reader: commit record durable after the reader ended: "
+            << (log_manager.DurableLsn() >= commit_lsn ? "yes" : "no")
+            << '\n';
+  log_manager.SetFlushInterval(LogManager::DEFAULT_FLUSH_INTERVAL);
+}
 }  // namespace simpledb
 
 int main() {
   simpledb::ConcurrencyTest();
+  simpledb::DeadlockTest(simpledb::DeadlockPolicy::DETECT, "DETECT");
+  simpledb::DeadlockTest(simpledb::DeadlockPolicy::WAIT_DIE, "WAIT_DIE");
+  simpledb::DeadlockTest(simpledb::DeadlockPolicy::WOUND_WAIT, "WOUND_WAIT");
+  simpledb::RetryTest();
+  simpledb::RecordLockTest();
+  simpledb::FairnessTest();
+  simpledb::EscalationTest();
+  simpledb::SnapshotTest();
+  simpledb::BatchReleaseTest();
+  simpledb::EarlyReleaseTest();
 
   return 0;
 }
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <iostream>
+
+#include "server/simpledb.h"
+#include "txn/recovery/recovery_manager.h"
+#include "txn/transaction.h"
+
+namespace simpledb {
+/**
+ * @brief Run the first half of a recovery test in a child process that then
+ * crashes: it exits without flushing its buffers or its log, and without
+ * running any destructor. The caller waits for it, then opens the database
+ * again and checks the recovery, so that one run of a test checks both
+ * halves. Like a restarted process, the caller has none of the child's
+ * in-memory state, such as its locks, versions, and transaction ids.
+ * @param before_crash the work to do before the crash
+ */
+template <typename F>
+void RunUntilCrash(F before_crash) {
+  std::cout.flush();
+  pid_t pid = fork();
+  if (pid == 0) {
+    before_crash();
+    std::cout.flush();
+    std::_Exit(0);
+  }
+  waitpid(pid, nullptr, 0);
+}
+
+/**
+ * @brief Recover the database the way SimpleDB does on restart: the
+ * recovering transaction gets an id that the log does not use
+ * @param db the database to recover
+ */
+inline void Restart(SimpleDB& db) {
+  auto& log_manager = db.GetLogManager();
+  Transaction::ReserveTxnIds(RecoveryManager::MaxTxnId(log_manager));
+  Transaction txn{db.GetFileManager(), log_manager, db.GetBufferManager()};
+  txn.Recover();
+  txn.Commit();
+}
+}  // namespace simpledb
@@ -1,24 +1,51 @@
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include <span>  // NOLINT(build/include_order)
+#include <thread>  // NOLINT(build/c++11)
 
 #include "file/page.h"
 #include "log/log_manager.h"
 #include "server/simpledb.h"
+#include "txn/transaction.h"
 #include "utils/logger.h"
 
 namespace simpledb {
 
+void PrintLogRecord(std::span<char> record) {
+  Page page{record.data(), record.size()};
+  std::string s{page.GetString(0)};
+  int npos = Page::StringLength(s);
+  int val = page.GetInt(npos);
+  std::cout << "[" << s << ", " << val << "]";
+}
+
 void PrintLogRecords(LogManager& log_manager, std::string_view msg) {
   std::cout << msg << '\n';
   auto iter = log_manager.Iterator();
 
   while (iter.HasNext()) {
     auto record = iter.Next();
-    Page page{record.data(), record.size()};
-    std::string s{page.GetString(0)};
-    int npos = Page::StringLength(s);
-    int val = page.GetInt(npos);
-    std::cout << "[" << s << ", " << val << "]\n";
+    std::cout << iter.CurrentLsn() << ": ";
+    PrintLogRecord(record);
+    std::cout << '\n';
+  }
+  std::cout << '\n';
+}
+
+void PrintLogRecordsForward(LogManager& log_manager, std::string_view msg,
+                            Lsn start_lsn = INVALID_LSN) {
+  std::cout << msg << '\n';
+  auto iter = log_manager.ForwardIterator(start_lsn);
+
+  while (iter.HasNext()) {
+    auto record = iter.Next();
+    std::cout << iter.CurrentLsn() << ": ";
+    PrintLogRecord(record);
+    std::cout << '\n';
   }
   std::cout << '\n';
 }
@@ -35,15 +62,28 @@ std::vector<char> CreateLogRecord(std::string_view str, int num) {
   return record;
 }
 
-void CreateRecords(LogManager& log_manager, int start, int end) {
+std::vector<Lsn> CreateRecords(LogManager& log_manager, int start, int end) {
   std::cout << "Creating records: ";
-  auto iter = log_manager.Iterator();
+  std::vector<Lsn> lsns;
   for (int i = start; i <= end; i++) {
     auto record = CreateLogRecord("record" + std::to_string(i), i + 100);
-    int lsn = log_manager.Append(std::span{record.data(), record.size()});
+    Lsn lsn = log_manager.Append(std::span{record.data(), record.size()});
+    lsns.push_back(lsn);
     std::cout << lsn << " ";
   }
   std::cout << '\n';
+  return lsns;
+}
+
+void ReadRecordsAt(LogManager& log_manager, const std::vector<Lsn>& lsns) {
+  std::cout << "Reading records by LSN:\n";
+  for (auto lsn : lsns) {
+    auto record = log_manager.ReadAt(lsn);
+    std::cout << lsn << ": ";
+    PrintLogRecord(std::span{record.data(), record.size()});
+    std::cout << '\n';
+  }
+  std::cout << '\n';
 }
 
 void LogTest() {
@@ -52,16 +92,122 @@ void LogTest() {
 
   PrintLogRecords(log_manager, "The initial empty log file:");
   std::cout << "done\n";
-  CreateRecords(log_manager, 1, 35);
+  auto lsns = CreateRecords(log_manager, 1, 35);
   PrintLogRecords(log_manager, "The log file now has these records:");
-  CreateRecords(log_manager, 36, 70);
-  log_manager.Flush(65);
+  auto more_lsns = CreateRecords(log_manager, 36, 70);
+  log_manager.Flush(more_lsns[29]);
   PrintLogRecords(log_manager, "The log file now has these records:");
+  // Both flushed and still-buffered records are reachable by their LSN
+  ReadRecordsAt(log_manager, {lsns[0], lsns[17], more_lsns[0], more_lsns[34]});
+}
+
+void SegmentTest() {
+  FileManager file_manager{"log_segment_test", 400};
+  // Use tiny segments of 2 blocks so that the log spans several segment files
+  LogManager log_manager{file_manager, "segment.log", 2};
+
+  auto lsns = CreateRecords(log_manager, 1, 70);
+  std::cout << "Segment files: ";
+  for (const auto& filename : file_manager.FilesWithPrefix("segment.log.")) {
+    std::cout << filename << ' ';
+  }
+  std::cout << '\n';
+
+  log_manager.Truncate(lsns[50]);
+  std::cout << "Segment files after truncating before LSN " << lsns[50]
+            << ": ";
+  for (const auto& filename : file_manager.FilesWithPrefix("segment.log.")) {
+    std::cout << filename << ' ';
+  }
+  std::cout << '\n';
+  PrintLogRecords(log_manager, "The live tail of the log has these records:");
+  PrintLogRecordsForward(log_manager, "The same records in log order:");
+  PrintLogRecordsForward(log_manager, "The records from the 60th one on:",
+                         lsns[59]);
+  ReadRecordsAt(log_manager, {lsns[50], lsns[69]});
+}
+
+void TruncateRaceTest() {
+  FileManager file_manager{"log_truncate_test", 400};
+  constexpr int segment_blocks = 2;
+  LogManager log_manager{file_manager, "truncate.log", segment_blocks};
+  auto lsns = CreateRecords(log_manager, 1, 200);
+  log_manager.Flush(lsns.back());
+
+  // A reader keeps reading old records while the log is truncated under it
+  std::atomic<bool> done{false};
+  std::thread reader([&] {
+    while (!done) {
+      for (auto lsn : lsns) {
+        try {
+          log_manager.ReadAt(lsn);
+        } catch (const std::runtime_error&) {
+          // The record has been truncated
+        }
+      }
+    }
+  });
+  for (int i = 10; i < 200; i += 10) {
+    log_manager.Truncate(lsns[i]);
+  }
+  done = true;
+  reader.join();
+
+  int64_t first_segment = lsns[190] / (segment_blocks * 400);
+  int recreated = 0;
+  std::string prefix = "truncate.log.";
+  for (const auto& filename : file_manager.FilesWithPrefix(prefix)) {
+    if (std::stoll(filename.substr(prefix.size())) < first_segment) {
+      recreated++;
+    }
+  }
+  std::cout << "Segments recreated below the truncation point: " << recreated
+            << '\n';
+}
+
+void FlushLaterTest() {
+  using namespace std::chrono_literals;  // NOLINT(build/namespaces)
+  SimpleDB db{"log_flush_test", 400, 8};
+  LogManager& log_manager = db.GetLogManager();
+  log_manager.SetFlushInterval(50ms);
+  auto record = CreateLogRecord("async", 1);
+  Lsn lsn = log_manager.Append(std::span{record.data(), record.size()});
+  log_manager.FlushLater(lsn);
+  std::cout << "Durable right after FlushLater: "
+            << (log_manager.DurableLsn() >= lsn ? "yes" : "no") << '\n';
+  std::this_thread::sleep_for(200ms);
+  std::cout << "Durable after the flush interval: "
+            << (log_manager.DurableLsn() >= lsn ? "yes" : "no") << '\n';
+
+  // Compare the commit latency of the NO_FORCE and ASYNC policies
+  constexpr int NUM_TXNS = 200;
+  log_manager.SetFlushInterval(LogManager::DEFAULT_FLUSH_INTERVAL);
+  BlockId block{"test_file", 0};
+  for (auto policy : {CommitPolicy::NO_FORCE, CommitPolicy::ASYNC}) {
+    db.SetCommitPolicy(policy);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < NUM_TXNS; i++) {
+      auto txn = db.NewTxn();
+      txn.Pin(block);
+      txn.SetInt(block, 0, i, true);
+      txn.Commit();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << NUM_TXNS << " "
+              << (policy == CommitPolicy::ASYNC ? "ASYNC" : "NO_FORCE")
+              << " commits took "
+              << std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+                     .count()
+              << "us\n";
+  }
 }
 }  // namespace simpledb
 
 int main() {
   simpledb::LogTest();
+  simpledb::SegmentTest();
+  simpledb::TruncateRaceTest();
+  simpledb::FlushLaterTest();
 
   return 0;
 }
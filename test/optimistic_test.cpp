@@ -0,0 +1,235 @@
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "record/layout.h"
+#include "record/rid.h"
+#include "record/schema.h"
+#include "record/table_scan.h"
+#include "server/simpledb.h"
+#include "txn/concurrency/lock_table.h"
+#include "txn/transaction.h"
+
+namespace simpledb {
+constexpr std::string_view TABLE = "counter_table";
+constexpr int NUM_RECORDS = 200;
+constexpr int NUM_THREADS = 4;
+constexpr int TXNS_PER_THREAD = 100;
+
+// The table may be left over from an earlier run
+std::vector<RID> LoadCounters(SimpleDB& db, Layout& layout) {
+  auto txn = db.NewTxn();
+  TableScan scan{txn, TABLE, layout};
+  std::vector<RID> rids;
+  while (scan.Next()) {
+    rids.push_back(scan.GetRID());
+  }
+  while (static_cast<int>(rids.size()) < NUM_RECORDS) {
+    scan.Insert();
+    scan.SetInt("a", 0);
+    rids.push_back(scan.GetRID());
+  }
+  scan.Close();
+  txn.Commit();
+  return rids;
+}
+
+int ReadCounter(Transaction& txn, Layout& layout, const RID& rid) {
+  TableScan scan{txn, TABLE, layout};
+  scan.MoveToRID(rid);
+  int val = scan.GetInt("a");
+  scan.Close();
+  return val;
+}
+
+void AddToCounter(Transaction& txn, Layout& layout, const RID& rid) {
+  TableScan scan{txn, TABLE, layout};
+  scan.MoveToRID(rid);
+  scan.SetInt("a", scan.GetInt("a") + 1);
+  scan.Close();
+}
+
+int SumCounters(SimpleDB& db, Layout& layout) {
+  auto txn = db.NewTxn();
+  TableScan scan{txn, TABLE, layout};
+  int sum = 0;
+  while (scan.Next()) {
+    sum += scan.GetInt("a");
+  }
+  scan.Close();
+  txn.Commit();
+  return sum;
+}
+
+void ValidationTest(SimpleDB& db, Layout& layout,
+                    const std::vector<RID>& rids) {
+  std::cout << "Optimistic validation\n";
+  auto reader = db.NewOptimisticTxn();
+  auto writer = db.NewOptimisticTxn();
+  ReadCounter(reader, layout, rids[0]);
+  AddToCounter(reader, layout, rids[1]);
+  // The writer changes what the reader read and commits first
+  AddToCounter(writer, layout, rids[0]);
+  writer.Commit();
+  try {
+    reader.Commit();
+    std::cout << "Reader: commit (unexpected)\n";
+  } catch (const LockAbortException&) {
+    std::cout << "Reader: validation failed\n";
+    reader.Rollback();
+  }
+
+  auto txn1 = db.NewOptimisticTxn();
+  auto txn2 = db.NewOptimisticTxn();
+  AddToCounter(txn1, layout, rids[0]);
+  // Writers of different records do not conflict
+  AddToCounter(txn2, layout, rids[1]);
+  try {
+    AddToCounter(txn2, layout, rids[0]);
+    std::cout << "Transaction 2: write record 0 (unexpected)\n";
+  } catch (const LockAbortException&) {
+    std::cout << "Transaction 2: record 0 is being written, abort\n";
+    txn2.Rollback();
+  }
+  txn1.Commit();
+}
+
+// An optimistic writer locks what it changes, so a locking reader waits for
+// it instead of reading a change that is then rolled back. An optimistic
+// reader aborts instead of reading what a locking writer changes.
+void MixedTest(SimpleDB& db, Layout& layout, const std::vector<RID>& rids) {
+  std::cout << "Optimistic and locking transactions\n";
+  auto setup = db.NewTxn();
+  int before = ReadCounter(setup, layout, rids[2]);
+  setup.Commit();
+  auto writer = db.NewOptimisticTxn();
+  AddToCounter(writer, layout, rids[2]);
+  std::thread reader([&db, &layout, &rids, before] {
+    auto txn = db.NewTxn();
+    int val = ReadCounter(txn, layout, rids[2]);
+    txn.Commit();
+    std::cout << "Locking reader: "
+              << (val == before ? "reads the committed value"
+                                : "reads an uncommitted value")
+              << '\n';
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  std::cout << "Optimistic writer: rollback\n";
+  writer.Rollback();
+  reader.join();
+
+  auto locker = db.NewTxn();
+  AddToCounter(locker, layout, rids[2]);
+  auto optimistic_reader = db.NewOptimisticTxn();
+  try {
+    ReadCounter(optimistic_reader, layout, rids[2]);
+    std::cout << "Optimistic reader: read record 2 (unexpected)\n";
+    optimistic_reader.Commit();
+  } catch (const LockAbortException&) {
+    std::cout << "Optimistic reader: record 2 is locked, abort\n";
+    optimistic_reader.Rollback();
+  }
+  locker.Rollback();
+}
+
+// Each transaction increments two of the first `hot` counters, and is
+// retried until it commits. Return the number of aborts.
+int RunCounters(SimpleDB& db, Layout& layout, const std::vector<RID>& rids,
+                int hot, bool optimistic, int seed) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> pick(0, hot - 1);
+  int aborts = 0;
+  for (int i = 0; i < TXNS_PER_THREAD; i++) {
+    int first = pick(rng);
+    int second = pick(rng);
+    while (second == first) {
+      second = pick(rng);
+    }
+    while (true) {
+      auto txn = optimistic ? db.NewOptimisticTxn() : db.NewTxn();
+      try {
+        AddToCounter(txn, layout, rids[first]);
+        AddToCounter(txn, layout, rids[second]);
+        txn.Commit();
+        break;
+      } catch (const LockAbortException&) {
+        txn.Rollback();
+        aborts++;
+      }
+    }
+  }
+  return aborts;
+}
+
+void ContentionSweep(SimpleDB& db, Layout& layout,
+                     const std::vector<RID>& rids) {
+  struct Result {
+    int hot;
+    bool optimistic;
+    int64_t micros;
+    int aborts;
+    bool correct;
+  };
+  std::vector<Result> results;
+  for (int hot : {NUM_RECORDS, 50, 10, 2}) {
+    for (bool optimistic : {false, true}) {
+      int before = SumCounters(db, layout);
+      std::vector<int> aborts(NUM_THREADS);
+      std::vector<std::thread> threads;
+      auto start = std::chrono::steady_clock::now();
+      for (int t = 0; t < NUM_THREADS; t++) {
+        threads.emplace_back([&, t] {
+          aborts[t] = RunCounters(db, layout, rids, hot, optimistic, t);
+        });
+      }
+      for (auto& thread : threads) {
+        thread.join();
+      }
+      auto elapsed = std::chrono::steady_clock::now() - start;
+      int total_aborts = 0;
+      for (int count : aborts) {
+        total_aborts += count;
+      }
+      // Every committed transaction added 2, and no update was lost
+      bool correct = SumCounters(db, layout) - before ==
+                     2 * NUM_THREADS * TXNS_PER_THREAD;
+      results.push_back(Result{
+          hot, optimistic,
+          std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+              .count(),
+          total_aborts, correct});
+    }
+  }
+
+  std::cout << "Contention sweep: " << NUM_THREADS << " threads, "
+            << NUM_THREADS * TXNS_PER_THREAD
+            << " transactions incrementing 2 counters each\n";
+  for (const auto& result : results) {
+    std::cout << "hot counters " << result.hot << ", "
+              << (result.optimistic ? "OCC" : "2PL") << ": "
+              << result.micros << "us, "
+              << NUM_THREADS * TXNS_PER_THREAD * 1000000LL / result.micros
+              << " commits/s, " << result.aborts << " aborts, "
+              << (result.correct ? "no lost updates" : "LOST UPDATES")
+              << '\n';
+  }
+}
+}  // namespace simpledb
+
+int main() {
+  simpledb::SimpleDB db{"optimistic_test", 400, 16};
+  db.SetCommitPolicy(simpledb::CommitPolicy::NO_FORCE);
+  simpledb::Schema schema;
+  schema.AddIntField("a");
+  simpledb::Layout layout{schema};
+  auto rids = simpledb::LoadCounters(db, layout);
+  simpledb::ValidationTest(db, layout, rids);
+  simpledb::MixedTest(db, layout, rids);
+  simpledb::ContentionSweep(db, layout, rids);
+
+  return 0;
+}
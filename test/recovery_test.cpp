@@ -1,10 +1,25 @@
+#include <filesystem>
 #include <iostream>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
 
+#include "buffer/buffer.h"
 #include "buffer/buffer_manager.h"
+#include "crash_util.h"
 #include "file/block_id.h"
 #include "file/file_manager.h"
+#include "file/page.h"
+#include "log/log_manager.h"
+#include "record/layout.h"
+#include "record/record_page.h"
+#include "record/schema.h"
 #include "server/simpledb.h"
+#include "txn/concurrency/lock_table.h"
+#include "txn/recovery/checkpoint_record.h"
+#include "txn/recovery/log_record_view.h"
+#include "txn/recovery/recovery_manager.h"
 #include "txn/transaction.h"
 
 namespace simpledb {
@@ -18,7 +33,8 @@ class RecoveryTest {
         file_manager_(db_.GetFileManager()),
         buffer_manager_(db_.GetBufferManager()),
         block0_(filename, 0),
-        block1_(filename, 1) {}
+        block1_(filename, 1),
+        block2_(filename, 2) {}
 
   void Execute() {
     if (file_manager_.Length(test_file_) == 0) {
@@ -65,36 +81,54 @@ class RecoveryTest {
 
     txn3.SetString(block0_, 30, "uvw", true);
     txn4.SetString(block1_, 30, "xyz", true);
-    buffer_manager_.FlushAll(3);
-    buffer_manager_.FlushAll(4);
+    buffer_manager_.FlushAll();
     PrintValues("After modification:");
 
     txn3.Rollback();
     PrintValues("After rollback:");
     // txn4 stops here without committing or rolling back,
     // so all its changes should be undone during recovery
+
+    // txn5 commits without forcing its page, so its change is only in the log
+    // and must be redone during recovery. Its commit also writes a fuzzy
+    // checkpoint while txn4 is still active and block2 is dirty.
+    db_.GetLogManager().SetCheckpointInterval(0);
+    Transaction txn5{file_manager_, db_.GetLogManager(), buffer_manager_,
+                     CommitPolicy::NO_FORCE};
+    txn5.Pin(block2_);
+    txn5.SetInt(block2_, 0, 555, true);
+    txn5.Commit();
+    PrintValues("After no-force commit:");
   }
 
   void Recover() {
+    // Replay the data pages on two threads
+    RecoveryManager::SetRedoThreads(2);
+    Transaction::ReserveTxnIds(RecoveryManager::MaxTxnId(db_.GetLogManager()));
     Transaction txn{file_manager_, db_.GetLogManager(), buffer_manager_};
     txn.Recover();
     PrintValues("After recovery:");
   }
 
-  // Print the values that made it to disk
+  // Print the values that made it to disk. Transactions address a block's
+  // bytes after its header.
   void PrintValues(std::string_view msg) {
     std::cout << msg << '\n';
     Page page0{file_manager_.BlockSize()};
     Page page1{file_manager_.BlockSize()};
+    Page page2{file_manager_.BlockSize()};
     file_manager_.Read(block0_, page0);
     file_manager_.Read(block1_, page1);
+    file_manager_.Read(block2_, page2);
 
-    int pos = 0;
+    int pos = Buffer::HEADER_SIZE;
     for (int i = 0; i < 6; i++) {
       std::cout << page0.GetInt(pos) << ' ' << page1.GetInt(pos) << ' ';
       pos += sizeof(int);
     }
-    std::cout << page0.GetString(30) << ' ' << page1.GetString(30) << '\n';
+    std::cout << page0.GetString(Buffer::HEADER_SIZE + 30) << ' '
+              << page1.GetString(Buffer::HEADER_SIZE + 30) << ' '
+              << page2.GetInt(Buffer::HEADER_SIZE) << '\n';
   }
 
   SimpleDB db_;
@@ -102,11 +136,344 @@ class RecoveryTest {
   std::string test_file_;
   FileManager& file_manager_;
   BufferManager& buffer_manager_;
-  BlockId block0_, block1_;
+  BlockId block0_, block1_, block2_;
 };
+
+// Print the integers at the specified offsets of a block
+void PrintInts(SimpleDB& db, const BlockId& block, int count,
+               std::string_view msg) {
+  auto txn = db.NewTxn();
+  txn.Pin(block);
+  std::cout << msg;
+  for (int i = 0; i < count; i++) {
+    std::cout << ' ' << txn.GetInt(block, i * sizeof(int));
+  }
+  std::cout << '\n';
+  txn.Commit();
+}
+
+// Print the records of a record page
+void PrintRows(SimpleDB& db, const BlockId& block, Layout& layout,
+               std::string_view msg) {
+  auto txn = db.NewTxn();
+  txn.Pin(block);
+  RecordPage record_page{txn, block, layout};
+  std::cout << msg;
+  for (int slot = record_page.NextAfter(-1); slot >= 0;
+       slot = record_page.NextAfter(slot)) {
+    std::cout << " {" << record_page.GetInt(slot, "A") << ", "
+              << record_page.GetString(slot, "B") << '}';
+  }
+  std::cout << '\n';
+  txn.Unpin(block);
+  txn.Commit();
+}
+
+// Insert, delete, and update rows of a record page, each logged as one row
+// record
+void ChangeRows(Transaction& txn, const BlockId& block, Layout& layout) {
+  txn.Pin(block);
+  RecordPage record_page{txn, block, layout};
+  record_page.InsertAfter(-1, {"A", "B"}, {Constant{4}, Constant{"four"}});
+  record_page.Delete(0);
+  record_page.Update(1, {"A", "B"}, {Constant{20}, Constant{"twenty"}});
+  txn.Unpin(block);
+}
+
+// The row records of a rolled back transaction and of a crashed one are
+// undone: the inserted row disappears, and the deleted and updated rows get
+// their old values back
+void RowOpsTest() {
+  std::string_view dirname = "recovery_row_test";
+  BlockId block{"row_file", 0};
+  Schema schema;
+  schema.AddIntField("A");
+  schema.AddStringField("B", 9);
+  Layout layout{std::move(schema)};
+  std::filesystem::remove_all(dirname);
+  RunUntilCrash([&] {
+    SimpleDB db{dirname, 400, 8};
+    auto txn1 = db.NewTxn();
+    txn1.Append(block.Filename());
+    txn1.Pin(block);
+    RecordPage record_page{txn1, block, layout};
+    record_page.Format();
+    record_page.InsertAfter(-1, {"A", "B"}, {Constant{1}, Constant{"one"}});
+    record_page.InsertAfter(0, {"A", "B"}, {Constant{2}, Constant{"two"}});
+    record_page.InsertAfter(1, {"A", "B"}, {Constant{3}, Constant{"three"}});
+    txn1.Unpin(block);
+    txn1.Commit();
+
+    auto txn2 = db.NewTxn();
+    ChangeRows(txn2, block, layout);
+    txn2.Rollback();
+    PrintRows(db, block, layout, "After rollback:");
+
+    auto txn3 = db.NewTxn();
+    ChangeRows(txn3, block, layout);
+    db.GetBufferManager().FlushAll();
+    std::cout << "Crash after changing the rows\n";
+  });
+  SimpleDB db{dirname, 400, 8};
+  Restart(db);
+  PrintRows(db, block, layout, "After restart:");
+}
+
+// A slot too wide for its row record to fit in a log block is logged as
+// several row records, each holding a fixed-size piece of the old and new
+// images, and still rolls back
+void WideRowTest() {
+  SimpleDB db{"recovery_wide_row_test", 400, 8};
+  Schema schema;
+  schema.AddIntField("A");
+  schema.AddStringField("B", 340);
+  Layout layout{std::move(schema)};
+  std::string filename = "wide_row_file";
+  std::string wide(340, 'x');
+
+  auto txn1 = db.NewTxn();
+  BlockId block0 = txn1.Append(filename);
+  txn1.Pin(block0);
+  RecordPage page0{txn1, block0, layout};
+  page0.Format();
+  page0.InsertAfter(-1, {"A", "B"}, {Constant{1}, Constant{wide}});
+  txn1.Unpin(block0);
+  txn1.Commit();
+
+  auto txn2 = db.NewTxn();
+  txn2.Pin(block0);
+  RecordPage update_page{txn2, block0, layout};
+  update_page.Update(0, {"A", "B"},
+                     {Constant{2}, Constant{std::string(340, 'y')}});
+  txn2.Unpin(block0);
+  BlockId block1 = txn2.Append(filename);
+  txn2.Pin(block1);
+  RecordPage insert_page{txn2, block1, layout};
+  insert_page.Format();
+  insert_page.InsertAfter(-1, {"A", "B"}, {Constant{3}, Constant{wide}});
+  txn2.Unpin(block1);
+  txn2.Rollback();
+
+  auto txn3 = db.NewTxn();
+  int rows = 0;
+  bool intact = true;
+  for (const auto& block : {block0, block1}) {
+    txn3.Pin(block);
+    RecordPage record_page{txn3, block, layout};
+    for (int slot = record_page.NextAfter(-1); slot >= 0;
+         slot = record_page.NextAfter(slot)) {
+      rows++;
+      intact = intact && record_page.GetInt(slot, "A") == 1 &&
+               record_page.GetString(slot, "B") == wide;
+    }
+    txn3.Unpin(block);
+  }
+  txn3.Commit();
+  std::cout << "Wide rows after rollback: " << rows
+            << (intact ? " (unchanged)\n" : " (changed)\n");
+}
+
+// Print the integer at the start of a block as it is on disk
+void PrintDiskInt(SimpleDB& db, const BlockId& block, std::string_view msg) {
+  Page page{db.GetFileManager().BlockSize()};
+  db.GetFileManager().Read(block, page);
+  std::cout << msg << ' ' << page.GetInt(Buffer::HEADER_SIZE) << '\n';
+}
+
+// Leave a committed change that is only in the log, and a change of an
+// unfinished transaction that reached the disk
+void CrashWithLoser(SimpleDB& db, const BlockId& committed,
+                    const BlockId& loser) {
+  auto txn1 = db.NewTxn();
+  txn1.Pin(loser);
+  txn1.SetInt(loser, 0, 99, true);
+  db.GetBufferManager().FlushAll();
+  Transaction txn2{db.GetFileManager(), db.GetLogManager(),
+                   db.GetBufferManager(), CommitPolicy::NO_FORCE};
+  txn2.Pin(committed);
+  txn2.SetInt(committed, 0, 7, true);
+  txn2.Commit();
+  std::cout << "Crash with a committed page not on disk and a loser page on "
+               "disk\n";
+}
+
+// An on-demand restart only analyzes the log. A committed block is redone
+// when a transaction first reads it, and a block of a loser stays locked until
+// the rest of the recovery undoes it. Snapshot transactions, which take no
+// locks, wait for it too, and optimistic ones abort.
+void OnDemandTest() {
+  std::string_view dirname = "recovery_on_demand_test";
+  BlockId committed{"on_demand_file", 0};
+  BlockId loser{"on_demand_file", 1};
+  std::filesystem::remove_all(dirname);
+  RunUntilCrash([&] {
+    SimpleDB db{dirname, 400, 8};
+    CrashWithLoser(db, committed, loser);
+  });
+  SimpleDB db{dirname, 400, 8};
+  auto& log_manager = db.GetLogManager();
+  auto& buffer_manager = db.GetBufferManager();
+  Transaction::ReserveTxnIds(RecoveryManager::MaxTxnId(log_manager));
+  Transaction recovery_txn{db.GetFileManager(), log_manager, buffer_manager};
+  recovery_txn.RecoverOnDemand();
+  PrintDiskInt(db, committed, "Committed value on disk after analysis:");
+  PrintInts(db, committed, 1, "Committed value on first read:");
+
+  PrintDiskInt(db, loser, "Loser value on disk after analysis:");
+  auto optimistic = db.NewOptimisticTxn();
+  optimistic.Pin(loser);
+  try {
+    optimistic.GetInt(loser, 0);
+    std::cout << "Optimistic read of the loser block (unexpected)\n";
+  } catch (const LockAbortException&) {
+    std::cout << "Optimistic read of the loser block before its recovery: "
+                 "aborted\n";
+  }
+  optimistic.Rollback();
+  Transaction::SetMultiVersion(true);
+  std::thread reader{[&db, &loser] {
+    auto snapshot = db.NewSnapshotTxn();
+    snapshot.Pin(loser);
+    std::cout << "Loser value read by a snapshot: "
+              << snapshot.GetInt(loser, 0) << '\n';
+    snapshot.Commit();
+    PrintInts(db, loser, 1, "Loser value once its recovery completes:");
+  }};
+  recovery_txn.CompleteRecovery();
+  recovery_txn.Commit();
+  reader.join();
+  Transaction::SetMultiVersion(false);
+}
+
+// The same restart as SimpleDB runs it: the constructor returns once the log
+// is analyzed, and a background thread completes the recovery
+void OnDemandRestartTest() {
+  std::string_view dirname = "recovery_on_demand_restart_test";
+  BlockId committed{"restart_file", 0};
+  BlockId loser{"restart_file", 1};
+  std::filesystem::remove_all(dirname);
+  RunUntilCrash([&] {
+    SimpleDB db{dirname};
+    CrashWithLoser(db, committed, loser);
+  });
+  RecoveryManager::SetOnDemandRecovery(true);
+  SimpleDB db{dirname};
+  RecoveryManager::SetOnDemandRecovery(false);
+  PrintInts(db, committed, 1, "Committed value after an on-demand restart:");
+  PrintInts(db, loser, 1, "Loser value after an on-demand restart:");
+  db.WaitForRecovery();
+  std::cout << "Background recovery completed\n";
+}
+
+// Transaction ids restart at 1 in each run. The first transaction of the
+// crashed run is left unfinished, and the restart must still undo it.
+void FirstTxnTest() {
+  std::string_view dirname = "recovery_first_txn_test";
+  BlockId block{"first_txn_file", 0};
+  std::filesystem::remove_all(dirname);
+  RunUntilCrash([&] {
+    SimpleDB db{dirname, 400, 8};
+    // The first transaction of the process gets id 1
+    auto txn = db.NewTxn();
+    txn.Pin(block);
+    txn.SetInt(block, 0, 1, true);
+    db.GetBufferManager().FlushAll();
+    std::cout << "Transaction 1 crashes after writing 1 to disk\n";
+  });
+  SimpleDB db{dirname, 400, 8};
+  Restart(db);
+  PrintInts(db, block, 1, "After restart:");
+}
+
+// A crash in the middle of a rollback leaves compensation records for the
+// updates already undone. The restart undoes only the others, so each update
+// is compensated exactly once.
+void RollbackCrashTest() {
+  std::string_view dirname = "recovery_rollback_test";
+  std::string_view filename = "rollback_file";
+  BlockId block{filename, 0};
+  constexpr int num_updates = 3;
+  std::filesystem::remove_all(dirname);
+  RunUntilCrash([&] {
+    SimpleDB db{dirname, 400, 8};
+    auto& log_manager = db.GetLogManager();
+    auto txn = db.NewTxn();
+    txn.Pin(block);
+    for (int i = 0; i < num_updates; i++) {
+      txn.SetInt(block, i * sizeof(int), i + 1, true);
+    }
+    // Roll back the last update as Rollback would, then crash
+    Lsn last_lsn = log_manager.LatestLsn();
+    auto bytes = log_manager.ReadAt(last_lsn);
+    auto record = LogRecordView::Decode(bytes);
+    Lsn clr_lsn = record.Undo(log_manager, db.GetBufferManager(),
+                              record.txn_id, last_lsn);
+    log_manager.Flush(clr_lsn);
+    db.GetBufferManager().FlushAll();
+    std::cout << "Crash after undoing 1 of " << num_updates << " updates\n";
+  });
+  SimpleDB db{dirname, 400, 8};
+  auto& log_manager = db.GetLogManager();
+  Restart(db);
+  PrintInts(db, block, num_updates, "After restart:");
+  int compensations = 0;
+  auto iter = log_manager.Iterator();
+  while (iter.HasNext()) {
+    auto bytes = iter.Next();
+    auto record = LogRecordView::Decode(bytes);
+    if (record.op == LogType::COMPENSATION && record.filename == filename) {
+      compensations++;
+    }
+  }
+  std::cout << "Compensation records for " << num_updates
+            << " updates: " << compensations << '\n';
+}
+
+// A checkpoint whose active transaction table does not fit in a log block is
+// split over several records, and recovery reads every part of it
+void SplitCheckpointTest() {
+  std::string_view dirname = "recovery_checkpoint_test";
+  std::filesystem::remove_all(dirname);
+  SimpleDB db{dirname, 400, 8};
+  auto& log_manager = db.GetLogManager();
+  BlockId block{"checkpoint_file", 0};
+  auto txn = db.NewTxn();
+  txn.Pin(block);
+  txn.SetInt(block, 0, 1, true);
+  txn.Commit();
+
+  // Fake transactions that started at the last record. The largest id goes
+  // into the first part, which recovery reads last.
+  constexpr int num_txns = 100;
+  std::vector<std::pair<int, Lsn>> active_txns;
+  for (int i = 0; i < num_txns; i++) {
+    active_txns.emplace_back(1000 + num_txns - 1 - i, log_manager.LatestLsn());
+  }
+  CheckpointRecord::WriteToLog(log_manager, log_manager.LatestLsn(),
+                               active_txns, {});
+  int parts = 0;
+  auto iter = log_manager.Iterator();
+  while (iter.HasNext()) {
+    auto bytes = iter.Next();
+    if (LogRecordView::Decode(bytes).op == LogType::CHECKPOINT) {
+      parts++;
+    }
+  }
+  std::cout << "Checkpoint records for " << num_txns
+            << " active transactions: " << parts << '\n';
+  std::cout << "Largest transaction id after the checkpoint: "
+            << RecoveryManager::MaxTxnId(log_manager) << '\n';
+}
 }  // namespace simpledb
 
 int main() {
+  simpledb::FirstTxnTest();
+  simpledb::RollbackCrashTest();
+  simpledb::RowOpsTest();
+  simpledb::WideRowTest();
+  simpledb::OnDemandTest();
+  simpledb::OnDemandRestartTest();
+  simpledb::SplitCheckpointTest();
   simpledb::RecoveryTest recovery_test{"recovery_test", "test_file"};
   recovery_test.Execute();
 }
@@ -1,11 +1,15 @@
 #include "record/table_scan.h"
 
+#include <atomic>
 #include <iostream>
+#include <latch>  // NOLINT(build/include_order)
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 
 #include "record/layout.h"
 #include "record/schema.h"
 #include "server/simpledb.h"
+#include "txn/concurrency/lock_table.h"
 #include "txn/transaction.h"
 
 namespace simpledb {
@@ -61,10 +65,65 @@ void TableScanTest() {
   ts.Close();
   txn.Commit();
 }
+
+// Two transactions scan one table and update different rows. Their scans lock
+// records rather than the table, so neither write waits for the other scan.
+void ConcurrentUpdateTest() {
+  SimpleDB db{"table_test", 400, 8};
+  Schema schema;
+  schema.AddIntField("A");
+  schema.AddStringField("B", 9);
+  Layout layout{std::move(schema)};
+
+  auto txn = db.NewTxn();
+  TableScan ts{txn, "U", layout};
+  for (int i = 0; i < 2; i++) {
+    ts.InsertRow({"A", "B"}, {Constant{i}, Constant{"old"}});
+  }
+  ts.Close();
+  txn.Commit();
+
+  std::latch scanning{2};
+  std::atomic<int> committed{0};
+  auto update = [&db, &layout, &scanning, &committed](int key) {
+    auto txn = db.NewTxn();
+    try {
+      TableScan ts{txn, "U", layout};
+      bool found = ts.Next();
+      // Both scans are open before either one writes
+      scanning.arrive_and_wait();
+      for (; found; found = ts.Next()) {
+        if (ts.GetInt("A") == key) {
+          ts.SetString("B", "new");
+        }
+      }
+      ts.Close();
+      txn.Commit();
+      committed++;
+    } catch (const LockAbortException&) {
+      txn.Rollback();
+    }
+  };
+  std::thread t1(update, 0);
+  std::thread t2(update, 1);
+  t1.join();
+  t2.join();
+  std::cout << "Updaters committed: " << committed << '\n';
+
+  auto check_txn = db.NewTxn();
+  TableScan check{check_txn, "U", layout};
+  while (check.Next()) {
+    std::cout << '{' << check.GetInt("A") << ", " << check.GetString("B")
+              << "}\n";
+  }
+  check.Close();
+  check_txn.Commit();
+}
 }  // namespace simpledb
 
 int main() {
   simpledb::TableScanTest();
+  simpledb::ConcurrentUpdateTest();
 
   return 0;
 }
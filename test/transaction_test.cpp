@@ -1,9 +1,12 @@
 #include "txn/transaction.h"
 
 #include <iostream>
+#include <stdexcept>
 #include <string>
 
+#include "buffer/buffer.h"
 #include "file/block_id.h"
+#include "file/page.h"
 #include "server/simpledb.h"
 
 namespace simpledb {
@@ -48,10 +51,85 @@ void TransactionTest() {
   std::cout << "post-rollback at location 80 = " << txn4.GetInt(block, 80) << '\n';
   txn4.Commit();
 }
+
+void LazyStartTest() {
+  SimpleDB db{"txn_test", 400, 8};
+  auto& log_manager = db.GetLogManager();
+  BlockId block{"test_file", 1};
+  Lsn before = log_manager.LatestLsn();
+  // A transaction that changes nothing logs nothing, not even its start
+  auto reader = db.NewTxn();
+  reader.Pin(block);
+  reader.GetInt(block, 80);
+  reader.Commit();
+  std::cout << "Log written by a reader: "
+            << (log_manager.LatestLsn() == before ? "none" : "some") << '\n';
+
+  auto writer = db.NewTxn();
+  writer.Pin(block);
+  int ival = writer.GetInt(block, 80);
+  std::cout << "Log written before the first change: "
+            << (log_manager.LatestLsn() == before ? "none" : "some") << '\n';
+  writer.SetInt(block, 80, ival + 1, true);
+  std::cout << "Log written after the first change: "
+            << (log_manager.LatestLsn() == before ? "none" : "some") << '\n';
+  writer.Rollback();
+}
+
+void ReadOnlyTest() {
+  SimpleDB db{"txn_test", 400, 8};
+  auto& log_manager = db.GetLogManager();
+  BlockId block{"test_file", 1};
+  Lsn before = log_manager.LatestLsn();
+  auto reader = db.NewReadOnlyTxn();
+  reader.Pin(block);
+  int ival = reader.GetInt(block, 80);
+  try {
+    reader.SetInt(block, 80, ival + 1, true);
+    std::cout << "A read-only transaction wrote a value\n";
+  } catch (const std::runtime_error& e) {
+    std::cout << e.what() << '\n';
+  }
+  std::cout << "Value after the write attempt: "
+            << (reader.GetInt(block, 80) == ival ? "unchanged" : "changed")
+            << '\n';
+  reader.Commit();
+  std::cout << "Log written by the read-only transaction: "
+            << (log_manager.LatestLsn() == before ? "none" : "some") << '\n';
+}
+
+// Two transactions change different records of the same block. A FORCE
+// commit of the first one must write the block even though the second one
+// changed it last.
+void ForceTest() {
+  SimpleDB db{"txn_test", 400, 8};
+  auto& file_manager = db.GetFileManager();
+  BlockId block{"test_file", 2};
+  auto txn1 = db.NewTxn();
+  auto txn2 = db.NewTxn();
+  txn1.Pin(block);
+  txn2.Pin(block);
+  txn1.ExclusiveLockRecord(block, 0);
+  int val = txn1.GetInt(block, 0, false) + 1;
+  txn1.SetInt(block, 0, val, true, false);
+  txn2.ExclusiveLockRecord(block, 1);
+  txn2.SetInt(block, 4, 1, true, false);
+  txn1.Commit();
+  Page page{file_manager.BlockSize()};
+  file_manager.Read(block, page);
+  std::cout << "First writer's value on disk after its FORCE commit: "
+            << (page.GetInt(Buffer::HEADER_SIZE) == val ? "written"
+                                                        : "missing")
+            << '\n';
+  txn2.Rollback();
+}
 }  // namespace simpledb
 
 int main() {
   simpledb::TransactionTest();
+  simpledb::LazyStartTest();
+  simpledb::ReadOnlyTest();
+  simpledb::ForceTest();
 
   return 0;
 }